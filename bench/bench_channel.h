@@ -0,0 +1,71 @@
+/*
+    Copyright 2022 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    GNU General Public License Usage
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Commercial License Usage
+
+    Licensees holding valid commercial Tiny Protocol licenses may use this file in
+    accordance with the commercial license agreement provided in accordance with
+    the terms contained in a written agreement between you and Alexey Dynda.
+    For further information contact via email on github account.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <mutex>
+
+/**
+ * In-memory channel for benchmarks. It accepts only as many bytes as it has free space,
+ * and never blocks, like non-blocking serial port or socket.
+ */
+class Channel
+{
+public:
+    int write(const void *data, int len)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        int size = 0;
+        while ( size < len && m_count < (int)sizeof(m_buf) )
+        {
+            m_buf[(m_head + m_count) % sizeof(m_buf)] = static_cast<const uint8_t *>(data)[size++];
+            m_count++;
+        }
+        return size;
+    }
+
+    int read(void *data, int len)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        int size = 0;
+        while ( size < len && m_count )
+        {
+            static_cast<uint8_t *>(data)[size++] = m_buf[m_head];
+            m_head = (m_head + 1) % sizeof(m_buf);
+            m_count--;
+        }
+        return size;
+    }
+
+private:
+    std::mutex m_mutex;
+    uint8_t m_buf[16384];
+    int m_head = 0;
+    int m_count = 0;
+};
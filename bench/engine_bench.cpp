@@ -0,0 +1,211 @@
+/*
+    Copyright 2022 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    GNU General Public License Usage
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Commercial License Usage
+
+    Licensees holding valid commercial Tiny Protocol licenses may use this file in
+    accordance with the commercial license agreement provided in accordance with
+    the terms contained in a written agreement between you and Alexey Dynda.
+    For further information contact via email on github account.
+*/
+
+/**
+ * Engine benchmark compares C API of full duplex protocol (runtime parameters, I/O via
+ * function pointer callbacks) with tinyproto::FdEngine (parameters and transport fixed at compile time).
+ */
+
+#include "TinyFdEngine.h"
+#include "bench_channel.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+
+static const int MTU = 64;
+static const int WINDOW = 7;
+static const int FRAMES = 20000;
+
+struct ChannelTransport
+{
+    Channel *tx = nullptr;
+    Channel *rx = nullptr;
+    int rx_count = 0;
+
+    ChannelTransport() = default;
+
+    int read(void *buf, int len)
+    {
+        return rx->read(buf, len);
+    }
+
+    int write(const void *buf, int len)
+    {
+        return tx->write(buf, len);
+    }
+
+    void onReceive(uint8_t addr, uint8_t *data, int len)
+    {
+        rx_count++;
+    }
+
+    void onConnectEvent(uint8_t addr, bool connected)
+    {
+    }
+};
+
+using Engine = tinyproto::FdEngine<MTU, WINDOW, HDLC_CRC_16, ChannelTransport>;
+
+/** C path peer uses ChannelTransport only as a container for channels and counter */
+struct CPeer
+{
+    tiny_fd_handle_t handle = nullptr;
+    ChannelTransport transport;
+    uint8_t buffer[Engine::BUFFER_SIZE];
+};
+
+template <typename Send, typename Step, typename Received>
+static void measure(const char *name, Send send, Step step, Received received)
+{
+    uint8_t payload[MTU];
+    memset(payload, 0x7E, sizeof(payload));
+    int sent = 0;
+    auto start = std::chrono::steady_clock::now();
+    // Single thread and zero timeouts: the benchmark measures CPU cost of the protocol only
+    while ( received() < FRAMES && std::chrono::steady_clock::now() - start < std::chrono::seconds(20) )
+    {
+        if ( sent < FRAMES && send(payload, sizeof(payload)) == TINY_SUCCESS )
+        {
+            sent++;
+        }
+        step();
+    }
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    printf("%-8s %6d frames of %d bytes: %8.0f frames/s, %6.2f MB/s\n", name, received(), MTU,
+           us ? received() * 1000000.0 / us : 0.0, us ? static_cast<double>(received()) * MTU / us : 0.0);
+}
+
+static int cRead(void *udata, void *buf, int len)
+{
+    return static_cast<CPeer *>(udata)->transport.read(buf, len);
+}
+
+static int cWrite(void *udata, const void *buf, int len)
+{
+    return static_cast<CPeer *>(udata)->transport.write(buf, len);
+}
+
+/** The same as tiny_fd_run_tx(), but without waiting for tx data */
+static void cRunTx(CPeer &peer, write_block_cb_t write_func)
+{
+    uint8_t buf[TINY_FD_TX_BLOCK_SIZE];
+    for ( ;; )
+    {
+        int len = tiny_fd_get_tx_data(peer.handle, buf, sizeof(buf), 0);
+        if ( len <= 0 )
+        {
+            break;
+        }
+        uint8_t *ptr = buf;
+        while ( len )
+        {
+            int result = write_func(&peer, ptr, len);
+            len -= result;
+            ptr += result;
+        }
+        if ( ptr - buf < static_cast<int>(sizeof(buf)) )
+        {
+            break;
+        }
+    }
+}
+
+static void runC(Channel &ab, Channel &ba)
+{
+    CPeer peers[2];
+    peers[0].transport.tx = &ab;
+    peers[0].transport.rx = &ba;
+    peers[1].transport.tx = &ba;
+    peers[1].transport.rx = &ab;
+    for ( auto &peer : peers )
+    {
+        tiny_fd_init_t init{};
+        init.pdata = &peer;
+        init.on_read_cb = [](void *udata, uint8_t addr, uint8_t *buf, int len) -> void {
+            static_cast<CPeer *>(udata)->transport.rx_count++;
+        };
+        init.buffer = peer.buffer;
+        init.buffer_size = sizeof(peer.buffer);
+        init.window_frames = WINDOW;
+        init.mtu = MTU;
+        init.send_timeout = 1000;
+        init.retry_timeout = 200;
+        init.retries = 2;
+        init.crc_type = HDLC_CRC_16;
+        tiny_fd_init(&peer.handle, &init);
+    }
+    measure(
+        "C API", [&](const uint8_t *data, int len) { return tiny_fd_send_packet(peers[0].handle, data, len, 0); },
+        [&]() {
+            cRunTx(peers[0], cWrite);
+            cRunTx(peers[1], cWrite);
+            tiny_fd_run_rx(peers[0].handle, cRead);
+            tiny_fd_run_rx(peers[1].handle, cRead);
+        },
+        [&]() -> int { return peers[1].transport.rx_count; });
+    for ( auto &peer : peers )
+    {
+        tiny_fd_close(peer.handle);
+    }
+}
+
+static void runEngine(Channel &ab, Channel &ba)
+{
+    Engine engines[2];
+    engines[0].transport().tx = &ab;
+    engines[0].transport().rx = &ba;
+    engines[1].transport().tx = &ba;
+    engines[1].transport().rx = &ab;
+    engines[0].setSendTimeout(0);
+    engines[1].setSendTimeout(0);
+    engines[0].begin();
+    engines[1].begin();
+    measure(
+        "FdEngine", [&](const uint8_t *data, int len) { return engines[0].write(data, len); },
+        [&]() {
+            engines[0].run_tx();
+            engines[1].run_tx();
+            engines[0].run_rx();
+            engines[1].run_rx();
+        },
+        [&]() -> int { return engines[1].transport().rx_count; });
+}
+
+int main(int argc, char *argv[])
+{
+    {
+        Channel ab, ba;
+        runC(ab, ba);
+    }
+    {
+        Channel ab, ba;
+        runEngine(ab, ba);
+    }
+    return 0;
+}
@@ -0,0 +1,148 @@
+/*
+    Copyright 2022 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    GNU General Public License Usage
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Commercial License Usage
+
+    Licensees holding valid commercial Tiny Protocol licenses may use this file in
+    accordance with the commercial license agreement provided in accordance with
+    the terms contained in a written agreement between you and Alexey Dynda.
+    For further information contact via email on github account.
+*/
+
+/**
+ * Framing benchmark compares HDLC byte stuffing with COBS and length prefixed framing of hdlc_ll:
+ * encoding and decoding speed, and the line overhead on random and worst-case payloads.
+ */
+
+#include "proto/hdlc/low_level/hdlc.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+
+static const int MTU = 1024;
+static const int FRAMES = 20000;
+
+struct Result
+{
+    double encode_mbs;
+    double decode_mbs;
+    double overhead;
+    int received;
+};
+
+static double mbPerSecond(int64_t bytes, std::chrono::steady_clock::time_point start)
+{
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    return us ? static_cast<double>(bytes) / us : 0.0;
+}
+
+static Result measure(hdlc_framing_t framing, hdlc_crc_t crc, const std::vector<uint8_t> &payload)
+{
+    std::vector<uint8_t> tx_buf(hdlc_ll_get_buf_size_ex(MTU, HDLC_CRC_16, 1));
+    std::vector<uint8_t> rx_buf(hdlc_ll_get_buf_size_ex(MTU, HDLC_CRC_16, 1));
+    // Worst case of HDLC doubles the frame
+    std::vector<uint8_t> wire(MTU * 2 + 16);
+    Result result{};
+    hdlc_ll_handle_t tx = nullptr;
+    hdlc_ll_handle_t rx = nullptr;
+    hdlc_ll_init_t init{};
+    init.crc_type = crc;
+    init.framing = framing;
+    init.mtu = MTU;
+    init.buf = tx_buf.data();
+    init.buf_size = static_cast<int>(tx_buf.size());
+    hdlc_ll_init(&tx, &init);
+    init.buf = rx_buf.data();
+    init.buf_size = static_cast<int>(rx_buf.size());
+    init.user_data = &result;
+    init.on_frame_read = [](void *udata, uint8_t *data, int len) -> void { static_cast<Result *>(udata)->received++; };
+    hdlc_ll_init(&rx, &init);
+
+    int wire_len = 0;
+    auto start = std::chrono::steady_clock::now();
+    for ( int i = 0; i < FRAMES; i++ )
+    {
+        hdlc_ll_put(tx, payload.data(), static_cast<int>(payload.size()));
+        wire_len = hdlc_ll_run_tx(tx, wire.data(), static_cast<int>(wire.size()));
+    }
+    result.encode_mbs = mbPerSecond(static_cast<int64_t>(FRAMES) * payload.size(), start);
+    result.overhead = 100.0 * (wire_len - static_cast<int>(payload.size())) / payload.size();
+
+    start = std::chrono::steady_clock::now();
+    for ( int i = 0; i < FRAMES; i++ )
+    {
+        hdlc_ll_run_rx(rx, wire.data(), wire_len, nullptr);
+    }
+    result.decode_mbs = mbPerSecond(static_cast<int64_t>(FRAMES) * payload.size(), start);
+    hdlc_ll_close(tx);
+    hdlc_ll_close(rx);
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    struct
+    {
+        const char *name;
+        std::vector<uint8_t> payload;
+    } cases[] = {
+        {"random", std::vector<uint8_t>(MTU)},
+        // 0x7E must be escaped by HDLC, and there is no zero bytes to encode for COBS
+        {"flags", std::vector<uint8_t>(MTU, 0x7E)},
+        {"zeros", std::vector<uint8_t>(MTU, 0x00)},
+    };
+    for ( auto &b : cases[0].payload )
+    {
+        b = static_cast<uint8_t>(rand());
+    }
+    struct
+    {
+        const char *name;
+        hdlc_framing_t framing;
+        hdlc_crc_t crc;
+    } framings[] = {
+        {"HDLC", HDLC_FRAMING_HDLC, HDLC_CRC_16},
+        {"COBS", HDLC_FRAMING_COBS, HDLC_CRC_16},
+        {"RAW", HDLC_FRAMING_RAW, HDLC_CRC_16},
+        {"RAW/32", HDLC_FRAMING_RAW, HDLC_CRC_32},
+        {"RAW/32C", HDLC_FRAMING_RAW, HDLC_CRC_32C},
+        // Transport guarantees integrity, so there is nothing to do, but to copy the data
+        {"RAW/off", HDLC_FRAMING_RAW, HDLC_CRC_OFF},
+    };
+    printf("%-8s %-8s %12s %12s %10s\n", "data", "frame", "encode MB/s", "decode MB/s", "overhead");
+    for ( auto &c : cases )
+    {
+        for ( auto &f : framings )
+        {
+            Result result = measure(f.framing, f.crc, c.payload);
+            if ( result.received != FRAMES )
+            {
+                fprintf(stderr, "%s: %d frames of %d are decoded\n", c.name, result.received, FRAMES);
+                return 1;
+            }
+            printf("%-8s %-8s %12.2f %12.2f %9.2f%%\n", c.name, f.name, result.encode_mbs, result.decode_mbs,
+                   result.overhead);
+        }
+    }
+    return 0;
+}
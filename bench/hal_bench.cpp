@@ -0,0 +1,110 @@
+/*
+    Copyright 2022 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    GNU General Public License Usage
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Commercial License Usage
+
+    Licensees holding valid commercial Tiny Protocol licenses may use this file in
+    accordance with the commercial license agreement provided in accordance with
+    the terms contained in a written agreement between you and Alexey Dynda.
+    For further information contact via email on github account.
+*/
+
+/**
+ * HAL benchmark measures cost of synchronization primitives used by the protocol.
+ * The same source is linked with platform HAL (hal_bench) and with C++ HAL (hal_bench_cpp).
+ */
+
+#include "hal/tiny_types.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <thread>
+
+#if defined(CONFIG_ENABLE_CPP_HAL)
+static const char *s_hal = "cpp";
+#else
+static const char *s_hal = "platform";
+#endif
+
+template <typename F> static void measure(const char *name, int count, F func)
+{
+    auto start = std::chrono::steady_clock::now();
+    for ( int i = 0; i < count; i++ )
+    {
+        func();
+    }
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    printf("%-10s %-28s %10.1f ns/op\n", s_hal, name, static_cast<double>(ns) / count);
+}
+
+static void pingPong(int count)
+{
+    tiny_events_t ping;
+    tiny_events_t pong;
+    tiny_events_create(&ping);
+    tiny_events_create(&pong);
+    std::thread peer(
+        [&]()
+        {
+            for ( int i = 0; i < count; i++ )
+            {
+                tiny_events_wait(&ping, 1, EVENT_BITS_CLEAR, 1000);
+                tiny_events_set(&pong, 1);
+            }
+        });
+    measure("events ping-pong", count,
+            [&]()
+            {
+                tiny_events_set(&ping, 1);
+                tiny_events_wait(&pong, 1, EVENT_BITS_CLEAR, 1000);
+            });
+    peer.join();
+    tiny_events_destroy(&pong);
+    tiny_events_destroy(&ping);
+}
+
+int main(int argc, char *argv[])
+{
+    int count = argc > 1 ? atoi(argv[1]) : 1000000;
+    tiny_mutex_t mutex;
+    tiny_events_t events;
+    tiny_mutex_create(&mutex);
+    tiny_events_create(&events);
+    measure("mutex lock/unlock", count,
+            [&]()
+            {
+                tiny_mutex_lock(&mutex);
+                tiny_mutex_unlock(&mutex);
+            });
+    measure("events set/wait(0)", count,
+            [&]()
+            {
+                tiny_events_set(&events, 1);
+                tiny_events_wait(&events, 1, EVENT_BITS_CLEAR, 0);
+            });
+    measure("events wait(0) miss", count, [&]() { tiny_events_wait(&events, 2, EVENT_BITS_LEAVE, 0); });
+    volatile uint32_t ts = 0;
+    measure("millis", count, [&]() { ts = ts + tiny_millis(); });
+    pingPong(count / 10);
+    tiny_events_destroy(&events);
+    tiny_mutex_destroy(&mutex);
+    return 0;
+}
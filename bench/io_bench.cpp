@@ -0,0 +1,177 @@
+/*
+    Copyright 2022 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    GNU General Public License Usage
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Commercial License Usage
+
+    Licensees holding valid commercial Tiny Protocol licenses may use this file in
+    accordance with the commercial license agreement provided in accordance with
+    the terms contained in a written agreement between you and Alexey Dynda.
+    For further information contact via email on github account.
+*/
+
+
+/**
+ * I/O benchmark compares tiny_fd_run_rx_ex()/tiny_fd_run_tx_ex() with different block sizes.
+ * Two protocol instances are connected via in-memory channel, which accepts only as many bytes
+ * as it has free space (like non-blocking serial port or socket).
+ */
+
+#include "proto/fd/tiny_fd.h"
+#include "bench_channel.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+struct Peer
+{
+    tiny_fd_handle_t handle = nullptr;
+    Channel *tx = nullptr;
+    Channel *rx = nullptr;
+    std::vector<uint8_t> buffer;
+    std::atomic<uint32_t> rx_bytes{0};
+    std::atomic<uint32_t> callbacks{0};
+    std::atomic<uint32_t> io_bytes{0};
+    std::atomic<uint32_t> busy{0};
+};
+
+static int writeData(void *udata, const void *data, int len)
+{
+    Peer *peer = static_cast<Peer *>(udata);
+    peer->callbacks++;
+    int result = peer->tx->write(data, len);
+    peer->io_bytes += result;
+    if ( result == 0 )
+    {
+        peer->busy++;
+    }
+    return result;
+}
+
+static int readData(void *udata, void *data, int len)
+{
+    Peer *peer = static_cast<Peer *>(udata);
+    peer->callbacks++;
+    int result = peer->rx->read(data, len);
+    peer->io_bytes += result;
+    return result;
+}
+
+static void run(int block_size, int mtu, int frames)
+{
+    Channel ab, ba;
+    Peer peers[2];
+    peers[0].tx = &ab;
+    peers[0].rx = &ba;
+    peers[1].tx = &ba;
+    peers[1].rx = &ab;
+    for ( auto &peer : peers )
+    {
+        tiny_fd_init_t init{};
+        init.pdata = &peer;
+        init.on_read_cb = [](void *udata, uint8_t addr, uint8_t *buf, int len) -> void {
+            static_cast<Peer *>(udata)->rx_bytes += len;
+        };
+        peer.buffer.resize(tiny_fd_buffer_size_by_mtu_ex(1, mtu, 7, HDLC_CRC_16, 1));
+        init.buffer = peer.buffer.data();
+        init.buffer_size = static_cast<tiny_buf_size_t>(peer.buffer.size());
+        init.window_frames = 7;
+        init.mtu = mtu;
+        init.send_timeout = 1000;
+        init.retry_timeout = 200;
+        init.retries = 2;
+        init.crc_type = HDLC_CRC_16;
+        if ( tiny_fd_init(&peer.handle, &init) != TINY_SUCCESS )
+        {
+            fprintf(stderr, "Failed to initialize protocol\n");
+            return;
+        }
+    }
+    std::atomic<bool> stop{false};
+    auto worker = [&](Peer &peer) {
+        uint8_t *buf = new uint8_t[block_size];
+        while ( !stop )
+        {
+            tiny_fd_run_tx_ex(peer.handle, writeData, &peer, buf, block_size, 1);
+            tiny_fd_run_rx_ex(peer.handle, readData, &peer, buf, block_size);
+        }
+        delete[] buf;
+    };
+    std::thread t1(worker, std::ref(peers[0]));
+    std::thread t2(worker, std::ref(peers[1]));
+    while ( tiny_fd_get_status(peers[0].handle) != TINY_SUCCESS )
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    peers[0].callbacks = 0;
+    peers[0].io_bytes = 0;
+    peers[1].callbacks = 0;
+    peers[1].io_bytes = 0;
+    peers[0].busy = 0;
+    peers[1].busy = 0;
+
+    uint8_t *payload = new uint8_t[mtu];
+    memset(payload, 0xA5, mtu);
+    auto start = std::chrono::steady_clock::now();
+    for ( int i = 0; i < frames; i++ )
+    {
+        tiny_fd_send_packet(peers[0].handle, payload, mtu, 1000);
+    }
+    uint32_t expected = static_cast<uint32_t>(frames) * mtu;
+    while ( peers[1].rx_bytes < expected &&
+            std::chrono::steady_clock::now() - start < std::chrono::seconds(10) )
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    stop = true;
+    t1.join();
+    t2.join();
+    delete[] payload;
+
+    // Writes to the full channel are retried by run_tx, they are reported separately
+    uint32_t busy = peers[0].busy + peers[1].busy;
+    uint32_t callbacks = peers[0].callbacks + peers[1].callbacks - busy;
+    uint32_t io_bytes = peers[0].io_bytes + peers[1].io_bytes;
+    printf("mtu %5d, block %5d: %8u bytes received, %9.1f bytes/callback, %8u busy writes, %8.2f MB/s\n", mtu, block_size,
+           static_cast<unsigned>(peers[1].rx_bytes), callbacks ? static_cast<double>(io_bytes) / callbacks : 0.0,
+           static_cast<unsigned>(busy), us ? static_cast<double>(peers[1].rx_bytes) / us : 0.0);
+    for ( auto &peer : peers )
+    {
+        tiny_fd_close(peer.handle);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    const int block_sizes[] = {4, 64, 512, 4096};
+    for ( int block_size : block_sizes )
+    {
+        run(block_size, 1024, 2000);
+    }
+#if CONFIG_TINY_LARGE_BUFFERS
+    // Large frames with full window require more than 64 KiB of protocol buffer
+    run(4096, 32768, 200);
+#endif
+    return 0;
+}
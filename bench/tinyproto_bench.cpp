@@ -0,0 +1,566 @@
+/*
+    Copyright 2022 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    GNU General Public License Usage
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Commercial License Usage
+
+    Licensees holding valid commercial Tiny Protocol licenses may use this file in
+    accordance with the commercial license agreement provided in accordance with
+    the terms contained in a written agreement between you and Alexey Dynda.
+    For further information contact via email on github account.
+*/
+
+/**
+ * Benchmark suite of the library. It runs microbenchmarks of crc, hdlc_ll and fd queue,
+ * HAL events, and end-to-end FD and HDLC loopback over in-memory channels, sweeping mtu,
+ * window and crc type. Results are printed as CSV or JSON to compare them across releases.
+ *
+ *   tinyproto_bench [-f csv|json] [-s suite]... [-q]
+ */
+
+#include "proto/crc/tiny_crc.h"
+#include "proto/hdlc/low_level/hdlc.h"
+#include "proto/hdlc/high_level/hdlc.h"
+#include "proto/fd/tiny_fd.h"
+#include "proto/fd/tiny_fd_frames_int.h"
+#include "bench_channel.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct Sample
+{
+    const char *suite;
+    const char *name;
+    int mtu;
+    int window;
+    hdlc_crc_t crc;
+    int64_t ops;
+    int64_t bytes;
+    int64_t ns;
+};
+
+static const int s_mtus[] = {64, 256, 1024};
+static const int s_windows[] = {2, 4, 7};
+static const hdlc_crc_t s_crcs[] = {HDLC_CRC_OFF, HDLC_CRC_8, HDLC_CRC_16, HDLC_CRC_32, HDLC_CRC_32C};
+static const hdlc_crc_t s_linkCrcs[] = {HDLC_CRC_16, HDLC_CRC_32, HDLC_CRC_32C};
+
+/** Number of payload bytes, processed by single microbenchmark */
+static int64_t s_budget = 32 * 1024 * 1024;
+static std::vector<std::string> s_suites;
+static bool s_json = false;
+static std::vector<Sample> s_samples;
+
+static const char *crcName(hdlc_crc_t crc)
+{
+    switch ( crc )
+    {
+        case HDLC_CRC_8: return "8";
+        case HDLC_CRC_16: return "16";
+        case HDLC_CRC_32: return "32";
+        case HDLC_CRC_32C: return "32C";
+        case HDLC_CRC_OFF: return "off";
+        // Not applicable to the benchmark
+        default: return "";
+    }
+}
+
+static int64_t elapsedNs(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+static bool enabled(const char *suite)
+{
+    if ( s_suites.empty() )
+    {
+        return true;
+    }
+    for ( auto &name : s_suites )
+    {
+        if ( name == suite )
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/** Runs func count times, each run processes bytes of payload */
+template <typename F>
+static void measure(const char *suite, const char *name, int mtu, int window, hdlc_crc_t crc, int64_t count,
+                    int bytes, F func)
+{
+    auto start = std::chrono::steady_clock::now();
+    for ( int64_t i = 0; i < count; i++ )
+    {
+        func();
+    }
+    s_samples.push_back(Sample{suite, name, mtu, window, crc, count, count * bytes, elapsedNs(start)});
+}
+
+static std::vector<uint8_t> randomPayload(int size)
+{
+    std::vector<uint8_t> payload(size);
+    for ( auto &b : payload )
+    {
+        b = static_cast<uint8_t>(rand());
+    }
+    return payload;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////
+
+static void benchCrc()
+{
+    for ( int mtu : s_mtus )
+    {
+        std::vector<uint8_t> data = randomPayload(mtu);
+        volatile uint32_t crc = 0;
+        int64_t count = s_budget / mtu;
+        measure("crc", "tiny_chksum", mtu, 0, HDLC_CRC_8, count, mtu,
+                [&]() { crc = crc + tiny_chksum(INITCHECKSUM, data.data(), mtu); });
+        measure("crc", "tiny_crc16", mtu, 0, HDLC_CRC_16, count, mtu,
+                [&]() { crc = crc + tiny_crc16(PPPINITFCS16, data.data(), mtu); });
+        measure("crc", "tiny_crc32", mtu, 0, HDLC_CRC_32, count, mtu,
+                [&]() { crc = crc + tiny_crc32(PPPINITFCS32, data.data(), mtu); });
+        measure("crc", "tiny_crc32c", mtu, 0, HDLC_CRC_32C, count, mtu,
+                [&]() { crc = crc + tiny_crc32c(INITCRC32C, data.data(), mtu); });
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////
+
+static void benchHdlcLl()
+{
+    for ( int mtu : s_mtus )
+    {
+        std::vector<uint8_t> payload = randomPayload(mtu);
+        for ( hdlc_crc_t crc : s_crcs )
+        {
+            std::vector<uint8_t> tx_buf(hdlc_ll_get_buf_size_ex(mtu, crc, 1));
+            std::vector<uint8_t> rx_buf(hdlc_ll_get_buf_size_ex(mtu, crc, 1));
+            std::vector<uint8_t> wire(mtu * 2 + 16);
+            int received = 0;
+            hdlc_ll_handle_t tx = nullptr;
+            hdlc_ll_handle_t rx = nullptr;
+            hdlc_ll_init_t init{};
+            init.crc_type = crc;
+            init.mtu = mtu;
+            init.buf = tx_buf.data();
+            init.buf_size = static_cast<int>(tx_buf.size());
+            hdlc_ll_init(&tx, &init);
+            init.buf = rx_buf.data();
+            init.buf_size = static_cast<int>(rx_buf.size());
+            init.user_data = &received;
+            init.on_frame_read = [](void *udata, uint8_t *data, int len) -> void { (*static_cast<int *>(udata))++; };
+            hdlc_ll_init(&rx, &init);
+            int64_t count = s_budget / mtu;
+            int wire_len = 0;
+            measure("hdlc_ll", "encode", mtu, 0, crc, count, mtu,
+                    [&]()
+                    {
+                        hdlc_ll_put(tx, payload.data(), mtu);
+                        wire_len = hdlc_ll_run_tx(tx, wire.data(), static_cast<int>(wire.size()));
+                    });
+            measure("hdlc_ll", "decode", mtu, 0, crc, count, mtu,
+                    [&]() { hdlc_ll_run_rx(rx, wire.data(), wire_len, nullptr); });
+            hdlc_ll_close(tx);
+            hdlc_ll_close(rx);
+            if ( received != count )
+            {
+                fprintf(stderr, "hdlc_ll: %d frames of %lld are decoded\n", received, static_cast<long long>(count));
+                exit(1);
+            }
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////
+
+static void benchFdQueue()
+{
+    for ( int mtu : s_mtus )
+    {
+        std::vector<uint8_t> payload = randomPayload(mtu);
+        for ( int window : s_windows )
+        {
+            // The ring holds the same number of frames of mtu size, as fixed slots do
+            int ring_size = static_cast<int>(window * TINY_FD_QUEUE_SLOT_SIZE(mtu));
+            std::vector<uint8_t> buffer(TINY_FD_QUEUE_SIZE(window, mtu));
+            std::vector<uint8_t> ring_buffer(TINY_FD_QUEUE_RING_SIZE(window, ring_size));
+            tiny_fd_frame_info_t *frames[8];
+            tiny_fd_queue_t queue;
+            for ( int ring = 0; ring < 2; ring++ )
+            {
+                if ( ring )
+                {
+                    tiny_fd_queue_init_ring(&queue, ring_buffer.data(), static_cast<int>(ring_buffer.size()), window,
+                                            mtu, ring_size);
+                }
+                else
+                {
+                    tiny_fd_queue_init(&queue, buffer.data(), static_cast<int>(buffer.size()), window, mtu);
+                }
+                // Single operation fills the queue and then frees the frames in order, as confirmed I-frames
+                measure("fd_queue", ring ? "ring_allocate_free" : "allocate_free", mtu, window, HDLC_CRC_DEFAULT,
+                        s_budget / mtu / window, mtu * window,
+                        [&]()
+                        {
+                            for ( int i = 0; i < window; i++ )
+                            {
+                                frames[i] = tiny_fd_queue_allocate(&queue, TINY_FD_QUEUE_I_FRAME, payload.data(), mtu);
+                            }
+                            for ( int i = 0; i < window; i++ )
+                            {
+                                tiny_fd_queue_free(&queue, frames[i]);
+                            }
+                        });
+            }
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////
+
+static void benchEvents()
+{
+    int64_t count = s_budget / 32;
+    tiny_events_t events;
+    tiny_events_create(&events);
+    measure("events", "set_wait", 0, 0, HDLC_CRC_DEFAULT, count, 0,
+            [&]()
+            {
+                tiny_events_set(&events, 1);
+                tiny_events_wait(&events, 1, EVENT_BITS_CLEAR, 0);
+            });
+    measure("events", "wait_miss", 0, 0, HDLC_CRC_DEFAULT, count, 0,
+            [&]() { tiny_events_wait(&events, 2, EVENT_BITS_LEAVE, 0); });
+    tiny_events_destroy(&events);
+
+    tiny_events_t ping;
+    tiny_events_t pong;
+    tiny_events_create(&ping);
+    tiny_events_create(&pong);
+    count /= 100;
+    std::thread peer(
+        [&]()
+        {
+            for ( int64_t i = 0; i < count; i++ )
+            {
+                tiny_events_wait(&ping, 1, EVENT_BITS_CLEAR, 1000);
+                tiny_events_set(&pong, 1);
+            }
+        });
+    measure("events", "ping_pong", 0, 0, HDLC_CRC_DEFAULT, count, 0,
+            [&]()
+            {
+                tiny_events_set(&ping, 1);
+                tiny_events_wait(&pong, 1, EVENT_BITS_CLEAR, 1000);
+            });
+    peer.join();
+    tiny_events_destroy(&pong);
+    tiny_events_destroy(&ping);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////
+
+struct FdPeer
+{
+    tiny_fd_handle_t handle = nullptr;
+    Channel *tx = nullptr;
+    Channel *rx = nullptr;
+    int received = 0;
+    std::vector<uint8_t> buffer;
+};
+
+/** The same as tiny_fd_run_tx(), but without waiting for tx data */
+static void fdRunTx(FdPeer &peer)
+{
+    uint8_t buf[TINY_FD_TX_BLOCK_SIZE];
+    int len;
+    while ( (len = tiny_fd_get_tx_data(peer.handle, buf, sizeof(buf), 0)) > 0 )
+    {
+        for ( uint8_t *ptr = buf; len > 0; )
+        {
+            int result = peer.tx->write(ptr, len);
+            len -= result;
+            ptr += result;
+        }
+    }
+}
+
+static void fdRunRx(FdPeer &peer)
+{
+    uint8_t buf[TINY_FD_TX_BLOCK_SIZE];
+    int len;
+    while ( (len = peer.rx->read(buf, sizeof(buf))) > 0 )
+    {
+        tiny_fd_on_rx_data(peer.handle, buf, len);
+    }
+}
+
+static void benchFd()
+{
+    for ( int mtu : s_mtus )
+    {
+        std::vector<uint8_t> payload = randomPayload(mtu);
+        for ( int window : s_windows )
+        {
+            for ( hdlc_crc_t crc : s_linkCrcs )
+            {
+                Channel ab, ba;
+                FdPeer peers[2];
+                peers[0].tx = &ab;
+                peers[0].rx = &ba;
+                peers[1].tx = &ba;
+                peers[1].rx = &ab;
+                for ( auto &peer : peers )
+                {
+                    tiny_fd_init_t init{};
+                    init.pdata = &peer;
+                    init.on_read_cb = [](void *udata, uint8_t addr, uint8_t *buf, int len) -> void {
+                        static_cast<FdPeer *>(udata)->received++;
+                    };
+                    init.window_frames = window;
+                    init.mtu = mtu;
+                    init.crc_type = crc;
+                    init.send_timeout = 1000;
+                    init.retry_timeout = 200;
+                    init.retries = 2;
+                    peer.buffer.resize(tiny_fd_buffer_size_by_mtu_ex(1, mtu, window, crc, 1));
+                    init.buffer = peer.buffer.data();
+                    init.buffer_size = static_cast<int>(peer.buffer.size());
+                    if ( tiny_fd_init(&peer.handle, &init) != TINY_SUCCESS )
+                    {
+                        fprintf(stderr, "fd_loopback: failed to initialize mtu %d, window %d\n", mtu, window);
+                        exit(1);
+                    }
+                }
+                int64_t frames = s_budget / 16 / mtu;
+                auto start = std::chrono::steady_clock::now();
+                // Single thread and zero timeouts: the benchmark measures CPU cost of the protocol only
+                while ( peers[1].received < frames && std::chrono::steady_clock::now() - start < std::chrono::seconds(10) )
+                {
+                    tiny_fd_send_packet(peers[0].handle, payload.data(), mtu, 0);
+                    fdRunTx(peers[0]);
+                    fdRunTx(peers[1]);
+                    fdRunRx(peers[0]);
+                    fdRunRx(peers[1]);
+                }
+                s_samples.push_back(Sample{"fd_loopback", "send", mtu, window, crc, peers[1].received,
+                                           static_cast<int64_t>(peers[1].received) * mtu, elapsedNs(start)});
+                for ( auto &peer : peers )
+                {
+                    tiny_fd_close(peer.handle);
+                }
+            }
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////
+
+struct HdlcPeer
+{
+    hdlc_struct_t hdlc;
+    Channel *channel = nullptr;
+    int received = 0;
+    std::vector<uint8_t> buffer;
+};
+
+static void benchHdlc()
+{
+    for ( int mtu : s_mtus )
+    {
+        std::vector<uint8_t> payload = randomPayload(mtu);
+        for ( hdlc_crc_t crc : s_linkCrcs )
+        {
+            Channel channel;
+            HdlcPeer peers[2];
+            for ( auto &peer : peers )
+            {
+                memset(&peer.hdlc, 0, sizeof(peer.hdlc));
+                peer.channel = &channel;
+                peer.buffer.resize(hdlc_ll_get_buf_size_ex(mtu, crc, 1));
+                peer.hdlc.send_tx = [](void *udata, const void *data, int len) -> int {
+                    return static_cast<HdlcPeer *>(udata)->channel->write(data, len);
+                };
+                peer.hdlc.on_frame_read = [](void *udata, void *data, int len) -> int {
+                    static_cast<HdlcPeer *>(udata)->received++;
+                    return 0;
+                };
+                peer.hdlc.rx_buf = peer.buffer.data();
+                peer.hdlc.rx_buf_size = static_cast<int>(peer.buffer.size());
+                peer.hdlc.crc_type = crc;
+                peer.hdlc.user_data = &peer;
+                hdlc_init(&peer.hdlc);
+            }
+            int64_t frames = s_budget / 4 / mtu;
+            int sent = 0;
+            auto start = std::chrono::steady_clock::now();
+            while ( peers[1].received < frames && std::chrono::steady_clock::now() - start < std::chrono::seconds(10) )
+            {
+                if ( sent < frames && hdlc_send(&peers[0].hdlc, payload.data(), mtu, 0) == TINY_SUCCESS )
+                {
+                    sent++;
+                }
+                hdlc_run_tx(&peers[0].hdlc);
+                uint8_t buf[HDLC_TX_BLOCK_SIZE];
+                int len;
+                while ( (len = channel.read(buf, sizeof(buf))) > 0 )
+                {
+                    hdlc_run_rx(&peers[1].hdlc, buf, len, nullptr);
+                }
+            }
+            s_samples.push_back(Sample{"hdlc_loopback", "send", mtu, 0, crc, peers[1].received,
+                                       static_cast<int64_t>(peers[1].received) * mtu, elapsedNs(start)});
+            for ( auto &peer : peers )
+            {
+                hdlc_close(&peer.hdlc);
+            }
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////
+
+static void print()
+{
+    if ( s_json )
+    {
+        printf("[\n");
+    }
+    else
+    {
+        printf("suite,name,mtu,window,crc,ops,bytes,ns,ns_per_op,mb_per_s\n");
+    }
+    for ( size_t i = 0; i < s_samples.size(); i++ )
+    {
+        const Sample &s = s_samples[i];
+        double ns_per_op = s.ops ? static_cast<double>(s.ns) / s.ops : 0.0;
+        double mb_per_s = s.ns ? s.bytes * 1000.0 / s.ns : 0.0;
+        if ( s_json )
+        {
+            printf("  {\"suite\": \"%s\", \"name\": \"%s\", \"mtu\": %d, \"window\": %d, \"crc\": \"%s\", "
+                   "\"ops\": %lld, \"bytes\": %lld, \"ns\": %lld, \"ns_per_op\": %.1f, \"mb_per_s\": %.2f}%s\n",
+                   s.suite, s.name, s.mtu, s.window, crcName(s.crc), static_cast<long long>(s.ops),
+                   static_cast<long long>(s.bytes), static_cast<long long>(s.ns), ns_per_op, mb_per_s,
+                   i + 1 < s_samples.size() ? "," : "");
+        }
+        else
+        {
+            printf("%s,%s,%d,%d,%s,%lld,%lld,%lld,%.1f,%.2f\n", s.suite, s.name, s.mtu, s.window,
+                   crcName(s.crc), static_cast<long long>(s.ops), static_cast<long long>(s.bytes),
+                   static_cast<long long>(s.ns), ns_per_op, mb_per_s);
+        }
+    }
+    if ( s_json )
+    {
+        printf("]\n");
+    }
+}
+
+static void usage()
+{
+    fprintf(stderr, "Usage: tinyproto_bench [-f csv|json] [-s suite]... [-q]\n");
+    fprintf(stderr, "  -f, --format <fmt>    output format: csv (default) or json\n");
+    fprintf(stderr, "  -s, --suite <name>    run only specified suite, can be repeated:\n");
+    fprintf(stderr, "                        crc, hdlc_ll, fd_queue, events, fd_loopback, hdlc_loopback\n");
+    fprintf(stderr, "  -q, --quick           process 16 times less data, for smoke runs\n");
+}
+
+static int parse_args(int argc, char *argv[])
+{
+    for ( int i = 1; i < argc; i++ )
+    {
+        if ( (!strcmp(argv[i], "-f")) || (!strcmp(argv[i], "--format")) )
+        {
+            if ( ++i >= argc )
+            {
+                return -1;
+            }
+            if ( !strcmp(argv[i], "json") )
+            {
+                s_json = true;
+            }
+            else if ( strcmp(argv[i], "csv") )
+            {
+                return -1;
+            }
+        }
+        else if ( (!strcmp(argv[i], "-s")) || (!strcmp(argv[i], "--suite")) )
+        {
+            if ( ++i >= argc )
+            {
+                return -1;
+            }
+            s_suites.push_back(argv[i]);
+        }
+        else if ( (!strcmp(argv[i], "-q")) || (!strcmp(argv[i], "--quick")) )
+        {
+            s_budget /= 16;
+        }
+        else
+        {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    if ( parse_args(argc, argv) < 0 )
+    {
+        usage();
+        return 1;
+    }
+    if ( enabled("crc") )
+    {
+        benchCrc();
+    }
+    if ( enabled("hdlc_ll") )
+    {
+        benchHdlcLl();
+    }
+    if ( enabled("fd_queue") )
+    {
+        benchFdQueue();
+    }
+    if ( enabled("events") )
+    {
+        benchEvents();
+    }
+    if ( enabled("fd_loopback") )
+    {
+        benchFd();
+    }
+    if ( enabled("hdlc_loopback") )
+    {
+        benchHdlc();
+    }
+    print();
+    return 0;
+}
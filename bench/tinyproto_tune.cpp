@@ -0,0 +1,225 @@
+/*
+    Copyright 2022 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    GNU General Public License Usage
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Commercial License Usage
+
+    Licensees holding valid commercial Tiny Protocol licenses may use this file in
+    accordance with the commercial license agreement provided in accordance with
+    the terms contained in a written agreement between you and Alexey Dynda.
+    For further information contact via email on github account.
+*/
+
+/**
+ * Link tuner utility. It probes full duplex protocol parameters over the simulated serial line
+ * with specified baudrate, delay and error rate, and prints the recommended tiny_fd_init_t
+ * configuration together with its memory cost. Use tiny_loopback --tune to probe a live link.
+ *
+ *   tinyproto_tune [-b baud] [-d delay_us] [-e ber] [-g goodput|latency] [-m bytes] ...
+ */
+
+#include "TinyLinkTuner.h"
+#include "sim_probe.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+static SimProbeConfig s_config;
+static tinyproto::LinkTunerGoal s_goal = tinyproto::LinkTunerGoal::GOODPUT;
+static int s_memoryLimit = 0;
+static std::vector<int> s_mtus;
+static std::vector<uint8_t> s_windows;
+static std::vector<hdlc_crc_t> s_crcs;
+static std::vector<uint16_t> s_timeouts;
+
+static const char *crcName(hdlc_crc_t crc)
+{
+    switch ( crc )
+    {
+        case HDLC_CRC_OFF: return "HDLC_CRC_OFF";
+        case HDLC_CRC_8: return "HDLC_CRC_8";
+        case HDLC_CRC_16: return "HDLC_CRC_16";
+        case HDLC_CRC_32: return "HDLC_CRC_32";
+        case HDLC_CRC_32C: return "HDLC_CRC_32C";
+        default: return "HDLC_CRC_DEFAULT";
+    }
+}
+
+static void onResult(void *arg, const tinyproto::LinkTunerResult &result)
+{
+    if ( !result.valid )
+    {
+        printf("%6d %6d %14s %8u %8d %12s %12s\n", result.params.mtu, result.params.window,
+               crcName(result.params.crc), result.params.retryTimeout, result.memory, "-", "-");
+        return;
+    }
+    printf("%6d %6d %14s %8u %8d %12u %12u\n", result.params.mtu, result.params.window, crcName(result.params.crc),
+           result.params.retryTimeout, result.memory, result.goodput, result.latencyP99);
+    fflush(stdout);
+}
+
+static void usage()
+{
+    fprintf(stderr, "Usage: tinyproto_tune [options]\n");
+    fprintf(stderr, "  -b, --baud <baud>        baudrate of simulated line: 115200 (default)\n");
+    fprintf(stderr, "  -d, --delay <us>         propagation delay in microseconds: 0 (default)\n");
+    fprintf(stderr, "  -e, --ber <rate>         bit error rate: 0 (default)\n");
+    fprintf(stderr, "      --burst <rate> <len> error burst probability per byte and burst length in bytes\n");
+    fprintf(stderr, "  -g, --goal <goal>        goodput (default) or latency\n");
+    fprintf(stderr, "  -m, --memory <bytes>     skip parameters, which require larger buffer\n");
+    fprintf(stderr, "  -t, --time <ms>          virtual time of single probe: 1000 (default)\n");
+    fprintf(stderr, "  -s, --message <bytes>    message size, 0 - mtu (default)\n");
+    fprintf(stderr, "  -r, --rate <bytes/s>     offered load, 0 - unpaced sender (default)\n");
+    fprintf(stderr, "      --mtu <mtu>          mtu to probe, can be repeated: 32 64 128 256 512 by default\n");
+    fprintf(stderr, "      --window <frames>    window to probe, can be repeated: 2 - 7 by default\n");
+    fprintf(stderr, "      --crc <crc>          crc to probe, can be repeated: 0, 8, 16, 32, 32c; 8 16 32 by default\n");
+    fprintf(stderr, "      --retry <ms>         ack timeout to probe, can be repeated: 100 by default\n");
+}
+
+static int parse_args(int argc, char *argv[])
+{
+    for ( int i = 1; i < argc; i++ )
+    {
+        // All options, except --burst, have single argument
+        if ( i + 1 >= argc || (!strcmp(argv[i], "--burst") && i + 2 >= argc) )
+        {
+            return -1;
+        }
+        const char *value = argv[++i];
+        if ( (!strcmp(argv[i - 1], "-b")) || (!strcmp(argv[i - 1], "--baud")) )
+        {
+            s_config.channel.baudrate = strtoul(value, nullptr, 10);
+        }
+        else if ( (!strcmp(argv[i - 1], "-d")) || (!strcmp(argv[i - 1], "--delay")) )
+        {
+            s_config.channel.delayUs = strtoul(value, nullptr, 10);
+        }
+        else if ( (!strcmp(argv[i - 1], "-e")) || (!strcmp(argv[i - 1], "--ber")) )
+        {
+            s_config.channel.bitErrorRate = strtod(value, nullptr);
+        }
+        else if ( !strcmp(argv[i - 1], "--burst") )
+        {
+            s_config.channel.burstRate = strtod(value, nullptr);
+            s_config.channel.burstLength = strtoul(argv[++i], nullptr, 10);
+        }
+        else if ( (!strcmp(argv[i - 1], "-g")) || (!strcmp(argv[i - 1], "--goal")) )
+        {
+            if ( !strcmp(value, "latency") )
+                s_goal = tinyproto::LinkTunerGoal::LATENCY;
+            else if ( strcmp(value, "goodput") )
+                return -1;
+        }
+        else if ( (!strcmp(argv[i - 1], "-m")) || (!strcmp(argv[i - 1], "--memory")) )
+        {
+            s_memoryLimit = strtoul(value, nullptr, 10);
+        }
+        else if ( (!strcmp(argv[i - 1], "-t")) || (!strcmp(argv[i - 1], "--time")) )
+        {
+            s_config.durationMs = strtoul(value, nullptr, 10);
+        }
+        else if ( (!strcmp(argv[i - 1], "-s")) || (!strcmp(argv[i - 1], "--message")) )
+        {
+            s_config.messageSize = strtoul(value, nullptr, 10);
+        }
+        else if ( (!strcmp(argv[i - 1], "-r")) || (!strcmp(argv[i - 1], "--rate")) )
+        {
+            s_config.rate = strtoul(value, nullptr, 10);
+        }
+        else if ( !strcmp(argv[i - 1], "--mtu") )
+        {
+            s_mtus.push_back(strtoul(value, nullptr, 10));
+        }
+        else if ( !strcmp(argv[i - 1], "--window") )
+        {
+            int window = strtoul(value, nullptr, 10);
+            if ( window < 2 || window > 7 )
+            {
+                fprintf(stderr, "Allowable window size is between 2 and 7 inclusively\n");
+                return -1;
+            }
+            s_windows.push_back(static_cast<uint8_t>(window));
+        }
+        else if ( !strcmp(argv[i - 1], "--crc") )
+        {
+            if ( !strcmp(value, "32c") || !strcmp(value, "32C") )
+            {
+                s_crcs.push_back(HDLC_CRC_32C);
+            }
+            else switch ( strtoul(value, nullptr, 10) )
+            {
+                case 0: s_crcs.push_back(HDLC_CRC_OFF); break;
+                case 8: s_crcs.push_back(HDLC_CRC_8); break;
+                case 16: s_crcs.push_back(HDLC_CRC_16); break;
+                case 32: s_crcs.push_back(HDLC_CRC_32); break;
+                default: fprintf(stderr, "CRC type not supported\n"); return -1;
+            }
+        }
+        else if ( !strcmp(argv[i - 1], "--retry") )
+        {
+            s_timeouts.push_back(strtoul(value, nullptr, 10));
+        }
+        else
+        {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    if ( parse_args(argc, argv) < 0 )
+    {
+        usage();
+        return 1;
+    }
+    tinyproto::LinkTuner tuner(simProbe, &s_config);
+    if ( !s_mtus.empty() )
+        tuner.setMtus(s_mtus.data(), static_cast<int>(s_mtus.size()));
+    if ( !s_windows.empty() )
+        tuner.setWindows(s_windows.data(), static_cast<int>(s_windows.size()));
+    if ( !s_crcs.empty() )
+        tuner.setCrcs(s_crcs.data(), static_cast<int>(s_crcs.size()));
+    if ( !s_timeouts.empty() )
+        tuner.setRetryTimeouts(s_timeouts.data(), static_cast<int>(s_timeouts.size()));
+    tuner.setGoal(s_goal);
+    tuner.setMemoryLimit(s_memoryLimit);
+    tuner.setResultCallback(onResult);
+    printf("%6s %6s %14s %8s %8s %12s %12s\n", "mtu", "window", "crc", "retry", "memory", "goodput,B/s", "p99,us");
+    if ( tuner.run() == 0 )
+    {
+        fprintf(stderr, "No parameters work for the link\n");
+        return 1;
+    }
+    const tinyproto::LinkTunerResult &best = tuner.getBest();
+    printf("\nRecommended configuration: goodput %u B/s, p99 latency %u us\n", best.goodput, best.latencyP99);
+    printf("    init.mtu = %d;\n", best.params.mtu);
+    printf("    init.window_frames = %u;\n", best.params.window);
+    printf("    init.crc_type = %s;\n", crcName(best.params.crc));
+    if ( best.params.retryTimeout )
+    {
+        printf("    init.retry_timeout = %u;\n", best.params.retryTimeout);
+    }
+    printf("    init.buffer_size = %d; // tiny_fd_buffer_size_by_mtu_ex(1, %d, %u, %s, 1)\n", best.memory,
+           best.params.mtu, best.params.window, crcName(best.params.crc));
+    return 0;
+}
@@ -19,7 +19,7 @@
 #define HAVE_SERIALUSB
 #include <TinyProtocol.h>
 // We need this hack for very small controllers.
-#include <proto/fd/tiny_fd_int.h>
+#include <proto/fd/tiny_fd.h>
 
 /* Creating protocol object is simple. Lets define 64 bytes as maximum. *
  * size for the packet and use 4 packets in outgoing queue.             */
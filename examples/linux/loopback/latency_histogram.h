@@ -0,0 +1,119 @@
+/*
+    Copyright 2022 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+/**
+ * Histogram of latency values in the style of HdrHistogram: values below 128 are counted exactly,
+ * and larger values fall to buckets, which keep 6 significant bits. So any recorded value
+ * is reported with relative error under 1.6%, while the whole uint64_t range takes 3776 counters.
+ */
+class LatencyHistogram
+{
+public:
+    LatencyHistogram()
+        : m_counts(BUCKET_COUNT, 0)
+    {
+    }
+
+    void record(uint64_t value)
+    {
+        m_counts[index(value)]++;
+        m_count++;
+        m_sum += value;
+        m_min = value < m_min ? value : m_min;
+        m_max = value > m_max ? value : m_max;
+    }
+
+    uint64_t count() const
+    {
+        return m_count;
+    }
+
+    uint64_t min() const
+    {
+        return m_count ? m_min : 0;
+    }
+
+    uint64_t max() const
+    {
+        return m_max;
+    }
+
+    double mean() const
+    {
+        return m_count ? static_cast<double>(m_sum) / m_count : 0.0;
+    }
+
+    /**
+     * Returns the highest value, equivalent to the value at specified percentile (0-100)
+     */
+    uint64_t percentile(double p) const
+    {
+        uint64_t target = static_cast<uint64_t>(p / 100.0 * m_count + 0.5);
+        target = target < 1 ? 1 : target;
+        uint64_t total = 0;
+        for ( int i = 0; i < BUCKET_COUNT; i++ )
+        {
+            total += m_counts[i];
+            if ( total >= target )
+            {
+                uint64_t value = highest(i);
+                return value < m_max ? value : m_max;
+            }
+        }
+        return m_max;
+    }
+
+private:
+    static const int SUB_BUCKET_BITS = 7;
+    static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static const int BUCKET_COUNT = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS / 2 + SUB_BUCKETS / 2;
+
+    std::vector<uint64_t> m_counts;
+    uint64_t m_count = 0;
+    uint64_t m_sum = 0;
+    uint64_t m_min = UINT64_MAX;
+    uint64_t m_max = 0;
+
+    static int index(uint64_t value)
+    {
+        int shift = 0;
+        while ( (value >> shift) >= SUB_BUCKETS )
+        {
+            shift++;
+        }
+        // Each next shift adds half of sub-buckets, since the lower half is covered by previous shift
+        return shift * (SUB_BUCKETS / 2) + static_cast<int>(value >> shift);
+    }
+
+    static uint64_t highest(int index)
+    {
+        if ( index < SUB_BUCKETS )
+        {
+            return index;
+        }
+        int shift = index / (SUB_BUCKETS / 2) - 1;
+        uint64_t lowest = static_cast<uint64_t>(index - shift * (SUB_BUCKETS / 2)) << shift;
+        return lowest + (1ULL << shift) - 1;
+    }
+};
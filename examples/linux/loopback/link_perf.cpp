@@ -0,0 +1,251 @@
+/*
+    Copyright 2022 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "link_perf.h"
+
+#include <stdio.h>
+#include <thread>
+
+/** Each message starts with stream id and sequence number */
+static const int STREAM_HEADER_SIZE = 5;
+
+static tiny_fd_stats_t operator-(const tiny_fd_stats_t &a, const tiny_fd_stats_t &b)
+{
+    tiny_fd_stats_t result;
+    result.tx_i_frames = a.tx_i_frames - b.tx_i_frames;
+    result.tx_bytes = a.tx_bytes - b.tx_bytes;
+    result.rx_i_frames = a.rx_i_frames - b.rx_i_frames;
+    result.rx_bytes = a.rx_bytes - b.rx_bytes;
+    result.retransmissions = a.retransmissions - b.retransmissions;
+    result.retry_timeouts = a.retry_timeouts - b.retry_timeouts;
+    result.rej_sent = a.rej_sent - b.rej_sent;
+    result.rej_received = a.rej_received - b.rej_received;
+    result.out_of_order = a.out_of_order - b.out_of_order;
+    result.crc_errors = a.crc_errors - b.crc_errors;
+    return result;
+}
+
+LinkPerf::LinkPerf(tinyproto::Proto &proto, const LinkPerfConfig &config, std::function<tiny_fd_stats_t()> stats)
+    : m_proto(proto)
+    , m_config(config)
+    , m_stats(stats)
+    , m_streams(256)
+{
+    m_config.minSize = m_config.minSize < STREAM_HEADER_SIZE ? STREAM_HEADER_SIZE : m_config.minSize;
+    m_config.maxSize = m_config.maxSize < m_config.minSize ? m_config.minSize : m_config.maxSize;
+}
+
+void LinkPerf::onReceive(tinyproto::IPacket &packet)
+{
+    if ( packet.size() < STREAM_HEADER_SIZE )
+    {
+        return;
+    }
+    uint8_t id = packet.getByte();
+    uint32_t seq = packet.getUint32();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Stream &stream = m_streams[id];
+    // Messages are delivered in order, so the gap in sequence numbers means lost messages
+    uint32_t lost = static_cast<int32_t>(seq - stream.rxSeq) > 0 ? seq - stream.rxSeq : 0;
+    for ( Counters *counters : {&stream.counters, &m_total} )
+    {
+        counters->rxMessages++;
+        counters->rxBytes += packet.size();
+        counters->lostMessages += lost;
+    }
+    stream.rxSeq = seq + 1;
+}
+
+int LinkPerf::nextSize()
+{
+    int range = m_config.maxSize - m_config.minSize;
+    switch ( m_config.distribution )
+    {
+        case size_distribution_t::UNIFORM:
+            return m_config.minSize + std::uniform_int_distribution<int>(0, range)(m_random);
+        case size_distribution_t::EXPONENTIAL:
+        {
+            // Most messages are small, the mean size is at quarter of the range
+            double size = std::exponential_distribution<double>(4.0 / (range ? range : 1))(m_random);
+            return m_config.minSize + (size < range ? static_cast<int>(size) : range);
+        }
+        default: return m_config.maxSize;
+    }
+}
+
+bool LinkPerf::sendNext(tinyproto::HeapPacket &packet, int id)
+{
+    int size = nextSize();
+    Stream &stream = m_streams[id];
+    packet.clear();
+    packet.put(static_cast<uint8_t>(id));
+    packet.put(stream.txSeq);
+    while ( packet.size() < size )
+    {
+        packet.put(static_cast<uint8_t>(packet.size()));
+    }
+    if ( !m_proto.send(packet, 100) )
+    {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    stream.txSeq++;
+    for ( Counters *counters : {&stream.counters, &m_total} )
+    {
+        counters->txMessages++;
+        counters->txBytes += size;
+    }
+    return true;
+}
+
+int LinkPerf::run(const bool &terminate)
+{
+    tinyproto::HeapPacket packet(m_config.maxSize);
+    const bool sender = !m_config.server || m_config.bidirectional;
+    Counters last;
+    tiny_fd_stats_t lastStats = m_stats();
+    auto startTs = std::chrono::steady_clock::now();
+    double reportTs = 0;
+    int stream = 0;
+    for ( ;; )
+    {
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTs).count();
+        if ( elapsed >= reportTs + m_config.interval || elapsed >= m_config.duration || terminate )
+        {
+            report(reportTs, elapsed, last, lastStats);
+            reportTs = elapsed;
+            if ( elapsed >= m_config.duration || terminate )
+            {
+                break;
+            }
+        }
+        uint64_t sent;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            sent = m_total.txBytes;
+        }
+        // Paced sender keeps sent bytes within the rate, sleeping in between
+        if ( !sender || (m_config.rate && sent >= m_config.rate * elapsed) )
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        else if ( sendNext(packet, stream) )
+        {
+            stream = (stream + 1) % m_config.streams;
+        }
+    }
+    printSummary(reportTs, m_stats());
+    return 0;
+}
+
+void LinkPerf::report(double start, double end, Counters &last, tiny_fd_stats_t &lastStats)
+{
+    Interval interval{start, end, {}, {}};
+    tiny_fd_stats_t stats = m_stats();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        interval.counters.txMessages = m_total.txMessages - last.txMessages;
+        interval.counters.txBytes = m_total.txBytes - last.txBytes;
+        interval.counters.rxMessages = m_total.rxMessages - last.rxMessages;
+        interval.counters.rxBytes = m_total.rxBytes - last.rxBytes;
+        interval.counters.lostMessages = m_total.lostMessages - last.lostMessages;
+        last = m_total;
+    }
+    interval.stats = stats - lastStats;
+    lastStats = stats;
+    m_intervals.push_back(interval);
+    double seconds = end > start ? end - start : 1.0;
+    if ( !m_config.json )
+    {
+        printf("[%5.1f-%5.1f s] tx %9.0f B/s, rx %9.0f B/s, lost %llu, retransmitted %u, crc errors %u, rej %u/%u\n",
+               start, end, interval.counters.txBytes / seconds, interval.counters.rxBytes / seconds,
+               static_cast<unsigned long long>(interval.counters.lostMessages), interval.stats.retransmissions,
+               interval.stats.crc_errors, interval.stats.rej_sent, interval.stats.rej_received);
+        fflush(stdout);
+    }
+}
+
+static void printStatsJson(const tiny_fd_stats_t &stats)
+{
+    printf("{\"tx_i_frames\": %u, \"tx_bytes\": %u, \"rx_i_frames\": %u, \"rx_bytes\": %u, "
+           "\"retransmissions\": %u, \"retry_timeouts\": %u, \"rej_sent\": %u, \"rej_received\": %u, "
+           "\"out_of_order\": %u, \"crc_errors\": %u}",
+           stats.tx_i_frames, stats.tx_bytes, stats.rx_i_frames, stats.rx_bytes, stats.retransmissions,
+           stats.retry_timeouts, stats.rej_sent, stats.rej_received, stats.out_of_order, stats.crc_errors);
+}
+
+void LinkPerf::printSummary(double duration, const tiny_fd_stats_t &stats)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    double seconds = duration > 0 ? duration : 1.0;
+    if ( !m_config.json )
+    {
+        printf("Summary: %.1f s, tx %llu messages (%.0f B/s), rx %llu messages (%.0f B/s), lost %llu\n", duration,
+               static_cast<unsigned long long>(m_total.txMessages), m_total.txBytes / seconds,
+               static_cast<unsigned long long>(m_total.rxMessages), m_total.rxBytes / seconds,
+               static_cast<unsigned long long>(m_total.lostMessages));
+        printf("Protocol: %u I-frames sent, %u retransmitted, %u retry timeouts, %u crc errors, %u out of order\n",
+               stats.tx_i_frames, stats.retransmissions, stats.retry_timeouts, stats.crc_errors, stats.out_of_order);
+        return;
+    }
+    static const char *distributions[] = {"fixed", "uniform", "exp"};
+    printf("{\n  \"config\": {\"server\": %s, \"bidirectional\": %s, \"streams\": %d, \"distribution\": \"%s\", "
+           "\"min_size\": %d, \"max_size\": %d, \"rate\": %u, \"duration\": %d, \"interval\": %d},\n",
+           m_config.server ? "true" : "false", m_config.bidirectional ? "true" : "false", m_config.streams,
+           distributions[static_cast<int>(m_config.distribution)], m_config.minSize, m_config.maxSize,
+           m_config.rate, m_config.duration, m_config.interval);
+    printf("  \"duration\": %.3f,\n", duration);
+    printf("  \"tx\": {\"messages\": %llu, \"bytes\": %llu, \"goodput\": %.0f},\n",
+           static_cast<unsigned long long>(m_total.txMessages), static_cast<unsigned long long>(m_total.txBytes),
+           m_total.txBytes / seconds);
+    printf("  \"rx\": {\"messages\": %llu, \"bytes\": %llu, \"goodput\": %.0f, \"lost\": %llu},\n",
+           static_cast<unsigned long long>(m_total.rxMessages), static_cast<unsigned long long>(m_total.rxBytes),
+           m_total.rxBytes / seconds, static_cast<unsigned long long>(m_total.lostMessages));
+    printf("  \"streams\": [");
+    bool first = true;
+    for ( size_t i = 0; i < m_streams.size(); i++ )
+    {
+        const Counters &c = m_streams[i].counters;
+        if ( !c.txMessages && !c.rxMessages )
+        {
+            continue;
+        }
+        printf("%s\n    {\"id\": %d, \"tx_messages\": %llu, \"tx_bytes\": %llu, \"rx_messages\": %llu, "
+               "\"rx_bytes\": %llu, \"lost\": %llu}",
+               first ? "" : ",", static_cast<int>(i), static_cast<unsigned long long>(c.txMessages),
+               static_cast<unsigned long long>(c.txBytes), static_cast<unsigned long long>(c.rxMessages),
+               static_cast<unsigned long long>(c.rxBytes), static_cast<unsigned long long>(c.lostMessages));
+        first = false;
+    }
+    printf("\n  ],\n  \"intervals\": [");
+    for ( size_t i = 0; i < m_intervals.size(); i++ )
+    {
+        const Interval &interval = m_intervals[i];
+        double length = interval.end > interval.start ? interval.end - interval.start : 1.0;
+        printf("%s\n    {\"start\": %.3f, \"end\": %.3f, \"tx_goodput\": %.0f, \"rx_goodput\": %.0f, \"lost\": %llu, "
+               "\"protocol\": ",
+               i ? "," : "", interval.start, interval.end, interval.counters.txBytes / length,
+               interval.counters.rxBytes / length, static_cast<unsigned long long>(interval.counters.lostMessages));
+        printStatsJson(interval.stats);
+        printf("}");
+    }
+    printf("\n  ],\n  \"protocol\": ");
+    printStatsJson(stats);
+    printf("\n}\n");
+}
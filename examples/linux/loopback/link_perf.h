@@ -0,0 +1,115 @@
+/*
+    Copyright 2022 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "tinyproto.h"
+
+#include <stdint.h>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+enum class size_distribution_t : uint8_t
+{
+    FIXED = 0,
+    UNIFORM = 1,
+    EXPONENTIAL = 2,
+};
+
+struct LinkPerfConfig
+{
+    /** Server sends only in bidirectional mode, client always sends */
+    bool server = false;
+    bool bidirectional = false;
+    /** Number of logical streams, multiplexed over the link */
+    int streams = 1;
+    size_distribution_t distribution = size_distribution_t::FIXED;
+    /** Minimum and maximum message size in bytes, including 5-byte stream header */
+    int minSize = 8;
+    int maxSize = 32;
+    /** Sending rate in bytes per second, 0 for unpaced sender */
+    uint32_t rate = 0;
+    int duration = 15;
+    int interval = 1;
+    bool json = false;
+};
+
+/**
+ * Link performance test, like iperf: sends messages of several streams over Proto, counts
+ * received messages of remote streams, and reports goodput together with protocol counters
+ * every interval. Both sides of the link run the test with the same parameters.
+ */
+class LinkPerf
+{
+public:
+    LinkPerf(tinyproto::Proto &proto, const LinkPerfConfig &config, std::function<tiny_fd_stats_t()> stats);
+
+    /** Must be called for each received message, see Proto::setRxCallback() */
+    void onReceive(tinyproto::IPacket &packet);
+
+    /** Runs the test for configured duration, and prints reports to stdout */
+    int run(const bool &terminate);
+
+private:
+    struct Counters
+    {
+        uint64_t txMessages = 0;
+        uint64_t txBytes = 0;
+        uint64_t rxMessages = 0;
+        uint64_t rxBytes = 0;
+        uint64_t lostMessages = 0;
+    };
+
+    struct Stream
+    {
+        uint32_t txSeq = 0;
+        uint32_t rxSeq = 0;
+        Counters counters;
+    };
+
+    struct Interval
+    {
+        double start;
+        double end;
+        Counters counters;
+        tiny_fd_stats_t stats;
+    };
+
+    tinyproto::Proto &m_proto;
+    LinkPerfConfig m_config;
+    std::function<tiny_fd_stats_t()> m_stats;
+    std::mutex m_mutex;
+    /** Entries for all 256 stream ids, so the receive callback never reallocates the table */
+    std::vector<Stream> m_streams;
+    Counters m_total;
+    std::vector<Interval> m_intervals;
+    std::mt19937 m_random{1};
+
+    int nextSize();
+
+    bool sendNext(tinyproto::HeapPacket &packet, int stream);
+
+    void report(double start, double end, Counters &last, tiny_fd_stats_t &lastStats);
+
+    void printSummary(double duration, const tiny_fd_stats_t &stats);
+};
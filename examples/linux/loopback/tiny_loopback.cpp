@@ -19,10 +19,15 @@
 
 #include "hal/tiny_serial.h"
 #include "tinyproto.h"
+#include "proto/light/tiny_light.h"
+#include "latency_histogram.h"
+#include "link_perf.h"
+#include "TinyLinkTuner.h"
 #include <stdio.h>
 #include <time.h>
 #include <chrono>
 #include <thread>
+#include <vector>
 
 enum class protocol_type_t : uint8_t
 {
@@ -40,10 +45,22 @@ static int s_windowSize = 7;
 static bool s_terminate = false;
 static bool s_runTest = false;
 static bool s_isArduinoBoard = false;
+static bool s_latencyMode = false;
+static int s_pingCount = 1000;
+static bool s_perfMode = false;
+static LinkPerfConfig s_perfConfig;
+static LinkPerf *s_linkPerf = nullptr;
+static bool s_tuneMode = false;
+static int s_tuneTime = 2;
+static tinyproto::LinkTunerGoal s_tuneGoal = tinyproto::LinkTunerGoal::GOODPUT;
+static int s_tuneMemory = 0;
 static int s_lostRxFrames = 0;
 
 static int s_receivedBytes = 0;
 static int s_sentBytes = 0;
+static bool s_bytewise = false;
+static uint32_t s_ioCalls = 0;
+static tiny_serial_handle_t s_serialPort = TINY_SERIAL_INVALID;
 
 static void print_help()
 {
@@ -54,12 +71,29 @@ static void print_help()
     fprintf(stderr, "                               /dev/ttyS0, /dev/ttyS1 ...  for Linux\n");
     fprintf(stderr, "    -t <proto>, --protocol <proto> type of protocol to use\n");
     fprintf(stderr, "                               fd - full duplex (default)\n");
-    fprintf(stderr, "                               light - full duplex\n");
-    fprintf(stderr, "    -c <crc>, --crc <crc>      crc type: 0, 8, 16, 32\n");
+    fprintf(stderr, "                               light - light protocol, run test compares block and\n");
+    fprintf(stderr, "                                       byte-by-byte transfers\n");
+    fprintf(stderr, "    -c <crc>, --crc <crc>      crc type: 0, 8, 16, 32, 32c\n");
     fprintf(stderr, "    -g, --generator            turn on packet generating\n");
     fprintf(stderr, "    -s, --size                 packet size: 32 (by default)\n");
     fprintf(stderr, "    -w, --window               window size: 7 (by default)\n");
     fprintf(stderr, "    -r, --run-test             run 15 seconds speed test\n");
+    fprintf(stderr, "    -l, --latency              run ping-pong latency test against tiny_loopback in loopback mode\n");
+    fprintf(stderr, "    -n, --count <count>        number of pings for latency test: 1000 (by default)\n");
+    fprintf(stderr, "    -i, --iperf                run link performance test, the remote side runs with --server\n");
+    fprintf(stderr, "        --server               answer link performance test, sends only in bidirectional mode\n");
+    fprintf(stderr, "        --bidir                send traffic in both directions\n");
+    fprintf(stderr, "        --streams <count>      number of streams, multiplexed over the link: 1 (by default)\n");
+    fprintf(stderr, "        --dist <type>          message size distribution: fixed (by default), uniform, exp\n");
+    fprintf(stderr, "        --min-size <size>      minimum message size for uniform and exp distributions: 8\n");
+    fprintf(stderr, "        --rate <bytes/s>       pace sender to the rate, 0 - unpaced (by default)\n");
+    fprintf(stderr, "        --time <seconds>       test duration: 15 (by default)\n");
+    fprintf(stderr, "        --interval <seconds>   report interval: 1 (by default)\n");
+    fprintf(stderr, "        --json                 print JSON summary instead of text reports\n");
+    fprintf(stderr, "        --tune                 probe mtu up to packet size and window against tiny_loopback in\n");
+    fprintf(stderr, "                               loopback mode, and print recommended parameters\n");
+    fprintf(stderr, "        --goal <goal>          what to tune for: goodput (by default), latency\n");
+    fprintf(stderr, "        --memory <bytes>       skip parameters, which require larger tiny_fd buffer\n");
     fprintf(stderr, "    -a, --arduino-tty          delay test start by 2 seconds for Arduino ttyUSB interfaces\n");
 }
 
@@ -87,7 +121,11 @@ static int parse_args(int argc, char *argv[])
         {
             if ( ++i >= argc )
                 return -1;
-            switch ( strtoul(argv[i], nullptr, 10) )
+            if ( !strcmp(argv[i], "32c") || !strcmp(argv[i], "32C") )
+            {
+                s_crc = HDLC_CRC_32C;
+            }
+            else switch ( strtoul(argv[i], nullptr, 10) )
             {
                 case 0: s_crc = HDLC_CRC_OFF; break;
                 case 8: s_crc = HDLC_CRC_8; break;
@@ -128,6 +166,94 @@ static int parse_args(int argc, char *argv[])
         {
             s_runTest = true;
         }
+        else if ( (!strcmp(argv[i], "-l")) || (!strcmp(argv[i], "--latency")) )
+        {
+            s_latencyMode = true;
+            s_loopbackMode = false;
+        }
+        else if ( (!strcmp(argv[i], "-n")) || (!strcmp(argv[i], "--count")) )
+        {
+            if ( ++i >= argc )
+                return -1;
+            s_pingCount = strtoul(argv[i], nullptr, 10);
+            if ( s_pingCount < 1 )
+            {
+                fprintf(stderr, "Number of pings must be positive\n");
+                return -1;
+            }
+        }
+        else if ( (!strcmp(argv[i], "-i")) || (!strcmp(argv[i], "--iperf")) || (!strcmp(argv[i], "--server")) )
+        {
+            s_perfMode = true;
+            s_loopbackMode = false;
+            s_perfConfig.server = !strcmp(argv[i], "--server");
+        }
+        else if ( !strcmp(argv[i], "--tune") )
+        {
+            s_tuneMode = true;
+            s_loopbackMode = false;
+        }
+        else if ( !strcmp(argv[i], "--goal") )
+        {
+            if ( ++i >= argc )
+                return -1;
+            else if ( !strcmp(argv[i], "goodput") )
+                s_tuneGoal = tinyproto::LinkTunerGoal::GOODPUT;
+            else if ( !strcmp(argv[i], "latency") )
+                s_tuneGoal = tinyproto::LinkTunerGoal::LATENCY;
+            else
+                return -1;
+        }
+        else if ( !strcmp(argv[i], "--memory") )
+        {
+            if ( ++i >= argc )
+                return -1;
+            s_tuneMemory = strtoul(argv[i], nullptr, 10);
+        }
+        else if ( !strcmp(argv[i], "--bidir") )
+        {
+            s_perfConfig.bidirectional = true;
+        }
+        else if ( !strcmp(argv[i], "--json") )
+        {
+            s_perfConfig.json = true;
+        }
+        else if ( !strcmp(argv[i], "--dist") )
+        {
+            if ( ++i >= argc )
+                return -1;
+            else if ( !strcmp(argv[i], "fixed") )
+                s_perfConfig.distribution = size_distribution_t::FIXED;
+            else if ( !strcmp(argv[i], "uniform") )
+                s_perfConfig.distribution = size_distribution_t::UNIFORM;
+            else if ( !strcmp(argv[i], "exp") )
+                s_perfConfig.distribution = size_distribution_t::EXPONENTIAL;
+            else
+                return -1;
+        }
+        else if ( !strcmp(argv[i], "--streams") || !strcmp(argv[i], "--min-size") || !strcmp(argv[i], "--rate") ||
+                  !strcmp(argv[i], "--time") || !strcmp(argv[i], "--interval") )
+        {
+            if ( i + 1 >= argc )
+                return -1;
+            unsigned long value = strtoul(argv[i + 1], nullptr, 10);
+            if ( !strcmp(argv[i], "--streams") )
+                s_perfConfig.streams = static_cast<int>(value);
+            else if ( !strcmp(argv[i], "--min-size") )
+                s_perfConfig.minSize = static_cast<int>(value);
+            else if ( !strcmp(argv[i], "--rate") )
+                s_perfConfig.rate = static_cast<uint32_t>(value);
+            else if ( !strcmp(argv[i], "--time") )
+                s_perfConfig.duration = s_tuneTime = static_cast<int>(value);
+            else
+                s_perfConfig.interval = static_cast<int>(value);
+            if ( (value == 0 && strcmp(argv[i], "--rate")) || s_perfConfig.streams > 256 )
+            {
+                fprintf(stderr, "Invalid value for %s\n", argv[i]);
+                return -1;
+            }
+            i++;
+        }
         else if ( (!strcmp(argv[i], "-a")) || (!strcmp(argv[i], "--arduino-tty")) )
         {
             s_isArduinoBoard = true;
@@ -231,13 +357,93 @@ static int runGeneratorMode(tinyproto::Proto &proto)
     return 0;
 }
 
+static const char *crcName(hdlc_crc_t crc)
+{
+    switch ( crc )
+    {
+        case HDLC_CRC_OFF: return "0";
+        case HDLC_CRC_8: return "8";
+        case HDLC_CRC_16: return "16";
+        case HDLC_CRC_32: return "32";
+        case HDLC_CRC_32C: return "32c";
+        default: return "default";
+    }
+}
+
+static int runLatencyMode(tinyproto::Proto &proto)
+{
+    // Pings before the histogram is started let the link connect and warm up
+    const int warmup = 10;
+    const uint32_t timeout = 1000;
+    LatencyHistogram histogram;
+    int lost = 0;
+    tinyproto::HeapPacket outPacket(s_packetSize);
+    for ( int seq = 0; seq < s_pingCount + warmup && !s_terminate; seq++ )
+    {
+        outPacket.clear();
+        outPacket.put(static_cast<uint32_t>(seq));
+        while ( outPacket.size() < s_packetSize )
+            outPacket.put("Ping frame. latency test in progress...");
+        auto startTs = std::chrono::steady_clock::now();
+        if ( !proto.send(outPacket, timeout) )
+        {
+            lost++;
+            continue;
+        }
+        bool received = false;
+        while ( !received && std::chrono::steady_clock::now() - startTs < std::chrono::milliseconds(timeout) )
+        {
+            tinyproto::IPacket *packet = proto.read(timeout);
+            if ( packet )
+            {
+                // Late echoes of lost pings are dropped
+                received = packet->getUint32() == static_cast<uint32_t>(seq);
+                proto.release(packet);
+            }
+        }
+        auto rtt = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTs);
+        if ( !received )
+        {
+            lost++;
+        }
+        else if ( seq >= warmup )
+        {
+            histogram.record(rtt.count());
+        }
+    }
+    printf("\nRound-trip time, us (payload %d bytes, crc %s)\n", s_packetSize, crcName(s_crc));
+    printf("%10s %12s\n", "Percentile", "Value");
+    for ( double p : {50.0, 90.0, 99.0, 99.9, 100.0} )
+    {
+        printf("%10.3f %12llu\n", p, static_cast<unsigned long long>(histogram.percentile(p)));
+    }
+    printf("#[Count = %llu, Lost = %d, Min = %llu, Mean = %.1f, Max = %llu]\n",
+           static_cast<unsigned long long>(histogram.count()), lost, static_cast<unsigned long long>(histogram.min()),
+           histogram.mean(), static_cast<unsigned long long>(histogram.max()));
+    // Single line summary for scripts
+    printf("latency: size=%d crc=%s count=%llu lost=%d p50=%llu p90=%llu p99=%llu p99.9=%llu max=%llu\n",
+           s_packetSize, crcName(s_crc), static_cast<unsigned long long>(histogram.count()), lost,
+           static_cast<unsigned long long>(histogram.percentile(50)),
+           static_cast<unsigned long long>(histogram.percentile(90)),
+           static_cast<unsigned long long>(histogram.percentile(99)),
+           static_cast<unsigned long long>(histogram.percentile(99.9)),
+           static_cast<unsigned long long>(histogram.max()));
+    return 0;
+}
+
+static void onPerfReceive(tinyproto::Proto &proto, tinyproto::IPacket &packet)
+{
+    s_linkPerf->onReceive(packet);
+}
+
 static int run(tiny_serial_handle_t port)
 {
     tinyproto::Proto proto( true );
     tinyproto::ILinkLayer *link = nullptr;
+    tinyproto::SerialFdLink *serial = nullptr;
     if ( s_protocol == protocol_type_t::FD )
     {
-        tinyproto::SerialFdLink *serial = new tinyproto::SerialFdLink( s_port );
+        serial = new tinyproto::SerialFdLink( s_port );
         proto.setLink( *serial );
         serial->setMtu( s_packetSize );
         serial->setCrc( s_crc );
@@ -245,15 +451,6 @@ static int run(tiny_serial_handle_t port)
         serial->setTimeout( 100 );
         link = serial;
     }
-    else if ( s_protocol == protocol_type_t::LIGHT )
-    {
-        tinyproto::SerialHdlcLink *serial = new tinyproto::SerialHdlcLink( s_port );
-        proto.setLink( *serial );
-        serial->setMtu( s_packetSize );
-        serial->setCrc( s_crc );
-        serial->setTimeout( 100 );
-        link = serial;
-    }
     // Wait for additional 1500 ms after opening serial port if communicating with an Arduino
     // Some boards activate bootloader if to send something when board reboots
     if ( s_isArduinoBoard )
@@ -261,6 +458,18 @@ static int run(tiny_serial_handle_t port)
         proto.setTxDelay( 1500 );
     }
 
+    if ( s_perfMode )
+    {
+        if ( serial == nullptr )
+        {
+            fprintf(stderr, "Link performance test is supported only for fd protocol\n");
+            return -1;
+        }
+        // The test object must outlive the protocol, since callback can be called until proto.end()
+        s_perfConfig.maxSize = s_packetSize;
+        s_linkPerf = new LinkPerf(proto, s_perfConfig, [serial]() { return serial->getStats(); });
+        proto.setRxCallback( onPerfReceive );
+    }
     tinyproto::HeapPacket packet1(s_packetSize);
     tinyproto::HeapPacket packet2(s_packetSize);
     proto.addRxPool( packet1 );
@@ -276,15 +485,241 @@ static int run(tiny_serial_handle_t port)
 
     if ( s_loopbackMode )
         runLoopBackMode( proto );
+    else if ( s_latencyMode )
+        runLatencyMode( proto );
+    else if ( s_perfMode )
+        s_linkPerf->run( s_terminate );
     else
         runGeneratorMode( proto );
 
     proto.end();
     s_lostRxFrames = proto.getLostRxFrames();
+    delete s_linkPerf;
+    s_linkPerf = nullptr;
     delete link;
     return 0;
 }
 
+//================================== TUNE ======================================
+
+/** Sends messages of mtu size to tiny_loopback in loopback mode, and measures echoed bytes and round trip time */
+static bool probeLink(void *arg, const tinyproto::LinkTunerParams &params, tinyproto::LinkTunerResult &result)
+{
+    tinyproto::Proto proto( true );
+    tinyproto::SerialFdLink serial( s_port );
+    proto.setLink( serial );
+    serial.setMtu( params.mtu );
+    serial.setCrc( params.crc );
+    serial.setWindow( params.window );
+    serial.setTimeout( 100 );
+    tinyproto::HeapPacket packet1(params.mtu);
+    tinyproto::HeapPacket packet2(params.mtu);
+    proto.addRxPool( packet1 );
+    proto.addRxPool( packet2 );
+    if ( !proto.begin() )
+    {
+        return false;
+    }
+    LatencyHistogram histogram;
+    tinyproto::HeapPacket outPacket(params.mtu);
+    uint64_t received = 0;
+    uint64_t sent = 0;
+    // The link reconnects for each probe, so measurements start after the first echo and the warmup
+    const double warmup = 0.5;
+    double measureStart = -1;
+    auto startTs = std::chrono::steady_clock::now();
+    for ( ;; )
+    {
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTs).count();
+        if ( s_terminate || (measureStart < 0 && elapsed >= 3.0) ||
+             (measureStart >= 0 && elapsed >= measureStart + s_tuneTime) )
+        {
+            break;
+        }
+        bool paced = s_perfConfig.rate && sent >= s_perfConfig.rate * elapsed;
+        tinyproto::IPacket *packet = proto.read( paced ? 1 : 0 );
+        if ( packet )
+        {
+            if ( measureStart < 0 )
+            {
+                measureStart = elapsed + warmup;
+            }
+            else if ( elapsed >= measureStart && packet->size() >= static_cast<int>(sizeof(uint32_t)) )
+            {
+                histogram.record(static_cast<uint32_t>(tiny_micros() - packet->getUint32()));
+                received += packet->size();
+            }
+            proto.release( packet );
+        }
+        if ( !paced )
+        {
+            outPacket.clear();
+            outPacket.put(static_cast<uint32_t>(tiny_micros()));
+            while ( outPacket.size() < params.mtu )
+                outPacket.put(static_cast<uint8_t>(outPacket.size()));
+            if ( proto.send(outPacket, 20) )
+            {
+                sent += outPacket.size();
+            }
+        }
+    }
+    // Let the remote side echo the frames in flight, so they don't confuse the next probe
+    auto drainTs = std::chrono::steady_clock::now();
+    while ( std::chrono::steady_clock::now() - drainTs < std::chrono::milliseconds(300) )
+    {
+        tinyproto::IPacket *packet = proto.read( 10 );
+        if ( packet )
+        {
+            proto.release( packet );
+        }
+    }
+    proto.end();
+    result.goodput = static_cast<uint32_t>(received / s_tuneTime);
+    result.latencyP99 = static_cast<uint32_t>(histogram.percentile(99));
+    return received > 0;
+}
+
+static void printTuneResult(void *arg, const tinyproto::LinkTunerResult &result)
+{
+    if ( !result.valid )
+    {
+        printf("%6d %6d %4s %8d %12s %12s\n", result.params.mtu, result.params.window, crcName(result.params.crc),
+               result.memory, "-", "-");
+    }
+    else
+    {
+        printf("%6d %6d %4s %8d %12u %12u\n", result.params.mtu, result.params.window, crcName(result.params.crc),
+               result.memory, result.goodput, result.latencyP99);
+    }
+    fflush(stdout);
+}
+
+static int runTuneMode()
+{
+    static const int mtus[] = {32, 64, 128, 256, 512, 1024, 1500};
+    static const uint8_t windows[] = {2, 3, 4, 5, 6, 7};
+    // Remote side accepts frames up to its packet size, and must use the same crc
+    int mtuCount = 0;
+    while ( mtuCount < static_cast<int>(sizeof(mtus) / sizeof(mtus[0])) && mtus[mtuCount] <= s_packetSize )
+    {
+        mtuCount++;
+    }
+    tinyproto::LinkTuner tuner(probeLink, nullptr);
+    tuner.setMtus(mtus, mtuCount);
+    tuner.setWindows(windows, sizeof(windows));
+    tuner.setCrcs(&s_crc, 1);
+    tuner.setGoal(s_tuneGoal);
+    tuner.setMemoryLimit(s_tuneMemory);
+    tuner.setResultCallback(printTuneResult);
+    printf("%6s %6s %4s %8s %12s %12s\n", "mtu", "window", "crc", "memory", "echo,B/s", "p99 rtt,us");
+    if ( tuner.run() == 0 )
+    {
+        fprintf(stderr, "No echo from remote side, is tiny_loopback running in loopback mode?\n");
+        return -1;
+    }
+    const tinyproto::LinkTunerResult &best = tuner.getBest();
+    printf("\nRecommended: -s %d -w %u -c %s, echo %u B/s, p99 round trip %u us, tiny_fd buffer %d bytes\n",
+           best.params.mtu, best.params.window, crcName(best.params.crc), best.goodput, best.latencyP99,
+           best.memory);
+    return 0;
+}
+
+//================================== LIGHT ======================================
+
+static int lightWrite(void *pdata, const void *buffer, int size)
+{
+    s_ioCalls++;
+    // Byte-by-byte mode shows the cost of passing each byte to the serial port separately
+    return tiny_serial_send(s_serialPort, buffer, s_bytewise ? 1 : size);
+}
+
+static int lightRead(void *pdata, void *buffer, int size)
+{
+    s_ioCalls++;
+    return tiny_serial_read(s_serialPort, buffer, s_bytewise ? 1 : size);
+}
+
+static void runLight(int seconds)
+{
+    STinyLightData light{};
+    light.crc_type = s_crc;
+    tiny_light_init(&light, lightWrite, lightRead, nullptr);
+    // Received frame contains crc field, so reserve space for it
+    std::vector<uint8_t> buffer(s_packetSize + 4);
+    auto startTs = std::chrono::steady_clock::now();
+    while ( !s_terminate )
+    {
+        if ( s_loopbackMode )
+        {
+            int len = tiny_light_read(&light, buffer.data(), static_cast<int>(buffer.size()));
+            if ( len > 0 )
+            {
+                s_receivedBytes += len;
+                if ( tiny_light_send(&light, buffer.data(), len) > 0 )
+                {
+                    s_sentBytes += len;
+                }
+            }
+        }
+        else
+        {
+            for ( int i = 0; i < s_packetSize; i++ )
+            {
+                buffer[i] = static_cast<uint8_t>("Generated frame. test in progress..."[i % 36]);
+            }
+            if ( tiny_light_send(&light, buffer.data(), s_packetSize) > 0 )
+            {
+                s_sentBytes += s_packetSize;
+            }
+            int len = tiny_light_read(&light, buffer.data(), static_cast<int>(buffer.size()));
+            if ( len > 0 )
+            {
+                s_receivedBytes += len;
+            }
+        }
+        if ( seconds && std::chrono::steady_clock::now() - startTs >= std::chrono::seconds(seconds) )
+        {
+            break;
+        }
+    }
+    tiny_light_close(&light);
+}
+
+static int runLightTest()
+{
+    s_serialPort = tiny_serial_open(s_port, 115200);
+    if ( s_serialPort == TINY_SERIAL_INVALID )
+    {
+        fprintf(stderr, "Failed to open serial port %s\n", s_port);
+        return -1;
+    }
+    if ( s_isArduinoBoard )
+    {
+        tiny_sleep( 1500 );
+    }
+    if ( !s_runTest )
+    {
+        runLight( 0 );
+    }
+    else
+    {
+        // Each transfer mode runs for the half of test time
+        for ( bool bytewise: {false, true} )
+        {
+            s_bytewise = bytewise;
+            s_sentBytes = 0;
+            s_receivedBytes = 0;
+            s_ioCalls = 0;
+            runLight( 7 );
+            printf("\n%s transfers: TX speed %u bps, RX speed %u bps, read/write calls per frame %.1f\n",
+                   bytewise ? "Byte-by-byte" : "Block", s_sentBytes * 8 / 7, s_receivedBytes * 8 / 7,
+                   s_sentBytes ? static_cast<double>(s_ioCalls) * s_packetSize / s_sentBytes : 0.0);
+        }
+    }
+    tiny_serial_close(s_serialPort);
+    return 0;
+}
+
 int main(int argc, char *argv[])
 {
     if ( parse_args(argc, argv) < 0 )
@@ -293,7 +728,12 @@ int main(int argc, char *argv[])
         return 1;
     }
 
-    int result = run( -1 );
+    if ( s_protocol == protocol_type_t::LIGHT )
+    {
+        return runLightTest();
+    }
+
+    int result = s_tuneMode ? runTuneMode() : run( -1 );
 
     if ( s_runTest )
     {
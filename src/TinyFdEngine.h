@@ -0,0 +1,278 @@
+/*
+    Copyright 2022 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    GNU General Public License Usage
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Commercial License Usage
+
+    Licensees holding valid commercial Tiny Protocol licenses may use this file in
+    accordance with the commercial license agreement provided in accordance with
+    the terms contained in a written agreement between you and Alexey Dynda.
+    For further information contact via email on github account.
+*/
+
+/**
+ This is Tiny protocol full duplex engine with parameters fixed at compile time
+
+ @file
+ @brief Tiny protocol Full Duplex API with compile-time parameters
+
+*/
+
+#pragma once
+
+#include "proto/fd/tiny_fd.h"
+
+#include <stdint.h>
+
+namespace tinyproto
+{
+
+/**
+ * @ingroup FULL_DUPLEX_API
+ * @{
+ */
+
+/**
+ * FdEngine is header-only full duplex protocol wrapper, which fixes mtu, window size and crc type
+ * at compile time. Unlike Fd<S>, the buffer is sized by FD_BUF_SIZE_EX() for specified parameters,
+ * invalid parameters are rejected by static_assert, and the application callbacks are methods of
+ * the Transport policy class. The protocol itself, including crc calculation and byte stuffing,
+ * runs in the tiny_fd C implementation.
+ *
+ * Transport policy class must provide the following methods:
+ *   - int read(void *buf, int len) - non-blocking read, returns number of bytes read or negative error code
+ *   - int write(const void *buf, int len) - returns number of bytes written or negative error code
+ *   - void onReceive(uint8_t addr, uint8_t *data, int len) - called for each received frame
+ *   - void onConnectEvent(uint8_t addr, bool connected) - called on connect/disconnect events
+ *
+ * @tparam Mtu maximum size of user payload
+ * @tparam Window number of frames, which confirmation may be deferred for (2 - 7)
+ * @tparam Crc crc type, HDLC_CRC_DEFAULT is not allowed
+ * @tparam Transport policy class
+ */
+template <int Mtu, int Window, hdlc_crc_t Crc, typename Transport> class FdEngine
+{
+public:
+    static_assert(Mtu > 0, "Mtu must be positive");
+    static_assert(Window >= 2 && Window <= 7, "Window must be in range 2 - 7");
+    static_assert(Crc == HDLC_CRC_8 || Crc == HDLC_CRC_16 || Crc == HDLC_CRC_32 || Crc == HDLC_CRC_32C ||
+                      Crc == HDLC_CRC_OFF,
+                  "Crc type must be specified explicitly");
+
+    /** Size of protocol control data region */
+    static constexpr int FD_DATA_SIZE = static_cast<int>(TINY_FD_DATA_REGION_SIZE);
+
+    /** Size of I-frames queue region */
+    static constexpr int I_QUEUE_SIZE = static_cast<int>(TINY_FD_I_QUEUE_REGION_SIZE(Mtu, Window, 0));
+
+    /** Size of S- and U-frames queue region */
+    static constexpr int S_QUEUE_SIZE = static_cast<int>(TINY_FD_S_QUEUE_REGION_SIZE);
+
+    /** Size of peers region */
+    static constexpr int PEERS_SIZE = static_cast<int>(TINY_FD_PEERS_REGION_SIZE(1));
+
+    /** Size of hdlc low level region with rx ring */
+    static constexpr int RX_RING_SIZE = static_cast<int>(TINY_FD_RX_RING_REGION_SIZE(Mtu, Crc, 1));
+
+    /** Size of the buffer, required by the protocol. The buffer is aligned, so no padding is needed */
+    static constexpr int BUFFER_SIZE = static_cast<int>(TINY_FD_LAYOUT_SIZE(1, Mtu, Window, Crc, 1));
+
+    static_assert(BUFFER_SIZE == FD_DATA_SIZE + I_QUEUE_SIZE + S_QUEUE_SIZE + PEERS_SIZE + RX_RING_SIZE,
+                  "Layout regions do not match buffer size");
+
+    static_assert(static_cast<uint32_t>(BUFFER_SIZE) <= static_cast<tiny_buf_size_t>(~0u),
+                  "Too large Mtu and Window for tiny_fd buffer, enable CONFIG_TINY_LARGE_BUFFERS");
+
+    FdEngine() = default;
+
+    /**
+     * Creates engine with copy of transport object
+     * @param transport transport to use
+     */
+    explicit FdEngine(const Transport &transport)
+        : m_transport(transport)
+    {
+    }
+
+    ~FdEngine()
+    {
+        end();
+    }
+
+    FdEngine(const FdEngine &) = delete;
+
+    FdEngine &operator=(const FdEngine &) = delete;
+
+    /**
+     * Initializes protocol internal variables.
+     * @return TINY_SUCCESS or negative error code
+     */
+    int begin()
+    {
+        tiny_fd_init_t init{};
+        init.pdata = this;
+        init.on_read_cb = onReceiveInternal;
+        init.on_connect_event_cb = onConnectEventInternal;
+        init.buffer = m_buffer;
+        init.buffer_size = BUFFER_SIZE;
+        init.window_frames = Window;
+        init.mtu = Mtu;
+        init.send_timeout = m_sendTimeout;
+        init.retry_timeout = m_retryTimeout;
+        init.retries = 2;
+        init.crc_type = Crc;
+        init.mode = TINY_FD_MODE_ABM;
+        return tiny_fd_init(&m_handle, &init);
+    }
+
+    /**
+     * Resets protocol state.
+     */
+    void end()
+    {
+        if ( m_handle )
+        {
+            tiny_fd_close(m_handle);
+            m_handle = nullptr;
+        }
+    }
+
+    /**
+     * Sends data block over communication channel.
+     * @param buf data to send
+     * @param size length of the data in bytes, must not exceed Mtu
+     * @return TINY_SUCCESS or negative error code
+     */
+    int write(const void *buf, int size)
+    {
+        return tiny_fd_send_packet(m_handle, buf, size, m_sendTimeout);
+    }
+
+    /**
+     * Reads data from the transport by blocks of TINY_FD_RX_BLOCK_SIZE bytes
+     * until the transport returns less than requested.
+     * @return number of bytes received or negative error code
+     */
+    int run_rx()
+    {
+        uint8_t buf[TINY_FD_RX_BLOCK_SIZE];
+        return tiny_fd_run_rx_ex(m_handle, readInternal, this, buf, sizeof(buf));
+    }
+
+    /**
+     * Generates tx data by blocks of TINY_FD_TX_BLOCK_SIZE bytes and writes them to the transport
+     * until there is nothing to send or the transport accepts less than requested.
+     * @param timeout time in milliseconds to wait for the first block of data
+     * @return number of bytes sent or negative error code
+     */
+    int run_tx(uint32_t timeout = 0)
+    {
+        uint8_t buf[TINY_FD_TX_BLOCK_SIZE];
+        return tiny_fd_run_tx_ex(m_handle, writeInternal, this, buf, sizeof(buf), timeout);
+    }
+
+    /**
+     * Sets send timeout in milliseconds. Use this function only before begin() call.
+     * @param timeout timeout in milliseconds
+     */
+    void setSendTimeout(uint16_t timeout)
+    {
+        m_sendTimeout = timeout;
+    }
+
+    /**
+     * Sets retry timeout in milliseconds. Use this function only before begin() call.
+     * @param timeout timeout in milliseconds
+     */
+    void setRetryTimeout(uint16_t timeout)
+    {
+        m_retryTimeout = timeout;
+    }
+
+    /**
+     * Returns transport object
+     */
+    Transport &transport()
+    {
+        return m_transport;
+    }
+
+    /**
+     * Returns low-level handle for full duplex protocol
+     */
+    tiny_fd_handle_t getHandle()
+    {
+        return m_handle;
+    }
+
+    /**
+     * Returns status of the protocol
+     */
+    int getStatus()
+    {
+        return tiny_fd_get_status(m_handle);
+    }
+
+    /**
+     * Returns protocol counters: sent and received I-frames, retransmissions, crc errors, etc.
+     */
+    tiny_fd_stats_t getStats()
+    {
+        tiny_fd_stats_t stats{};
+        tiny_fd_get_stats(m_handle, &stats);
+        return stats;
+    }
+
+private:
+    TINY_ALIGNED_STRUCT uint8_t m_buffer[BUFFER_SIZE]{};
+
+    tiny_fd_handle_t m_handle = nullptr;
+
+    Transport m_transport{};
+
+    uint16_t m_sendTimeout = 1000;
+
+    uint16_t m_retryTimeout = 200;
+
+    static void onReceiveInternal(void *udata, uint8_t addr, uint8_t *pdata, int size)
+    {
+        static_cast<FdEngine *>(udata)->m_transport.onReceive(addr, pdata, size);
+    }
+
+    static void onConnectEventInternal(void *udata, uint8_t addr, bool connected)
+    {
+        static_cast<FdEngine *>(udata)->m_transport.onConnectEvent(addr, connected);
+    }
+
+    static int readInternal(void *udata, void *buf, int len)
+    {
+        return static_cast<FdEngine *>(udata)->m_transport.read(buf, len);
+    }
+
+    static int writeInternal(void *udata, const void *buf, int len)
+    {
+        return static_cast<FdEngine *>(udata)->m_transport.write(buf, len);
+    }
+};
+
+/**
+ * @}
+ */
+
+} // namespace tinyproto
@@ -0,0 +1,453 @@
+/*
+    Copyright 2022 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    GNU General Public License Usage
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Commercial License Usage
+
+    Licensees holding valid commercial Tiny Protocol licenses may use this file in
+    accordance with the commercial license agreement provided in accordance with
+    the terms contained in a written agreement between you and Alexey Dynda.
+    For further information contact via email on github account.
+*/
+
+#include "TinyFdReactor.h"
+
+#if defined(__linux__) && !defined(ARDUINO)
+
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+
+namespace tinyproto
+{
+
+enum : uint32_t
+{
+    REACTOR_TIMER_TOKEN = 0xFFFFFFFF,
+    REACTOR_WAKEUP_TOKEN = 0xFFFFFFFE,
+    REACTOR_NOTIFY_FLAG = 0x80000000,
+};
+
+static const int REACTOR_MAX_EVENTS = 32;
+
+FdReactor::FdReactor()
+{
+    m_epoll = epoll_create1(EPOLL_CLOEXEC);
+    m_timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    m_wakeup = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    tiny_timer_wheel_init(&m_wheel, tiny_millis());
+    struct epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.u32 = REACTOR_TIMER_TOKEN;
+    epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_timer, &event);
+    event.data.u32 = REACTOR_WAKEUP_TOKEN;
+    epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_wakeup, &event);
+}
+
+FdReactor::~FdReactor()
+{
+    for ( uint32_t index = 0; index < m_links.size(); index++ )
+    {
+        if ( m_links[index] != nullptr )
+        {
+            closeLink(index);
+        }
+    }
+    close(m_wakeup);
+    close(m_timer);
+    close(m_epoll);
+}
+
+bool FdReactor::add(tiny_fd_handle_t handle, int fd)
+{
+    if ( m_epoll < 0 || !handle || fd < 0 )
+    {
+        return false;
+    }
+    int flags = fcntl(fd, F_GETFL, 0);
+    if ( flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0 )
+    {
+        return false;
+    }
+    Link *link = new Link();
+    link->reactor = this;
+    link->handle = handle;
+    link->fd = fd;
+    link->notify = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    tiny_timer_init(&link->timer, onDeadline, link);
+    link->waitOut = false;
+    link->txPos = 0;
+    link->txLen = 0;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    uint32_t index = 0;
+    while ( index < m_links.size() && m_links[index] != nullptr )
+    {
+        index++;
+    }
+    struct epoll_event event = {};
+    event.events = EPOLLIN | EPOLLRDHUP;
+    event.data.u32 = index;
+    if ( link->notify < 0 || epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &event) < 0 )
+    {
+        close(link->notify);
+        delete link;
+        return false;
+    }
+    event.data.u32 = index | REACTOR_NOTIFY_FLAG;
+    epoll_ctl(m_epoll, EPOLL_CTL_ADD, link->notify, &event);
+    link->index = index;
+    if ( index == m_links.size() )
+    {
+        m_links.push_back(link);
+    }
+    else
+    {
+        m_links[index] = link;
+    }
+    tiny_fd_set_tx_ready_cb(handle, onTxReady, link);
+    // Force the reactor to run tx path and to calculate the first deadline for the handle
+    onTxReady(link);
+    return true;
+}
+
+void FdReactor::remove(tiny_fd_handle_t handle)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for ( uint32_t index = 0; index < m_links.size(); index++ )
+    {
+        if ( m_links[index] != nullptr && m_links[index]->handle == handle )
+        {
+            closeLink(index);
+            break;
+        }
+    }
+}
+
+int FdReactor::size()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    int count = 0;
+    for ( auto link: m_links )
+    {
+        count += link != nullptr ? 1 : 0;
+    }
+    return count;
+}
+
+void FdReactor::closeLink(uint32_t index)
+{
+    tiny_fd_set_tx_ready_cb(m_links[index]->handle, nullptr, nullptr);
+    tiny_timer_stop(&m_wheel, &m_links[index]->timer);
+    epoll_ctl(m_epoll, EPOLL_CTL_DEL, m_links[index]->fd, nullptr);
+    epoll_ctl(m_epoll, EPOLL_CTL_DEL, m_links[index]->notify, nullptr);
+    close(m_links[index]->notify);
+    delete m_links[index];
+    m_links[index] = nullptr;
+}
+
+int FdReactor::runOnce(int timeoutMs)
+{
+    struct epoll_event events[REACTOR_MAX_EVENTS];
+    int count = epoll_wait(m_epoll, events, REACTOR_MAX_EVENTS, timeoutMs);
+    if ( count < 0 )
+    {
+        return errno == EINTR ? 0 : -1;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // Expired deadlines are served first, the timer wheel is advanced on every wake up
+    tiny_timer_wheel_advance(&m_wheel, tiny_millis());
+    for ( int i = 0; i < count; i++ )
+    {
+        uint32_t token = events[i].data.u32;
+        if ( token == REACTOR_TIMER_TOKEN )
+        {
+            onTimer();
+        }
+        else if ( token == REACTOR_WAKEUP_TOKEN )
+        {
+            onWakeup();
+        }
+        else if ( token & REACTOR_NOTIFY_FLAG )
+        {
+            token &= ~REACTOR_NOTIFY_FLAG;
+            if ( token < m_links.size() && m_links[token] != nullptr )
+            {
+                uint64_t value;
+                if ( read(m_links[token]->notify, &value, sizeof(value)) > 0 && !m_links[token]->waitOut )
+                {
+                    runTx(m_links[token]);
+                }
+            }
+        }
+        else if ( token < m_links.size() && m_links[token] != nullptr )
+        {
+            Link *link = m_links[token];
+            bool alive = (events[i].events & EPOLLIN) ? runRx(link) : true;
+            if ( !alive || (events[i].events & (EPOLLERR | EPOLLHUP | EPOLLRDHUP)) )
+            {
+                // Peer is gone, stop polling the descriptor to avoid busy loop
+                closeLink(token);
+                continue;
+            }
+            // Received frames usually require confirmation, so check tx side also
+            runTx(link);
+        }
+    }
+    armTimer();
+    return count;
+}
+
+void FdReactor::run()
+{
+    m_stop = false;
+    while ( !m_stop )
+    {
+        if ( runOnce(-1) < 0 )
+        {
+            break;
+        }
+    }
+}
+
+void FdReactor::stop()
+{
+    m_stop = true;
+    uint64_t value = 1;
+    if ( write(m_wakeup, &value, sizeof(value)) < 0 )
+    {
+        // Counter overflow is not possible here, so nothing to do
+    }
+}
+
+void FdReactor::onTimer()
+{
+    uint64_t expirations;
+    if ( read(m_timer, &expirations, sizeof(expirations)) < 0 )
+    {
+        return;
+    }
+    // Expired timers are already processed by the timer wheel
+}
+
+void FdReactor::onDeadline(void *arg)
+{
+    Link *link = static_cast<Link *>(arg);
+    // Tx path of tiny_fd is responsible for retries and keep alive frames.
+    // Links waiting for EPOLLOUT will be served, when the descriptor becomes writable
+    if ( !link->waitOut )
+    {
+        link->reactor->runTx(link);
+    }
+}
+
+void FdReactor::armTimer()
+{
+    uint32_t next = tiny_timer_wheel_next_expiry(&m_wheel);
+    struct itimerspec spec = {};
+    if ( next != 0xFFFFFFFF )
+    {
+        // The wheel counts ticks from the last processed tick, which is m_wheel.now - 1
+        int32_t timeout = static_cast<int32_t>(m_wheel.now - 1 + next - tiny_millis());
+        // Zero value disarms the timer, so at least 1 ms is used
+        timeout = timeout < 1 ? 1 : timeout;
+        spec.it_value.tv_sec = timeout / 1000;
+        spec.it_value.tv_nsec = (timeout % 1000) * 1000000L;
+    }
+    timerfd_settime(m_timer, 0, &spec, nullptr);
+}
+
+void FdReactor::updateDeadline(Link *link)
+{
+    uint32_t deadline = tiny_fd_get_next_deadline(link->handle);
+    if ( deadline == 0xFFFFFFFF )
+    {
+        tiny_timer_stop(&m_wheel, &link->timer);
+    }
+    else
+    {
+        tiny_timer_start(&m_wheel, &link->timer, tiny_millis() + deadline);
+    }
+}
+
+void FdReactor::onTxReady(void *arg)
+{
+    Link *link = static_cast<Link *>(arg);
+    uint64_t value = 1;
+    if ( write(link->notify, &value, sizeof(value)) < 0 )
+    {
+        // eventfd counter is already non-zero, the reactor will be woken up anyway
+    }
+}
+
+void FdReactor::onWakeup()
+{
+    uint64_t value;
+    if ( read(m_wakeup, &value, sizeof(value)) < 0 )
+    {
+        return;
+    }
+}
+
+bool FdReactor::runRx(Link *link)
+{
+    uint8_t buf[512];
+    for ( ;; )
+    {
+        ssize_t len = read(link->fd, buf, sizeof(buf));
+        if ( len == 0 )
+        {
+            // End of file: the descriptor will stay readable forever
+            return false;
+        }
+        if ( len < 0 )
+        {
+            if ( errno == EINTR )
+            {
+                continue;
+            }
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        tiny_fd_on_rx_data(link->handle, buf, static_cast<int>(len));
+        if ( len < static_cast<ssize_t>(sizeof(buf)) )
+        {
+            return true;
+        }
+    }
+}
+
+void FdReactor::runTx(Link *link)
+{
+    for ( ;; )
+    {
+        if ( link->txPos == link->txLen )
+        {
+            int len = tiny_fd_get_tx_data(link->handle, link->txBuf, sizeof(link->txBuf), 0);
+            if ( len <= 0 )
+            {
+                break;
+            }
+            link->txPos = 0;
+            link->txLen = len;
+        }
+        ssize_t result = write(link->fd, link->txBuf + link->txPos, link->txLen - link->txPos);
+        if ( result < 0 )
+        {
+            if ( errno == EAGAIN || errno == EWOULDBLOCK )
+            {
+                // Wait until the descriptor is writable again
+                setWaitOut(link, true);
+            }
+            return;
+        }
+        link->txPos += static_cast<int>(result);
+    }
+    setWaitOut(link, false);
+    updateDeadline(link);
+}
+
+void FdReactor::setWaitOut(Link *link, bool enable)
+{
+    if ( link->waitOut != enable )
+    {
+        struct epoll_event event = {};
+        event.events = enable ? (EPOLLIN | EPOLLRDHUP | EPOLLOUT) : (EPOLLIN | EPOLLRDHUP);
+        event.data.u32 = link->index;
+        epoll_ctl(m_epoll, EPOLL_CTL_MOD, link->fd, &event);
+        link->waitOut = enable;
+    }
+}
+
+FdReactorGroup::FdReactorGroup(int threads)
+{
+    if ( threads <= 0 )
+    {
+        threads = static_cast<int>(std::thread::hardware_concurrency());
+    }
+    if ( threads <= 0 )
+    {
+        threads = 1;
+    }
+    for ( int i = 0; i < threads; i++ )
+    {
+        m_reactors.push_back(new FdReactor());
+    }
+}
+
+FdReactorGroup::~FdReactorGroup()
+{
+    end();
+    for ( auto reactor: m_reactors )
+    {
+        delete reactor;
+    }
+}
+
+void FdReactorGroup::begin()
+{
+    if ( !m_threads.empty() )
+    {
+        return;
+    }
+    for ( auto reactor: m_reactors )
+    {
+        m_threads.push_back(new std::thread(&FdReactor::run, reactor));
+    }
+}
+
+void FdReactorGroup::end()
+{
+    for ( size_t i = 0; i < m_threads.size(); i++ )
+    {
+        m_reactors[i]->stop();
+        m_threads[i]->join();
+        delete m_threads[i];
+    }
+    m_threads.clear();
+}
+
+bool FdReactorGroup::add(tiny_fd_handle_t handle, int fd)
+{
+    FdReactor *target = m_reactors[0];
+    int minSize = target->size();
+    for ( auto reactor: m_reactors )
+    {
+        int size = reactor->size();
+        if ( size < minSize )
+        {
+            target = reactor;
+            minSize = size;
+        }
+    }
+    return target->add(handle, fd);
+}
+
+void FdReactorGroup::remove(tiny_fd_handle_t handle)
+{
+    for ( auto reactor: m_reactors )
+    {
+        reactor->remove(handle);
+    }
+}
+
+} // namespace tinyproto
+
+#endif
@@ -0,0 +1,206 @@
+/*
+    Copyright 2022 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    GNU General Public License Usage
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Commercial License Usage
+
+    Licensees holding valid commercial Tiny Protocol licenses may use this file in
+    accordance with the commercial license agreement provided in accordance with
+    the terms contained in a written agreement between you and Alexey Dynda.
+    For further information contact via email on github account.
+*/
+
+/**
+ This is Tiny protocol reactor, which drives many full duplex protocol instances from a single thread
+
+ @file
+ @brief Tiny protocol Full Duplex reactor API
+
+*/
+
+#pragma once
+
+#if defined(__linux__) && !defined(ARDUINO)
+
+#include "proto/fd/tiny_fd.h"
+#include "hal/tiny_timer_wheel.h"
+
+#include <stdint.h>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+
+namespace tinyproto
+{
+
+/**
+ * FdReactor owns a set of tiny_fd handles together with their file descriptors
+ * and runs all protocol work for them on a single thread. Descriptors are multiplexed
+ * with epoll, and protocol timers of all handles are kept in one shared timer wheel,
+ * so the reactor wakes up only when the nearest tiny_fd_get_next_deadline() of any
+ * handle expires, and timer expiration doesn't depend on the number of handles. New outgoing data are
+ * signalled via per-handle eventfd, so idle reactor doesn't consume CPU.
+ * The descriptors are switched to non-blocking mode. If the peer closes the descriptor
+ * or read fails, the handle is removed from the reactor, but the handle and the
+ * descriptor are left open for the application.
+ *
+ * @note tiny_fd callbacks are called from the reactor thread, so they must not block.
+ *       Use zero timeout when calling tiny_fd_send_packet_to() from the callbacks.
+ * @note The reactor holds its lock while running tiny_fd callbacks, so add(), remove()
+ *       and size() must not be called from the callbacks of the handles, served by the
+ *       same reactor. This leads to deadlock.
+ */
+class FdReactor
+{
+public:
+    FdReactor();
+
+    ~FdReactor();
+
+    /**
+     * Adds tiny_fd handle to the reactor. The handle must be already initialized,
+     * and fd must be opened by the application. Can be called while the reactor is running.
+     * The reactor installs its own tiny_fd_set_tx_ready_cb() callback for the handle.
+     * @param handle tiny_fd handle
+     * @param fd file descriptor of the serial port, socket or pipe.
+     * @return true if the handle is added, false otherwise
+     */
+    bool add(tiny_fd_handle_t handle, int fd);
+
+    /**
+     * Removes tiny_fd handle from the reactor. The handle and the descriptor are not closed.
+     * @param handle tiny_fd handle
+     */
+    void remove(tiny_fd_handle_t handle);
+
+    /**
+     * Returns number of handles, owned by the reactor.
+     */
+    int size();
+
+    /**
+     * Waits for the events and processes them. This method is used,
+     * when the application runs its own loop.
+     * @param timeoutMs maximum time to wait for the events in milliseconds, -1 to wait forever.
+     * @return number of processed events or negative value in case of error.
+     */
+    int runOnce(int timeoutMs);
+
+    /**
+     * Processes the events until stop() is called.
+     */
+    void run();
+
+    /**
+     * Forces run() to exit. Can be called from any thread.
+     */
+    void stop();
+
+private:
+    struct Link
+    {
+        FdReactor *reactor;
+        tiny_fd_handle_t handle;
+        int fd;
+        int notify;
+        uint32_t index;
+        tiny_timer_t timer;
+        bool waitOut;
+        int txPos;
+        int txLen;
+        uint8_t txBuf[512];
+    };
+
+    int m_epoll = -1;
+    int m_timer = -1;
+    int m_wakeup = -1;
+    std::atomic<bool> m_stop{false};
+    std::vector<Link *> m_links{};
+    std::mutex m_mutex{};
+    tiny_timer_wheel_t m_wheel{};
+
+    void onTimer();
+
+    static void onDeadline(void *arg);
+
+    void armTimer();
+
+    void updateDeadline(Link *link);
+
+    static void onTxReady(void *arg);
+
+    void onWakeup();
+
+    bool runRx(Link *link);
+
+    void runTx(Link *link);
+
+    void setWaitOut(Link *link, bool enable);
+
+    void closeLink(uint32_t index);
+};
+
+/**
+ * FdReactorGroup runs one FdReactor per thread and shards added handles
+ * across them, so protocol work of many links can be spread over all cores.
+ */
+class FdReactorGroup
+{
+public:
+    /**
+     * Creates group of reactors.
+     * @param threads number of reactor threads. If 0, the number of hardware threads is used.
+     */
+    explicit FdReactorGroup(int threads = 0);
+
+    ~FdReactorGroup();
+
+    /**
+     * Starts reactor threads.
+     */
+    void begin();
+
+    /**
+     * Stops reactor threads.
+     */
+    void end();
+
+    /**
+     * Adds tiny_fd handle to the least loaded reactor of the group.
+     * @param handle tiny_fd handle
+     * @param fd file descriptor of the serial port, socket or pipe.
+     * @return true if the handle is added, false otherwise
+     */
+    bool add(tiny_fd_handle_t handle, int fd);
+
+    /**
+     * Removes tiny_fd handle from the group.
+     * @param handle tiny_fd handle
+     */
+    void remove(tiny_fd_handle_t handle);
+
+private:
+    std::vector<FdReactor *> m_reactors{};
+    std::vector<std::thread *> m_threads{};
+};
+
+} // namespace tinyproto
+
+#endif
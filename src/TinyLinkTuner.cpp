@@ -0,0 +1,176 @@
+/*
+    Copyright 2022 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    GNU General Public License Usage
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Commercial License Usage
+
+    Licensees holding valid commercial Tiny Protocol licenses may use this file in
+    accordance with the commercial license agreement provided in accordance with
+    the terms contained in a written agreement between you and Alexey Dynda.
+    For further information contact via email on github account.
+*/
+
+#include "TinyLinkTuner.h"
+
+namespace tinyproto
+{
+
+static const int s_defaultMtus[] = {32, 64, 128, 256, 512};
+static const uint8_t s_defaultWindows[] = {2, 3, 4, 5, 6, 7};
+static const hdlc_crc_t s_defaultCrcs[] = {HDLC_CRC_8, HDLC_CRC_16, HDLC_CRC_32};
+static const uint16_t s_defaultTimeouts[] = {0};
+
+#define COUNT_OF(x) static_cast<int>(sizeof(x) / sizeof((x)[0]))
+
+LinkTuner::LinkTuner(ProbeCallback probe, void *arg)
+    : m_probe(probe)
+    , m_arg(arg)
+    , m_mtus(s_defaultMtus)
+    , m_mtuCount(COUNT_OF(s_defaultMtus))
+    , m_windows(s_defaultWindows)
+    , m_windowCount(COUNT_OF(s_defaultWindows))
+    , m_crcs(s_defaultCrcs)
+    , m_crcCount(COUNT_OF(s_defaultCrcs))
+    , m_timeouts(s_defaultTimeouts)
+    , m_timeoutCount(COUNT_OF(s_defaultTimeouts))
+{
+}
+
+void LinkTuner::setMtus(const int *mtus, int count)
+{
+    m_mtus = mtus;
+    m_mtuCount = count;
+}
+
+void LinkTuner::setWindows(const uint8_t *windows, int count)
+{
+    m_windows = windows;
+    m_windowCount = count;
+}
+
+void LinkTuner::setCrcs(const hdlc_crc_t *crcs, int count)
+{
+    m_crcs = crcs;
+    m_crcCount = count;
+}
+
+void LinkTuner::setRetryTimeouts(const uint16_t *timeouts, int count)
+{
+    m_timeouts = timeouts;
+    m_timeoutCount = count;
+}
+
+void LinkTuner::setGoal(LinkTunerGoal goal)
+{
+    m_goal = goal;
+}
+
+void LinkTuner::setMemoryLimit(int bytes)
+{
+    m_memoryLimit = bytes;
+}
+
+void LinkTuner::setPeers(uint8_t peers)
+{
+    m_peers = peers;
+}
+
+void LinkTuner::setResultCallback(ResultCallback callback)
+{
+    m_onResult = callback;
+}
+
+int LinkTuner::getMemorySize(const LinkTunerParams &params) const
+{
+    return tiny_fd_buffer_size_by_mtu_ex(m_peers, params.mtu, params.window, params.crc, 1);
+}
+
+bool LinkTuner::isBetter(const LinkTunerResult &candidate) const
+{
+    if ( !m_best.valid )
+    {
+        return true;
+    }
+    // Results within 2% are considered equal, and then the smaller buffer wins
+    uint64_t a = m_goal == LinkTunerGoal::GOODPUT ? candidate.goodput : m_best.latencyP99;
+    uint64_t b = m_goal == LinkTunerGoal::GOODPUT ? m_best.goodput : candidate.latencyP99;
+    if ( a * 100 > b * 102 )
+    {
+        return true;
+    }
+    if ( a * 102 < b * 100 )
+    {
+        return false;
+    }
+    return candidate.memory < m_best.memory;
+}
+
+int LinkTuner::run()
+{
+    int probes = 0;
+    m_best.valid = false;
+    for ( int m = 0; m < m_mtuCount; m++ )
+    {
+        for ( int w = 0; w < m_windowCount; w++ )
+        {
+            for ( int c = 0; c < m_crcCount; c++ )
+            {
+                for ( int t = 0; t < m_timeoutCount; t++ )
+                {
+                    LinkTunerResult result{};
+                    result.params.mtu = m_mtus[m];
+                    result.params.window = m_windows[w];
+                    result.params.crc = m_crcs[c];
+                    result.params.retryTimeout = m_timeouts[t];
+                    result.memory = getMemorySize(result.params);
+                    if ( m_memoryLimit == 0 || result.memory <= m_memoryLimit )
+                    {
+                        result.valid = m_probe(m_arg, result.params, result);
+                    }
+                    if ( result.valid )
+                    {
+                        probes++;
+                        if ( isBetter(result) )
+                        {
+                            m_best = result;
+                        }
+                    }
+                    if ( m_onResult )
+                    {
+                        m_onResult(m_arg, result);
+                    }
+                }
+            }
+        }
+    }
+    return probes;
+}
+
+void LinkTuner::apply(tiny_fd_init_t &init) const
+{
+    init.mtu = m_best.params.mtu;
+    init.window_frames = m_best.params.window;
+    init.crc_type = m_best.params.crc;
+    if ( m_best.params.retryTimeout )
+    {
+        init.retry_timeout = m_best.params.retryTimeout;
+    }
+}
+
+} // namespace tinyproto
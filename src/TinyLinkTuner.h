@@ -0,0 +1,197 @@
+/*
+    Copyright 2022 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    GNU General Public License Usage
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Commercial License Usage
+
+    Licensees holding valid commercial Tiny Protocol licenses may use this file in
+    accordance with the commercial license agreement provided in accordance with
+    the terms contained in a written agreement between you and Alexey Dynda.
+    For further information contact via email on github account.
+*/
+
+/**
+ This is Tiny protocol link tuner, which searches for the best full duplex protocol parameters
+
+ @file
+ @brief Tiny protocol link tuner API
+
+*/
+
+#pragma once
+
+#include "proto/fd/tiny_fd.h"
+
+#include <stdint.h>
+
+namespace tinyproto
+{
+
+/**
+ * Full duplex protocol parameters, probed by LinkTuner
+ */
+struct LinkTunerParams
+{
+    /// Maximum payload size, see tiny_fd_init_t::mtu
+    int mtu;
+
+    /// Number of frames in window, see tiny_fd_init_t::window_frames
+    uint8_t window;
+
+    /// Crc type, see tiny_fd_init_t::crc_type
+    hdlc_crc_t crc;
+
+    /// Ack timeout in milliseconds, see tiny_fd_init_t::retry_timeout. 0 leaves the application value
+    uint16_t retryTimeout;
+};
+
+/**
+ * Result of single probe
+ */
+struct LinkTunerResult
+{
+    /// Probed parameters
+    LinkTunerParams params;
+
+    /// Payload bytes per second, delivered to remote side
+    uint32_t goodput;
+
+    /// 99th percentile of message delivery time in microseconds
+    uint32_t latencyP99;
+
+    /// Buffer size required by tiny_fd_init(), see tiny_fd_buffer_size_by_mtu_ex()
+    int memory;
+
+    /// false if the probe failed, or the parameters were skipped due to memory limit
+    bool valid;
+};
+
+/**
+ * What LinkTuner optimizes
+ */
+enum class LinkTunerGoal : uint8_t
+{
+    /// Maximize goodput
+    GOODPUT = 0,
+
+    /// Minimize 99th percentile of latency
+    LATENCY = 1,
+};
+
+/**
+ * LinkTuner probes all combinations of mtu, window, crc and ack timeout from the grid, and
+ * selects the parameters, which maximize goodput or minimize p99 latency. The tuner doesn't
+ * know how to probe the link: the application provides the callback, which runs the traffic over
+ * a live link or a simulated channel with specified parameters, and fills the measurements.
+ * If results of two candidates differ by less than 2%, the candidate, which requires less memory, wins.
+ *
+ * @code{.cpp}
+ * tinyproto::LinkTuner tuner(probe, &channel);
+ * tuner.setGoal(tinyproto::LinkTunerGoal::LATENCY);
+ * tuner.setMemoryLimit(4096);
+ * if ( tuner.run() > 0 )
+ * {
+ *     tuner.apply(init);
+ * }
+ * @endcode
+ */
+class LinkTuner
+{
+public:
+    /**
+     * Callback, which runs the traffic with specified parameters, and fills goodput and
+     * latencyP99 fields of the result. Must return false if the link doesn't work with the parameters.
+     */
+    typedef bool (*ProbeCallback)(void *arg, const LinkTunerParams &params, LinkTunerResult &result);
+
+    /**
+     * Callback, which is called for each candidate after the probe, or after the candidate is skipped.
+     */
+    typedef void (*ResultCallback)(void *arg, const LinkTunerResult &result);
+
+    /**
+     * Creates tuner with default grid: mtu 32 - 512, window 2 - 7, crc 8/16/32, default ack timeout.
+     * @param probe callback, which runs the traffic
+     * @param arg user argument for the callbacks
+     */
+    LinkTuner(ProbeCallback probe, void *arg);
+
+    /** Sets mtu values to probe. The array must be valid until run() completes */
+    void setMtus(const int *mtus, int count);
+
+    /** Sets window sizes to probe. The array must be valid until run() completes */
+    void setWindows(const uint8_t *windows, int count);
+
+    /** Sets crc types to probe. The array must be valid until run() completes */
+    void setCrcs(const hdlc_crc_t *crcs, int count);
+
+    /** Sets ack timeouts to probe. The array must be valid until run() completes */
+    void setRetryTimeouts(const uint16_t *timeouts, int count);
+
+    /** Sets what the tuner optimizes, goodput by default */
+    void setGoal(LinkTunerGoal goal);
+
+    /** Skips parameters, which require more memory than specified. 0 means no limit */
+    void setMemoryLimit(int bytes);
+
+    /** Sets number of peers for memory calculation, see tiny_fd_init_t::peers_count */
+    void setPeers(uint8_t peers);
+
+    /** Sets callback to receive result of each candidate */
+    void setResultCallback(ResultCallback callback);
+
+    /**
+     * Probes all combinations of the grid.
+     * @return number of valid probes, 0 if no parameters work
+     */
+    int run();
+
+    /** Returns the best result of last run(). The result is not valid if run() returned 0 */
+    const LinkTunerResult &getBest() const
+    {
+        return m_best;
+    }
+
+    /** Returns buffer size, required by tiny_fd_init() for specified parameters */
+    int getMemorySize(const LinkTunerParams &params) const;
+
+    /** Copies the best parameters to tiny_fd_init_t structure, the buffer is not changed */
+    void apply(tiny_fd_init_t &init) const;
+
+private:
+    ProbeCallback m_probe;
+    ResultCallback m_onResult = nullptr;
+    void *m_arg;
+    const int *m_mtus;
+    int m_mtuCount;
+    const uint8_t *m_windows;
+    int m_windowCount;
+    const hdlc_crc_t *m_crcs;
+    int m_crcCount;
+    const uint16_t *m_timeouts;
+    int m_timeoutCount;
+    LinkTunerGoal m_goal = LinkTunerGoal::GOODPUT;
+    int m_memoryLimit = 0;
+    uint8_t m_peers = 1;
+    LinkTunerResult m_best{};
+
+    bool isBetter(const LinkTunerResult &candidate) const;
+};
+
+} // namespace tinyproto
@@ -70,6 +70,8 @@ void IFd::begin()
     init.retry_timeout = 200;
     init.retries = 2;
     init.crc_type = m_crc;
+    init.framing = m_framing;
+    init.fec = m_fec;
     init.mode = TINY_FD_MODE_ABM;
 
     tiny_fd_init(&m_handle, &init);
@@ -99,13 +101,8 @@ int IFd::run_rx(const void *data, int len)
 
 int IFd::run_rx(read_block_cb_t read_func)
 {
-    uint8_t buf[4];
-    int len = read_func(m_userData, buf, sizeof(buf));
-    if ( len <= 0 )
-    {
-        return len;
-    }
-    return tiny_fd_on_rx_data(m_handle, buf, len);
+    uint8_t buf[TINY_FD_RX_BLOCK_SIZE];
+    return tiny_fd_run_rx_ex(m_handle, read_func, m_userData, buf, sizeof(buf));
 }
 
 int IFd::run_tx(void *data, int max_size)
@@ -115,24 +112,8 @@ int IFd::run_tx(void *data, int max_size)
 
 int IFd::run_tx(write_block_cb_t write_func)
 {
-    uint8_t buf[4];
-    int len = tiny_fd_get_tx_data(m_handle, buf, sizeof(buf), 0);
-    if ( len <= 0 )
-    {
-        return len;
-    }
-    uint8_t *ptr = buf;
-    while ( len )
-    {
-        int result = write_func(m_userData, ptr, len);
-        if ( result < 0 )
-        {
-            return result;
-        }
-        len -= result;
-        ptr += result;
-    }
-    return TINY_SUCCESS;
+    uint8_t buf[TINY_FD_TX_BLOCK_SIZE];
+    return tiny_fd_run_tx_ex(m_handle, write_func, m_userData, buf, sizeof(buf), 0);
 }
 
 void IFd::disableCrc()
@@ -123,16 +123,19 @@ public:
 
     /**
      * Read data from communication channel using read_func and
-     * parses bytes to find hdlc messages.
+     * parses bytes to find hdlc messages. Data are read by blocks of
+     * TINY_FD_RX_BLOCK_SIZE bytes until read_func returns less than requested.
      * @param read_func function to read data from communication channel
-     * @return TINY_SUCCESS
+     * @return number of bytes received or negative error code
      */
     int run_rx(read_block_cb_t read_func);
 
     /**
-     * Attempts to send out data via write_func function.
+     * Attempts to send out data via write_func function. Data are generated by blocks of
+     * TINY_FD_TX_BLOCK_SIZE bytes until there is nothing to send or write_func accepts
+     * less than requested.
      * @param write_func pointer to function for sending bytes to the channel
-     * @return TINY_SUCCESS
+     * @return number of bytes sent or negative error code
      */
     int run_tx(write_block_cb_t write_func);
 
@@ -234,6 +237,27 @@ public:
         m_sendTimeout = timeout;
     }
 
+    /**
+     * Sets framing to use on the line. Must be called before begin().
+     * Both sides must use the same framing.
+     * @param framing HDLC_FRAMING_HDLC (default), HDLC_FRAMING_COBS or HDLC_FRAMING_RAW
+     */
+    void setFraming(hdlc_framing_t framing)
+    {
+        m_framing = framing;
+    }
+
+    /**
+     * Enables forward error correction on hdlc level. Must be called before begin().
+     * Both sides must use the same value. Parity fields take the space in the buffer,
+     * tiny_fd_get_layout() with tiny_fd_init_t::fec set returns the size required.
+     * @param fec number of correctable byte errors per 255-byte block, 0 disables FEC
+     */
+    void setFec(uint8_t fec)
+    {
+        m_fec = fec;
+    }
+
     /**
      * Sets user data to pass to callbacks
      * @param userData user data to pass to callback
@@ -259,6 +283,16 @@ public:
         return tiny_fd_get_status(m_handle);
     }
 
+    /**
+     * Returns protocol counters: sent and received I-frames, retransmissions, crc errors, etc.
+     */
+    tiny_fd_stats_t getStats()
+    {
+        tiny_fd_stats_t stats{};
+        tiny_fd_get_stats(m_handle, &stats);
+        return stats;
+    }
+
 protected:
     /**
      * Method called by hdlc protocol upon receiving new frame.
@@ -311,6 +345,10 @@ private:
 
     hdlc_crc_t m_crc = HDLC_CRC_DEFAULT;
 
+    hdlc_framing_t m_framing = HDLC_FRAMING_HDLC;
+
+    uint8_t m_fec = 0;
+
     /** max buffer size */
     int m_bufferSize = 0;
 
@@ -47,21 +47,33 @@
 #define CONFIG_ENABLE_FCS32
 #endif
 
+#ifndef CONFIG_ENABLE_FEC
+#define CONFIG_ENABLE_FEC
+#endif
+
+#define CONFIG_TINYHAL_THREAD_SUPPORT 1
+
+#ifndef CONFIG_TINY_LARGE_BUFFERS
+#define CONFIG_TINY_LARGE_BUFFERS 1
+#endif
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+
 /**
  * Mutex type used by Tiny Protocol implementation.
- * The type declaration depends on platform.
+ * The type declaration depends on platform. For C++ HAL it holds pointer to std::mutex.
  */
 typedef uintptr_t tiny_mutex_t;
 
 /**
  * Events group type used by Tiny Protocol implementation.
- * The type declaration depends on platform.
+ * The type declaration depends on platform. For C++ HAL it holds pointer to the object,
+ * which contains atomic bits and synchronization primitives to park waiting threads.
  */
 typedef struct
 {
-    /** Mutex object to protect bits */
-    tiny_mutex_t mutex;
-    /** Current state of bits */
-    uint8_t bits;
+    /** Pointer to C++ events object */
+    uintptr_t impl;
 } tiny_events_t;
 
+#endif
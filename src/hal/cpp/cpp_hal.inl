@@ -27,66 +27,179 @@
 */
 
 #include <mutex>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <condition_variable>
 
-#error "Not implemented now"
+/// Number of attempts to get event bits before the thread is parked on the condition variable
+#ifndef TINY_CPP_HAL_SPIN_COUNT
+#define TINY_CPP_HAL_SPIN_COUNT 64
+#endif
+
+namespace
+{
+struct CppEvents
+{
+    std::atomic<uint8_t> bits{0};
+    std::atomic<uint16_t> waiters{0};
+    std::mutex mutex{};
+    std::condition_variable_any cond{};
+};
+} // namespace
+
+static inline bool __is_uniprocessor()
+{
+    // Spinning makes no sense if there is no other CPU to set the bits
+    static const bool uniprocessor = std::thread::hardware_concurrency() <= 1;
+    return uniprocessor;
+}
+
+static inline std::mutex *__mutex(tiny_mutex_t *mutex)
+{
+    return reinterpret_cast<std::mutex *>(*mutex);
+}
+
+static inline CppEvents *__events(tiny_events_t *events)
+{
+    return reinterpret_cast<CppEvents *>(events->impl);
+}
+
+static inline uint8_t __take_bits(CppEvents *events, uint8_t bits, uint8_t clear)
+{
+    uint8_t value = events->bits.load();
+    // Clear requested bits only if any of them is set, the loop is needed if other thread changes bits
+    while ( (value & bits) && clear && !events->bits.compare_exchange_weak(value, static_cast<uint8_t>(value & ~bits)) )
+    {
+    }
+    return (value & bits) ? value : 0;
+}
 
 void tiny_mutex_create(tiny_mutex_t *mutex)
 {
+    *mutex = reinterpret_cast<uintptr_t>(new std::mutex());
 }
 
 void tiny_mutex_destroy(tiny_mutex_t *mutex)
 {
+    delete __mutex(mutex);
+    *mutex = 0;
 }
 
 void tiny_mutex_lock(tiny_mutex_t *mutex)
 {
+    __mutex(mutex)->lock();
 }
 
 uint8_t tiny_mutex_try_lock(tiny_mutex_t *mutex)
 {
+    return __mutex(mutex)->try_lock();
 }
 
 void tiny_mutex_unlock(tiny_mutex_t *mutex)
 {
+    __mutex(mutex)->unlock();
 }
 
 void tiny_events_create(tiny_events_t *events)
 {
+    events->impl = reinterpret_cast<uintptr_t>(new CppEvents());
 }
 
 void tiny_events_destroy(tiny_events_t *events)
 {
+    delete __events(events);
+    events->impl = 0;
 }
 
 uint8_t tiny_events_wait(tiny_events_t *events, uint8_t bits, uint8_t clear, uint32_t timeout)
 {
+    CppEvents *e = __events(events);
+    // Fast path: no locks, if bits are already set or if caller doesn't want to wait
+    uint8_t locked = __take_bits(e, bits, clear);
+    if ( locked )
+    {
+        return locked;
+    }
+    if ( timeout == 0 )
+    {
+        if ( __is_uniprocessor() )
+        {
+            // Let other threads run, polling loops would starve them otherwise
+            std::this_thread::yield();
+        }
+        return 0;
+    }
+    for ( int i = 0; i < (__is_uniprocessor() ? 0 : TINY_CPP_HAL_SPIN_COUNT); i++ )
+    {
+        std::this_thread::yield();
+        locked = __take_bits(e, bits, clear);
+        if ( locked )
+        {
+            return locked;
+        }
+    }
+    // Slow path: park the thread. Waiters counter is incremented before checking the bits,
+    // so tiny_events_set() either sees the waiter or the waiter sees new bits.
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+    std::unique_lock<std::mutex> lock(e->mutex);
+    e->waiters++;
+    while ( !(locked = __take_bits(e, bits, clear)) )
+    {
+        if ( timeout == 0xFFFFFFFF )
+        {
+            e->cond.wait(lock);
+        }
+        else if ( e->cond.wait_until(lock, deadline) == std::cv_status::timeout )
+        {
+            locked = __take_bits(e, bits, clear);
+            break;
+        }
+    }
+    e->waiters--;
+    return locked;
 }
 
 uint8_t tiny_events_check_int(tiny_events_t *events, uint8_t bits, uint8_t clear)
 {
+    return __take_bits(__events(events), bits, clear);
 }
 
 void tiny_events_set(tiny_events_t *events, uint8_t bits)
 {
+    CppEvents *e = __events(events);
+    e->bits.fetch_or(bits);
+    // Mutex is used only if there are parked threads
+    if ( e->waiters.load() )
+    {
+        std::lock_guard<std::mutex> lock(e->mutex);
+        e->cond.notify_all();
+    }
 }
 
 void tiny_events_clear(tiny_events_t *events, uint8_t bits)
 {
+    __events(events)->bits.fetch_and(static_cast<uint8_t>(~bits));
 }
 
 void tiny_sleep(uint32_t ms)
 {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
 }
 
 void tiny_sleep_us(uint32_t us)
 {
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
 }
 
 uint32_t tiny_millis(void)
 {
+    return static_cast<uint32_t>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
 }
 
 uint32_t tiny_micros(void)
 {
+    return static_cast<uint32_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
 }
-
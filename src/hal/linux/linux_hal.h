@@ -45,8 +45,16 @@
 #define CONFIG_ENABLE_FCS32
 #endif
 
+#ifndef CONFIG_ENABLE_FEC
+#define CONFIG_ENABLE_FEC
+#endif
+
 #define CONFIG_TINYHAL_THREAD_SUPPORT 1
 
+#ifndef CONFIG_TINY_LARGE_BUFFERS
+#define CONFIG_TINY_LARGE_BUFFERS 1
+#endif
+
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
 
 /**
@@ -46,6 +46,10 @@
 #define CONFIG_ENABLE_FCS32
 #endif
 
+#ifndef CONFIG_ENABLE_FEC
+#define CONFIG_ENABLE_FEC
+#endif
+
 #define CONFIG_TINYHAL_THREAD_SUPPORT 1
 
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
@@ -47,6 +47,10 @@
 #define CONFIG_ENABLE_FCS32
 #endif
 
+#ifndef CONFIG_ENABLE_FEC
+#define CONFIG_ENABLE_FEC
+#endif
+
 /**
  * Mutex type used by Tiny Protocol implementation.
  * The type declaration depends on platform.
@@ -0,0 +1,229 @@
+/*
+    Copyright 2022 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    GNU General Public License Usage
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Commercial License Usage
+
+    Licensees holding valid commercial Tiny Protocol licenses may use this file in
+    accordance with the commercial license agreement provided in accordance with
+    the terms contained in a written agreement between you and Alexey Dynda.
+    For further information contact via email on github account.
+*/
+
+#include "tiny_timer_wheel.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#define WHEEL_MASK (TINY_TIMER_WHEEL_SIZE - 1)
+#define WHEEL_RANGE ((uint32_t)1 << (TINY_TIMER_WHEEL_BITS * TINY_TIMER_WHEEL_LEVELS))
+
+#if TINY_TIMER_WHEEL_BITS * TINY_TIMER_WHEEL_LEVELS >= 32
+#error "Timer wheel range must be less than 32 bits"
+#endif
+
+static void __link(tiny_timer_t **slot, tiny_timer_t *timer)
+{
+    timer->next = *slot;
+    if ( *slot )
+    {
+        (*slot)->pprev = &timer->next;
+    }
+    timer->pprev = slot;
+    *slot = timer;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static void __unlink(tiny_timer_t *timer)
+{
+    *timer->pprev = timer->next;
+    if ( timer->next )
+    {
+        timer->next->pprev = timer->pprev;
+    }
+    timer->next = NULL;
+    timer->pprev = NULL;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static void __insert(tiny_timer_wheel_t *wheel, tiny_timer_t *timer)
+{
+    uint32_t expires = timer->expires;
+    uint32_t delta = expires - wheel->now;
+    uint8_t level = 0;
+    if ( (int32_t)delta < 0 )
+    {
+        // Already expired timers are processed on the next tick
+        delta = 0;
+        expires = wheel->now;
+    }
+    else if ( delta >= WHEEL_RANGE )
+    {
+        // Too far timers are kept at the last slot of the top level, and are rescheduled on cascade
+        delta = WHEEL_RANGE - 1;
+        expires = wheel->now + delta;
+    }
+    while ( level < TINY_TIMER_WHEEL_LEVELS - 1 && delta >= ((uint32_t)1 << (TINY_TIMER_WHEEL_BITS * (level + 1))) )
+    {
+        level++;
+    }
+    __link(&wheel->slots[level][(expires >> (TINY_TIMER_WHEEL_BITS * level)) & WHEEL_MASK], timer);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static uint32_t __cascade(tiny_timer_wheel_t *wheel, uint8_t level)
+{
+    uint32_t index = (wheel->now >> (TINY_TIMER_WHEEL_BITS * level)) & WHEEL_MASK;
+    tiny_timer_t *timer = wheel->slots[level][index];
+    wheel->slots[level][index] = NULL;
+    while ( timer != NULL )
+    {
+        tiny_timer_t *next = timer->next;
+        __insert(wheel, timer);
+        timer = next;
+    }
+    return index;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void tiny_timer_wheel_init(tiny_timer_wheel_t *wheel, uint32_t now)
+{
+    memset(wheel, 0, sizeof(tiny_timer_wheel_t));
+    wheel->now = now;
+    wheel->time = now;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+int tiny_timer_wheel_advance(tiny_timer_wheel_t *wheel, uint32_t now)
+{
+    int expired = 0;
+    wheel->time = now;
+    if ( wheel->count == 0 )
+    {
+        // Nothing to do, just move time forward
+        if ( (int32_t)(now - wheel->now) >= 0 )
+        {
+            wheel->now = now + 1;
+        }
+        return 0;
+    }
+    while ( (int32_t)(now - wheel->now) >= 0 )
+    {
+        uint32_t index = wheel->now & WHEEL_MASK;
+        if ( index == 0 )
+        {
+            // Move timers from upper levels, when lower level completes the cycle
+            for ( uint8_t level = 1; level < TINY_TIMER_WHEEL_LEVELS; level++ )
+            {
+                if ( __cascade(wheel, level) != 0 )
+                {
+                    break;
+                }
+            }
+        }
+        tiny_timer_t *head = wheel->slots[0][index];
+        wheel->slots[0][index] = NULL;
+        if ( head != NULL )
+        {
+            head->pprev = &head;
+        }
+        // Timers restarted from callbacks are scheduled relatively to the next tick
+        wheel->now++;
+        while ( head != NULL )
+        {
+            tiny_timer_t *timer = head;
+            __unlink(timer);
+            wheel->count--;
+            expired++;
+            timer->cb(timer->arg);
+        }
+    }
+    return expired;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+uint32_t tiny_timer_wheel_next_expiry(tiny_timer_wheel_t *wheel)
+{
+    if ( wheel->count == 0 )
+    {
+        return 0xFFFFFFFF;
+    }
+    for ( uint32_t i = 0; i < TINY_TIMER_WHEEL_SIZE; i++ )
+    {
+        uint32_t index = (wheel->now + i) & WHEEL_MASK;
+        // Stop at the first non-empty slot or at the next cascade point, which is not processed yet
+        if ( wheel->slots[0][index] != NULL || index == 0 )
+        {
+            return i + 1;
+        }
+    }
+    return TINY_TIMER_WHEEL_SIZE;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+uint32_t tiny_timer_wheel_get_time(tiny_timer_wheel_t *wheel)
+{
+    return wheel->time;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void tiny_timer_init(tiny_timer_t *timer, tiny_timer_cb_t cb, void *arg)
+{
+    timer->next = NULL;
+    timer->pprev = NULL;
+    timer->expires = 0;
+    timer->cb = cb;
+    timer->arg = arg;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void tiny_timer_start(tiny_timer_wheel_t *wheel, tiny_timer_t *timer, uint32_t expires)
+{
+    tiny_timer_stop(wheel, timer);
+    timer->expires = expires;
+    __insert(wheel, timer);
+    wheel->count++;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void tiny_timer_stop(tiny_timer_wheel_t *wheel, tiny_timer_t *timer)
+{
+    if ( timer->pprev != NULL )
+    {
+        __unlink(timer);
+        wheel->count--;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+uint8_t tiny_timer_is_active(tiny_timer_t *timer)
+{
+    return timer->pprev != NULL;
+}
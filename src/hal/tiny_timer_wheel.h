@@ -0,0 +1,174 @@
+/*
+    Copyright 2022 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    GNU General Public License Usage
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Commercial License Usage
+
+    Licensees holding valid commercial Tiny Protocol licenses may use this file in
+    accordance with the commercial license agreement provided in accordance with
+    the terms contained in a written agreement between you and Alexey Dynda.
+    For further information contact via email on github account.
+*/
+
+/**
+ This is hierarchical timer wheel for Tiny Protocol
+
+ @file
+ @brief Tiny Protocol timer wheel API
+
+ @details Timer wheel keeps any number of timers with O(1) start, stop and amortized
+          O(1) expiration cost. The wheel doesn't read the clock itself: the owner advances
+          it with the current time, so the wheel can be shared by many protocol instances.
+          The wheel is not thread safe, all calls must be serialized by the owner.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/// Number of bits of time, covered by single level of the wheel
+#ifndef TINY_TIMER_WHEEL_BITS
+#define TINY_TIMER_WHEEL_BITS 6
+#endif
+
+/// Number of levels in the timer wheel. 4 levels of 6 bits cover 16777216 ticks
+#ifndef TINY_TIMER_WHEEL_LEVELS
+#define TINY_TIMER_WHEEL_LEVELS 4
+#endif
+
+/// Number of slots in each level of the timer wheel
+#define TINY_TIMER_WHEEL_SIZE (1 << TINY_TIMER_WHEEL_BITS)
+
+    /**
+     * @defgroup TIMER_WHEEL_API Tiny timer wheel API
+     * @{
+     */
+
+    struct tiny_timer_t_;
+
+    /**
+     * Callback, which is called when the timer expires
+     * @param arg user argument passed to tiny_timer_init()
+     */
+    typedef void (*tiny_timer_cb_t)(void *arg);
+
+    /// Timer record. Memory for the record is provided by the user
+    typedef struct tiny_timer_t_
+    {
+        /// next timer in the slot
+        struct tiny_timer_t_ *next;
+        /// previous timer in the slot, NULL if timer is not started
+        struct tiny_timer_t_ **pprev;
+        /// expiration time in ticks
+        uint32_t expires;
+        /// callback to call on expiration
+        tiny_timer_cb_t cb;
+        /// user argument for the callback
+        void *arg;
+    } tiny_timer_t;
+
+    /// Timer wheel
+    typedef struct
+    {
+        /// timer slots for all levels
+        tiny_timer_t *slots[TINY_TIMER_WHEEL_LEVELS][TINY_TIMER_WHEEL_SIZE];
+        /// next tick to process
+        uint32_t now;
+        /// time, passed to the last tiny_timer_wheel_advance() call
+        uint32_t time;
+        /// number of started timers
+        int count;
+    } tiny_timer_wheel_t;
+
+    /**
+     * Initializes timer wheel.
+     * @param wheel pointer to timer wheel
+     * @param now current time in ticks, for example tiny_millis()
+     */
+    extern void tiny_timer_wheel_init(tiny_timer_wheel_t *wheel, uint32_t now);
+
+    /**
+     * Advances timer wheel to the specified time and calls callbacks of all expired timers.
+     * Callbacks are allowed to start and stop any timers.
+     * @param wheel pointer to timer wheel
+     * @param now current time in ticks
+     * @return number of expired timers
+     */
+    extern int tiny_timer_wheel_advance(tiny_timer_wheel_t *wheel, uint32_t now);
+
+    /**
+     * Returns number of ticks from the last tiny_timer_wheel_advance() call, after which
+     * tiny_timer_wheel_advance() must be called again. The returned value is never greater
+     * than the time until the nearest timer expiration.
+     * @param wheel pointer to timer wheel
+     * @return number of ticks or 0xFFFFFFFF if there are no started timers
+     */
+    extern uint32_t tiny_timer_wheel_next_expiry(tiny_timer_wheel_t *wheel);
+
+    /**
+     * Returns current time of the wheel: the time, passed to the last tiny_timer_wheel_advance()
+     * or tiny_timer_wheel_init() call. Protocol instances, bound to the wheel, use this value
+     * instead of reading the clock.
+     * @param wheel pointer to timer wheel
+     * @return current time in ticks
+     */
+    extern uint32_t tiny_timer_wheel_get_time(tiny_timer_wheel_t *wheel);
+
+    /**
+     * Initializes timer record
+     * @param timer pointer to timer record
+     * @param cb callback to call on expiration
+     * @param arg argument to pass to the callback
+     */
+    extern void tiny_timer_init(tiny_timer_t *timer, tiny_timer_cb_t cb, void *arg);
+
+    /**
+     * Starts or restarts the timer.
+     * @param wheel pointer to timer wheel
+     * @param timer pointer to timer record
+     * @param expires absolute expiration time in ticks. If the time has already passed, the timer
+     *        expires on the next tiny_timer_wheel_advance() call.
+     */
+    extern void tiny_timer_start(tiny_timer_wheel_t *wheel, tiny_timer_t *timer, uint32_t expires);
+
+    /**
+     * Stops the timer. It is safe to stop the timer, which is not started.
+     * @param wheel pointer to timer wheel
+     * @param timer pointer to timer record
+     */
+    extern void tiny_timer_stop(tiny_timer_wheel_t *wheel, tiny_timer_t *timer);
+
+    /**
+     * Returns non-zero value if the timer is started.
+     * @param timer pointer to timer record
+     */
+    extern uint8_t tiny_timer_is_active(tiny_timer_t *timer);
+
+    /**
+     * @}
+     */
+
+#ifdef __cplusplus
+}
+#endif
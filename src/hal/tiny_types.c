@@ -29,6 +29,12 @@
 #include "tiny_types.h"
 #include "tiny_debug.h"
 
+/* Platform clock functions are wrapped to support external clock, see tiny_set_clock() */
+#define tiny_millis tiny_platform_millis
+#define tiny_micros tiny_platform_micros
+uint32_t tiny_platform_millis(void);
+uint32_t tiny_platform_micros(void);
+
 #if defined(CONFIG_ENABLE_CPP_HAL)
 // Do not include anything here, there is tiny_types_cpp.cpp for it
 #elif defined(TINY_CUSTOM_PLATFORM)
@@ -50,6 +56,26 @@
 #include "no_platform/no_platform_hal.inl"
 #endif
 
+#undef tiny_millis
+#undef tiny_micros
+
+static tiny_clock_cb_t s_clock = NULL;
+
+void tiny_set_clock(tiny_clock_cb_t clock)
+{
+    s_clock = clock;
+}
+
+uint32_t tiny_millis(void)
+{
+    return s_clock ? (uint32_t)(s_clock() / 1000) : tiny_platform_millis();
+}
+
+uint32_t tiny_micros(void)
+{
+    return s_clock ? (uint32_t)s_clock() : tiny_platform_micros();
+}
+
 uint8_t g_tiny_log_level = TINY_LOG_LEVEL_DEFAULT;
 
 void tiny_log_level(uint8_t level)
@@ -72,6 +72,22 @@ extern "C"
 #define CONFIG_TINYHAL_THREAD_SUPPORT 0
 #endif
 
+#ifndef CONFIG_TINY_LARGE_BUFFERS
+/**
+ * By default protocol buffers are limited to 64 KiB to save RAM on microcontrollers.
+ * Define CONFIG_TINY_LARGE_BUFFERS to 1 to use 32-bit buffer sizes.
+ */
+#define CONFIG_TINY_LARGE_BUFFERS 0
+#endif
+
+#if CONFIG_TINY_LARGE_BUFFERS
+/// Type used for protocol buffer sizes
+typedef uint32_t tiny_buf_size_t;
+#else
+/// Type used for protocol buffer sizes
+typedef uint16_t tiny_buf_size_t;
+#endif
+
 
 #if defined(_MSC_VER)
 /// This macro is used internally for aligning the structures
@@ -111,6 +127,16 @@ extern "C"
 /// This macro is used internally for aligning the structures
 #define TINY_ALIGN_BUFFER(x) ((uint8_t *)( ((uintptr_t)x + TINY_ALIGN_STRUCT_VALUE - 1) & (~(TINY_ALIGN_STRUCT_VALUE - 1)) ))
 
+/// This macro is used internally to round up the size of memory block to keep the next block aligned
+#define TINY_ALIGN_SIZE(x) ( ((x) + TINY_ALIGN_STRUCT_VALUE - 1) & (~(TINY_ALIGN_STRUCT_VALUE - 1)) )
+
+/**
+ * Size, which fits any scalar field of internal protocol structures together with its alignment.
+ * Public buffer size macros use it to reserve space for internal structures, which are not
+ * visible to the application.
+ */
+#define TINY_SCALAR_SIZE (sizeof(uintptr_t) > sizeof(uint32_t) ? sizeof(uintptr_t) : sizeof(uint32_t))
+
 /**
  * @ingroup ERROR_CODES
  * @{
@@ -350,6 +376,20 @@ extern "C"
      */
     uint32_t tiny_micros();
 
+    /**
+     * External clock callback, returns current time in microseconds.
+     */
+    typedef uint64_t (*tiny_clock_cb_t)(void);
+
+    /**
+     * Replaces system clock, used by tiny_millis() and tiny_micros(), with external one.
+     * This allows to run the protocol in virtual time, for example in channel simulators.
+     * tiny_sleep() and timeouts of blocking API still use system clock, so the protocol should
+     * be called with zero timeouts, when external clock is set.
+     * @param clock callback returning time in microseconds, or NULL to use system clock
+     */
+    void tiny_set_clock(tiny_clock_cb_t clock);
+
     /** @} */
 
     /**
@@ -30,7 +30,14 @@
 #include "tiny_debug.h"
 
 #if defined(CONFIG_ENABLE_CPP_HAL)
+/* Platform clock functions are wrapped by tiny_types.c to support external clock */
+#define tiny_millis tiny_platform_millis
+#define tiny_micros tiny_platform_micros
+extern "C" uint32_t tiny_platform_millis(void);
+extern "C" uint32_t tiny_platform_micros(void);
 #include "cpp/cpp_hal.inl"
+#undef tiny_millis
+#undef tiny_micros
 #endif
 
 #if 0
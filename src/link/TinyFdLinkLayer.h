@@ -66,6 +66,16 @@ public:
         m_bufferSize = size;
     }
 
+    /**
+     * Returns protocol counters. The link must be started by begin().
+     */
+    tiny_fd_stats_t getStats()
+    {
+        tiny_fd_stats_t stats{};
+        tiny_fd_get_stats(m_handle, &stats);
+        return stats;
+    }
+
 protected:
 
     int parseData(const uint8_t *data, int size);
@@ -23,7 +23,7 @@
 #include "TinyFdLinkLayer.h"
 
 #if defined(ARDUINO)
-#include "proto/fd/tiny_fd_int.h"
+#include "proto/fd/tiny_fd.h"
 #endif
 
 namespace tinyproto
@@ -55,6 +55,10 @@ extern "C"
 #define PPPGOODFCS32 0xdebb20e3 /* Good final FCS value */
     uint32_t crc32_byte(uint32_t crc, uint8_t data);
     uint32_t tiny_crc32(uint32_t crc, const uint8_t *buf, int size);
+
+#define INITCRC32C 0xffffffff /* Initial CRC-32C value */
+#define GOODCRC32C 0xb798b438 /* Good final CRC-32C value */
+    uint32_t tiny_crc32c(uint32_t crc, const uint8_t *buf, int size);
 #endif
 
 /// \cond
@@ -74,9 +78,13 @@ typedef uint16_t crc_t;
         HDLC_CRC_8 = 8,       ///< Simple sum of all bytes in user payload
         HDLC_CRC_16 = 16,     ///< CCITT-16
         HDLC_CRC_32 = 32,     ///< CCITT-32
+        HDLC_CRC_32C = 33,    ///< CRC-32C (Castagnoli), calculated by SSE4.2/ARMv8 instructions where available
         HDLC_CRC_OFF = 0xFF,  ///< Disable CRC field
     } hdlc_crc_t;
 
+/// Size of crc field in bytes for specified crc type, the same as get_crc_field_size() returns
+#define HDLC_CRC_FIELD_SIZE(crc) ((crc) == HDLC_CRC_OFF ? 0 : (crc) == HDLC_CRC_DEFAULT ? 4 : (int)(crc) / 8)
+
     /**
      * returns crc field size in bytes
      * @param crc_type crc type
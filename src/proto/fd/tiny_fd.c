@@ -32,6 +32,16 @@
 #include "hal/tiny_debug.h"
 
 #include <string.h>
+#include <stddef.h>
+
+// Public buffer size macros are defined without access to internal structures, so check them here
+typedef char tiny_fd_data_size_check_t[(TINY_FD_DATA_SIZE >= sizeof(tiny_fd_data_t)) ? 1 : -1];
+typedef char tiny_fd_peer_size_check_t[(TINY_FD_PEER_SIZE >= sizeof(tiny_fd_peer_info_t)) ? 1 : -1];
+typedef char tiny_fd_frame_header_size_check_t[
+    (TINY_FD_FRAME_HEADER_SIZE >= offsetof(tiny_fd_frame_info_t, payload)) ? 1 : -1];
+typedef char tiny_fd_frame_slot_size_check_t[(TINY_FD_QUEUE_SLOT_SIZE(1) >= sizeof(tiny_fd_frame_info_t)) ? 1 : -1];
+typedef char tiny_fd_queue_ring_size_check_t[(TINY_FD_QUEUE_RING_HEADER_SIZE >= sizeof(tiny_fd_queue_ring_t)) ? 1 : -1];
+typedef char tiny_fd_address_size_check_t[(sizeof(tiny_frame_header_t) == 2) ? 1 : -1];
 
 #ifndef TINY_FD_DEBUG
 #define TINY_FD_DEBUG 0
@@ -81,7 +91,18 @@ enum
 
 static const uint8_t seq_bits_mask = 0x07;
 
+/** XID information field: format, mtu (2 bytes, little endian), window, modulus, features */
+#define FD_XID_FORMAT 0xF1
+#define FD_XID_SIZE 6
+#define FD_XID_FEATURE_AGGREGATION 0x01
+
+/** Number of sent I-frames, after which adaptive payload size and window are reviewed */
+#define FD_ADAPT_PERIOD 16
+/** Adaptive payload size is never reduced below this value */
+#define FD_ADAPT_MIN_MTU 16
+
 static void on_frame_read(void *user_data, uint8_t *data, int len);
+static bool on_frame_filter(void *user_data, uint8_t address);
 static void on_frame_send(void *user_data, const uint8_t *data, int len);
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -168,12 +189,10 @@ static uint8_t __switch_to_next_peer(tiny_fd_handle_t handle)
 
 ///////////////////////////////////////////////////////////////////////////////
 
-#if 0
 static inline uint8_t __number_of_awaiting_tx_i_frames(tiny_fd_handle_t handle, uint8_t peer)
 {
     return ((uint8_t)(handle->peers[peer].last_ns - handle->peers[peer].confirm_ns) & seq_bits_mask);
 }
-#endif
 
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -191,23 +210,265 @@ static inline bool __all_frames_are_sent(tiny_fd_handle_t handle, uint8_t peer)
 
 ///////////////////////////////////////////////////////////////////////////////
 
-static inline uint32_t __time_passed_since_last_i_frame(tiny_fd_handle_t handle, uint8_t peer)
+static inline uint32_t __time_passed_since_last_i_frame(tiny_fd_handle_t handle, uint8_t peer, uint32_t now)
+{
+    return (uint32_t)(now - handle->peers[peer].last_i_ts);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static inline uint32_t __time_passed_since_last_frame_received(tiny_fd_handle_t handle, uint8_t peer, uint32_t now)
+{
+    return (uint32_t)(now - handle->peers[peer].last_ka_ts);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static inline uint32_t __time_passed_since_last_marker_seen(tiny_fd_handle_t handle, uint32_t now)
+{
+    return (uint32_t)(now - handle->last_marker_ts);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static inline uint32_t __time_left(uint32_t since, uint32_t timeout, uint32_t now)
+{
+    uint32_t passed = (uint32_t)(now - since);
+    return passed >= timeout ? 0 : timeout - passed;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static inline uint32_t __get_time(tiny_fd_handle_t handle)
+{
+    // The owner of the timer wheel advances it with the current time, so no need to read the clock
+    return handle->timer_wheel ? tiny_timer_wheel_get_time(handle->timer_wheel) : tiny_millis();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static void __set_tx_events(tiny_fd_handle_t handle, uint8_t bits)
+{
+    tiny_events_set(&handle->events, bits);
+    // Notify external event loop that tiny_fd_get_tx_data() has work to do
+    if ( handle->on_tx_ready_cb )
+    {
+        handle->on_tx_ready_cb(handle->tx_ready_arg);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static void __on_timer(void *arg)
+{
+    tiny_fd_handle_t handle = (tiny_fd_handle_t)arg;
+    // Tx path checks all timers of the peer itself, so just wake it up
+    if ( handle->on_tx_ready_cb )
+    {
+        handle->on_tx_ready_cb(handle->tx_ready_arg);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static inline int __aggr_prefix_size(int len)
+{
+    int size = 1;
+    while ( len >= 0x80 )
+    {
+        len >>= 7;
+        size++;
+    }
+    return size;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static int __aggr_write_prefix(uint8_t *buf, int len)
+{
+    int size = 0;
+    while ( len >= 0x80 )
+    {
+        buf[size++] = (uint8_t)(len | 0x80);
+        len >>= 7;
+    }
+    buf[size++] = (uint8_t)len;
+    return size;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Returns pointer to the next aggregated message in I-frame payload, or NULL if there are no more messages.
+ * ptr and size are advanced past the returned message.
+ */
+static uint8_t *__aggr_get_next_message(uint8_t **ptr, int *size, int *len)
+{
+    int msg_len = 0;
+    int shift = 0;
+    while ( *size > 0 && shift < 32 )
+    {
+        uint8_t byte = **ptr;
+        (*ptr)++;
+        (*size)--;
+        msg_len |= (int)(byte & 0x7F) << shift;
+        shift += 7;
+        if ( !(byte & 0x80) )
+        {
+            if ( msg_len > *size )
+            {
+                break;
+            }
+            uint8_t *msg = *ptr;
+            *ptr += msg_len;
+            *size -= msg_len;
+            *len = msg_len;
+            return msg;
+        }
+    }
+    if ( shift )
+    {
+        LOG(TINY_LOG_ERR, "Malformed aggregated I-frame%s", "\n");
+    }
+    return NULL;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static int __get_max_packet_size(tiny_fd_handle_t handle)
+{
+    int mtu = tiny_fd_queue_get_mtu( &handle->frames.i_queue );
+    return handle->aggregation ? mtu - __aggr_prefix_size(mtu) : mtu;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static inline int __get_peer_mtu(tiny_fd_handle_t handle, uint8_t peer)
+{
+    return handle->adaptive ? handle->peers[peer].adapt_mtu : handle->peers[peer].mtu;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static int __mtu_to_packet_size(tiny_fd_handle_t handle, uint8_t peer, int mtu)
 {
-    return (uint32_t)(tiny_millis() - handle->peers[peer].last_i_ts);
+    return handle->peers[peer].aggregation ? mtu - __aggr_prefix_size(mtu) : mtu;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static int __get_peer_max_packet_size(tiny_fd_handle_t handle, uint8_t peer)
+{
+    return __mtu_to_packet_size( handle, peer, __get_peer_mtu( handle, peer ) );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static void __adapt_reset(tiny_fd_handle_t handle, uint8_t peer)
+{
+    handle->peers[peer].adapt_mtu = handle->peers[peer].mtu;
+    handle->peers[peer].adapt_window = handle->peers[peer].window;
+    handle->peers[peer].adapt_frames = 0;
+    handle->peers[peer].adapt_errors = 0;
+    handle->peers[peer].adapt_ns = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static inline void __adapt_on_error(tiny_fd_handle_t handle, uint8_t peer)
+{
+    if ( handle->peers[peer].adapt_errors < 0xFF )
+    {
+        handle->peers[peer].adapt_errors++;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Reviews payload size and window every FD_ADAPT_PERIOD sent I-frames. If more than 1/8 of
+ * the frames caused errors, the payload size is halved and the window is reduced,
+ * otherwise if there were no errors at all, both values grow back to configured ones.
+ * Retransmissions are not counted, otherwise a noisy line would dilute its own error ratio.
+ */
+static void __adapt_on_i_frame_sent(tiny_fd_handle_t handle, uint8_t peer, uint8_t ns)
+{
+    if ( ns != handle->peers[peer].adapt_ns )
+    {
+        return;
+    }
+    handle->peers[peer].adapt_ns = (ns + 1) & seq_bits_mask;
+    if ( ++handle->peers[peer].adapt_frames < FD_ADAPT_PERIOD )
+    {
+        return;
+    }
+    const int mtu = handle->peers[peer].mtu;
+    const int min_mtu = mtu < FD_ADAPT_MIN_MTU ? mtu : FD_ADAPT_MIN_MTU;
+    if ( handle->peers[peer].adapt_errors * 8 > handle->peers[peer].adapt_frames )
+    {
+        handle->peers[peer].adapt_mtu /= 2;
+        if ( handle->peers[peer].adapt_mtu < min_mtu )
+        {
+            handle->peers[peer].adapt_mtu = min_mtu;
+        }
+        if ( handle->peers[peer].adapt_window > 2 )
+        {
+            handle->peers[peer].adapt_window--;
+        }
+        LOG(TINY_LOG_INFO, "[%p] Noisy line, mtu=%i, window=%i\n", handle, handle->peers[peer].adapt_mtu,
+            handle->peers[peer].adapt_window);
+    }
+    else if ( handle->peers[peer].adapt_errors == 0 )
+    {
+        int step = handle->peers[peer].adapt_mtu / 8;
+        handle->peers[peer].adapt_mtu += step ? step : 1;
+        if ( handle->peers[peer].adapt_mtu > mtu )
+        {
+            handle->peers[peer].adapt_mtu = mtu;
+        }
+        if ( handle->peers[peer].adapt_window < handle->peers[peer].window )
+        {
+            handle->peers[peer].adapt_window++;
+        }
+    }
+    handle->peers[peer].adapt_frames = 0;
+    handle->peers[peer].adapt_errors = 0;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
-static inline uint32_t __time_passed_since_last_frame_received(tiny_fd_handle_t handle, uint8_t peer)
+static bool __aggregated_frame_is_ready(tiny_fd_handle_t handle, uint8_t peer, uint32_t now)
 {
-    return (uint32_t)(tiny_millis() - handle->peers[peer].last_ka_ts);
+    tiny_fd_frame_info_t *slot = handle->peers[peer].aggr_frame;
+    // Frame is ready if it has no room for one more message or if the message waited long enough.
+    // The message timestamp is taken by the sending thread, so it can be ahead of the timer wheel time
+    return slot->len + 2 > __get_peer_mtu( handle, peer ) ||
+           (int32_t)(now - handle->peers[peer].aggr_ts) >= (int32_t)handle->aggregation_timeout;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
-static inline uint32_t __time_passed_since_last_marker_seen(tiny_fd_handle_t handle)
+static bool __put_message_to_aggregated_frame(tiny_fd_handle_t handle, uint8_t peer, const void *data, int len)
 {
-    return (uint32_t)(tiny_millis() - handle->last_marker_ts);
+    bool result = false;
+    tiny_mutex_lock(&handle->frames.mutex);
+    tiny_fd_frame_info_t *slot = handle->peers[peer].aggr_frame;
+    if ( handle->peers[peer].aggregation && slot != NULL && slot->len + __aggr_prefix_size(len) + len <= __get_peer_mtu( handle, peer ) &&
+         tiny_fd_queue_resize( &handle->frames.i_queue, slot, slot->len + __aggr_prefix_size(len) + len ) )
+    {
+        slot->len += __aggr_write_prefix(&slot->payload[slot->len], len);
+        memcpy(&slot->payload[slot->len], data, len);
+        slot->len += len;
+        LOG(TINY_LOG_DEB, "[%p] QUEUE I-AGGR: [%02X] [%02X] len=%i\n", handle, slot->header.address, slot->header.control, slot->len);
+        // The grown frame can take the space of the ring queue, reserved for the next frame
+        if ( !tiny_fd_queue_has_free_slots( &handle->frames.i_queue ) )
+        {
+            tiny_events_clear(&handle->events, FD_EVENT_QUEUE_HAS_FREE_SLOTS);
+        }
+        result = true;
+    }
+    tiny_mutex_unlock(&handle->frames.mutex);
+    return result;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -221,7 +482,7 @@ static tiny_fd_frame_info_t *__put_u_s_frame_to_tx_queue(tiny_fd_handle_t handle
         slot->header.address = ((const uint8_t *)data)[0];
         slot->header.control = ((const uint8_t *)data)[1];
         LOG(TINY_LOG_DEB, "[%p] QUEUE SU-PUT: [%02X] [%02X]\n", handle, slot->header.address, slot->header.control);
-        tiny_events_set(&handle->events, FD_EVENT_TX_DATA_AVAILABLE);
+        __set_tx_events(handle, FD_EVENT_TX_DATA_AVAILABLE);
         return slot;
     }
     else
@@ -233,10 +494,93 @@ static tiny_fd_frame_info_t *__put_u_s_frame_to_tx_queue(tiny_fd_handle_t handle
 
 ///////////////////////////////////////////////////////////////////////////////
 
+/**
+ * Writes XID information field with the station parameters: the largest I-frame payload, which the
+ * station can receive, the window, the modulus of sequence numbers and the supported features.
+ */
+static int __xid_write(tiny_fd_handle_t handle, uint8_t *buf)
+{
+    int mtu = tiny_fd_queue_get_mtu( &handle->frames.i_queue );
+    // The field has 2 bytes. Larger mtu, possible with CONFIG_TINY_LARGE_BUFFERS, is limited to 64 KiB - 1
+    if ( mtu > 0xFFFF )
+    {
+        mtu = 0xFFFF;
+    }
+    buf[0] = FD_XID_FORMAT;
+    buf[1] = (uint8_t)(mtu & 0xFF);
+    buf[2] = (uint8_t)(mtu >> 8);
+    buf[3] = handle->window < seq_bits_mask ? handle->window : seq_bits_mask;
+    buf[4] = seq_bits_mask + 1;
+    buf[5] = handle->aggregation ? FD_XID_FEATURE_AGGREGATION : 0;
+    return FD_XID_SIZE;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Selects connection parameters for the peer. If the remote station sent XID information field
+ * in SABM, SNRM or UA frame, the largest common values are used. Otherwise the remote station doesn't
+ * support negotiation, and the station parameters are used as is.
+ * Returns true if XID information field was accepted.
+ */
+static bool __xid_apply(tiny_fd_handle_t handle, uint8_t peer, const uint8_t *data, int len)
+{
+    int mtu = tiny_fd_queue_get_mtu( &handle->frames.i_queue );
+    handle->peers[peer].mtu = mtu;
+    handle->peers[peer].window = handle->window;
+    handle->peers[peer].aggregation = handle->aggregation;
+    // Extra bytes are allowed, so the information field can be extended in future
+    if ( !handle->negotiation || len < 2 + FD_XID_SIZE || data[2] != FD_XID_FORMAT )
+    {
+        return false;
+    }
+    const uint8_t *xid = &data[2];
+    int remote_mtu = xid[1] | (xid[2] << 8);
+    if ( remote_mtu > 0 && remote_mtu < mtu )
+    {
+        handle->peers[peer].mtu = remote_mtu;
+    }
+    if ( xid[3] >= 2 && xid[3] < handle->peers[peer].window )
+    {
+        handle->peers[peer].window = xid[3];
+    }
+    if ( xid[4] != seq_bits_mask + 1 )
+    {
+        // Only modulo 8 is supported, both stations fall back to it
+        LOG(TINY_LOG_WRN, "[%p] Remote side proposes modulo %i, using %i\n", handle, xid[4], seq_bits_mask + 1);
+    }
+    handle->peers[peer].aggregation = handle->aggregation && (xid[5] & FD_XID_FEATURE_AGGREGATION);
+    LOG(TINY_LOG_INFO, "[%p] Negotiated mtu=%i, window=%i, features=%02X\n", handle, handle->peers[peer].mtu,
+        handle->peers[peer].window, xid[5]);
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Puts SABM or SNRM frame to the queue. If negotiation is enabled, the frame carries XID information field.
+ */
+static tiny_fd_frame_info_t *__put_connect_frame_to_tx_queue(tiny_fd_handle_t handle, int type, uint8_t address)
+{
+    uint8_t frame[sizeof(tiny_frame_header_t) + FD_XID_SIZE];
+    frame[0] = address;
+    frame[1] = (handle->mode == TINY_FD_MODE_NRM ? HDLC_U_FRAME_TYPE_SNRM : HDLC_U_FRAME_TYPE_SABM) | HDLC_U_FRAME_BITS;
+    int len = sizeof(tiny_frame_header_t) + (handle->negotiation ? __xid_write(handle, &frame[2]) : 0);
+    return __put_u_s_frame_to_tx_queue(handle, type, frame, len);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 static bool __can_accept_i_frames(tiny_fd_handle_t handle, uint8_t peer)
 {
     uint8_t next_last_ns = (handle->peers[peer].last_ns + 1) & seq_bits_mask;
     bool can_accept = next_last_ns != handle->peers[peer].confirm_ns;
+    if ( can_accept )
+    {
+        // The number of frames in flight can be less than the window, negotiated or selected in adaptive mode
+        can_accept = ((handle->peers[peer].last_ns - handle->peers[peer].confirm_ns) & seq_bits_mask) <
+                     (handle->adaptive ? handle->peers[peer].adapt_window : handle->peers[peer].window);
+    }
     return can_accept;
 }
 
@@ -244,7 +588,9 @@ static bool __can_accept_i_frames(tiny_fd_handle_t handle, uint8_t peer)
 
 static bool __put_i_frame_to_tx_queue(tiny_fd_handle_t handle, uint8_t peer, const void *data, int len)
 {
-    tiny_fd_frame_info_t *slot = tiny_fd_queue_allocate( &handle->frames.i_queue, TINY_FD_QUEUE_I_FRAME, data, len );
+    // In aggregated format the message is prefixed with its length
+    int prefix_size = handle->peers[peer].aggregation ? __aggr_prefix_size(len) : 0;
+    tiny_fd_frame_info_t *slot = tiny_fd_queue_allocate( &handle->frames.i_queue, TINY_FD_QUEUE_I_FRAME, NULL, prefix_size + len );
     // Check if space is actually available
     if ( slot != NULL )
     {
@@ -252,7 +598,14 @@ static bool __put_i_frame_to_tx_queue(tiny_fd_handle_t handle, uint8_t peer, con
         slot->header.address = __peer_to_address_field( handle, peer );
         slot->header.control = handle->peers[peer].last_ns << 1;
         handle->peers[peer].last_ns = (handle->peers[peer].last_ns + 1) & seq_bits_mask;
-        tiny_events_set(&handle->events, FD_EVENT_TX_DATA_AVAILABLE);
+        memcpy(&slot->payload[prefix_size], data, len);
+        if ( handle->peers[peer].aggregation )
+        {
+            __aggr_write_prefix(&slot->payload[0], len);
+            handle->peers[peer].aggr_frame = slot;
+            handle->peers[peer].aggr_ts = tiny_millis();
+        }
+        __set_tx_events(handle, FD_EVENT_TX_DATA_AVAILABLE);
         return true;
     }
     return false;
@@ -274,6 +627,7 @@ static int __check_received_frame(tiny_fd_handle_t handle, uint8_t peer, uint8_t
     {
         // definitely we need to send reject. We want to see next_nr frame
         LOG(TINY_LOG_ERR, "[%p] Out of order I-Frame N(s)=%d\n", handle, ns);
+        handle->stats.out_of_order++;
         if ( !handle->peers[peer].sent_reject )
         {
             tiny_frame_header_t frame = {
@@ -281,6 +635,7 @@ static int __check_received_frame(tiny_fd_handle_t handle, uint8_t peer, uint8_t
                 .control = HDLC_S_FRAME_BITS | HDLC_S_FRAME_TYPE_REJ | (handle->peers[peer].next_nr << 5),
             };
             handle->peers[peer].sent_reject = 1;
+            handle->stats.rej_sent++;
             __put_u_s_frame_to_tx_queue(handle, TINY_FD_QUEUE_S_FRAME, &frame, sizeof(tiny_frame_header_t));
         }
         result = TINY_ERR_FAILED;
@@ -290,8 +645,15 @@ static int __check_received_frame(tiny_fd_handle_t handle, uint8_t peer, uint8_t
 
 ///////////////////////////////////////////////////////////////////////////////
 
-static void __confirm_sent_frames(tiny_fd_handle_t handle, uint8_t peer, uint8_t nr)
+static bool __confirm_sent_frames(tiny_fd_handle_t handle, uint8_t peer, uint8_t nr)
 {
+    // N(r) can confirm only queued frames. Other values come from the frames of previous connection,
+    // for example, when the remote side restarts. Such frames must not move the window.
+    if ( ((nr - handle->peers[peer].confirm_ns) & seq_bits_mask) > __number_of_awaiting_tx_i_frames( handle, peer ) )
+    {
+        LOG(TINY_LOG_ERR, "[%p] Confirmation N(r)=%d is out of window, ignoring\n", handle, nr);
+        return false;
+    }
     // all frames below nr are received
     while ( nr != handle->peers[peer].confirm_ns )
     {
@@ -308,10 +670,23 @@ static void __confirm_sent_frames(tiny_fd_handle_t handle, uint8_t peer, uint8_t
         {
             if ( handle->on_send_cb )
             {
+                const uint8_t peer_addr = __is_primary_station( handle ) ? (__peer_to_address_field( handle, peer ) >> 2) : TINY_FD_PRIMARY_ADDR;
                 tiny_mutex_unlock(&handle->frames.mutex);
-                handle->on_send_cb(handle->user_data,
-                                   __is_primary_station( handle ) ? (__peer_to_address_field( handle, peer ) >> 2) : TINY_FD_PRIMARY_ADDR,
-                                   &slot->payload[0], slot->len);
+                if ( handle->peers[peer].aggregation )
+                {
+                    uint8_t *ptr = &slot->payload[0];
+                    int size = slot->len;
+                    int msg_len;
+                    uint8_t *msg;
+                    while ( (msg = __aggr_get_next_message(&ptr, &size, &msg_len)) != NULL )
+                    {
+                        handle->on_send_cb(handle->user_data, peer_addr, msg, msg_len);
+                    }
+                }
+                else
+                {
+                    handle->on_send_cb(handle->user_data, peer_addr, &slot->payload[0], slot->len);
+                }
                 tiny_mutex_lock(&handle->frames.mutex);
             }
             tiny_fd_queue_free( &handle->frames.i_queue, slot );
@@ -337,12 +712,17 @@ static void __confirm_sent_frames(tiny_fd_handle_t handle, uint8_t peer, uint8_t
     }
     LOG(TINY_LOG_DEB, "[%p] Last confirmed frame: %02X\n", handle, handle->peers[peer].confirm_ns);
     // LOG("[%p] N(S)=%d, N(R)=%d\n", handle, handle->peers[peer].confirm_ns, handle->peers[peer].next_nr);
+    return true;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
 static void __resend_all_unconfirmed_frames(tiny_fd_handle_t handle, uint8_t peer, uint8_t control, uint8_t nr)
 {
+    if ( handle->peers[peer].next_ns != nr )
+    {
+        __adapt_on_error( handle, peer );
+    }
     // First, we need to check if that is possible. Maybe remote side is not in sync
     while ( handle->peers[peer].next_ns != nr )
     {
@@ -361,9 +741,10 @@ static void __resend_all_unconfirmed_frames(tiny_fd_handle_t handle, uint8_t pee
             break;
         }
         handle->peers[peer].next_ns = (handle->peers[peer].next_ns - 1) & seq_bits_mask;
+        handle->stats.retransmissions++;
     }
     LOG(TINY_LOG_DEB, "[%p] N(s) is set to %02X\n", handle, handle->peers[peer].next_ns);
-    tiny_events_set(&handle->events, FD_EVENT_TX_DATA_AVAILABLE);
+    __set_tx_events(handle, FD_EVENT_TX_DATA_AVAILABLE);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -379,11 +760,13 @@ static void __switch_to_connected_state(tiny_fd_handle_t handle, uint8_t peer)
         handle->peers[peer].next_nr = 0;
         handle->peers[peer].sent_nr = 0;
         handle->peers[peer].sent_reject = 0;
+        handle->peers[peer].aggr_frame = NULL;
+        __adapt_reset( handle, peer );
         tiny_fd_queue_reset_for( &handle->frames.i_queue, __peer_to_address_field( handle, peer ) );
-        handle->peers[peer].last_ka_ts = tiny_millis();
+        handle->peers[peer].last_ka_ts = __get_time(handle);
         tiny_events_set(&handle->peers[peer].events, FD_EVENT_CAN_ACCEPT_I_FRAMES);
-        tiny_events_set(
-            &handle->events,
+        __set_tx_events(
+            handle,
             FD_EVENT_TX_DATA_AVAILABLE |
                 (tiny_fd_queue_has_free_slots(&handle->frames.i_queue) ? FD_EVENT_QUEUE_HAS_FREE_SLOTS : 0));
         LOG(TINY_LOG_CRIT, "[%p] Connection is established\n", handle);
@@ -411,6 +794,7 @@ static void __switch_to_disconnected_state(tiny_fd_handle_t handle, uint8_t peer
         handle->peers[peer].next_nr = 0;
         handle->peers[peer].sent_nr = 0;
         handle->peers[peer].sent_reject = 0;
+        handle->peers[peer].aggr_frame = NULL;
         tiny_fd_queue_reset_for( &handle->frames.i_queue, __peer_to_address_field( handle, peer ) );
         tiny_events_clear(&handle->peers[peer].events, FD_EVENT_CAN_ACCEPT_I_FRAMES);
         LOG(TINY_LOG_CRIT, "[%p] Disconnected\n", handle);
@@ -427,6 +811,50 @@ static void __switch_to_disconnected_state(tiny_fd_handle_t handle, uint8_t peer
 
 ///////////////////////////////////////////////////////////////////////////////
 
+static void __restart_connection(tiny_fd_handle_t handle, uint8_t peer)
+{
+    uint8_t address = __peer_to_address_field( handle, peer );
+    uint8_t count = __number_of_awaiting_tx_i_frames( handle, peer );
+    tiny_fd_frame_info_t *frames[seq_bits_mask + 1];
+    // Collect all frames first, since new numbers overlap the numbers of the old connection
+    for ( uint8_t i = 0; i < count; i++ )
+    {
+        frames[i] = tiny_fd_queue_get_next( &handle->frames.i_queue, TINY_FD_QUEUE_I_FRAME, address,
+                                            (handle->peers[peer].confirm_ns + i) & seq_bits_mask );
+    }
+    // Unconfirmed frames are kept and sent to the new connection from N(S)=0
+    uint8_t ns = 0;
+    for ( uint8_t i = 0; i < count; i++ )
+    {
+        if ( frames[i] != NULL )
+        {
+            frames[i]->header.control = ns << 1;
+            ns++;
+        }
+    }
+    handle->peers[peer].confirm_ns = 0;
+    handle->peers[peer].last_ns = ns;
+    handle->peers[peer].next_ns = 0;
+    handle->peers[peer].next_nr = 0;
+    handle->peers[peer].sent_nr = 0;
+    handle->peers[peer].sent_reject = 0;
+    handle->peers[peer].retries = handle->retries;
+    handle->peers[peer].last_ka_ts = __get_time(handle);
+    __adapt_reset( handle, peer );
+    __set_tx_events(handle, FD_EVENT_TX_DATA_AVAILABLE);
+    LOG(TINY_LOG_CRIT, "[%p] Connection is restarted by remote side, %d frames to resend\n", handle, ns);
+    if ( handle->on_connect_event_cb )
+    {
+        uint8_t station = __is_primary_station( handle ) ? (address >> 2) : TINY_FD_PRIMARY_ADDR;
+        tiny_mutex_unlock(&handle->frames.mutex);
+        handle->on_connect_event_cb(handle->user_data, station, false);
+        handle->on_connect_event_cb(handle->user_data, station, true);
+        tiny_mutex_lock(&handle->frames.mutex);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 static int __on_i_frame_read(tiny_fd_handle_t handle, uint8_t peer, void *data, int len)
 {
     uint8_t control = ((uint8_t *)data)[1];
@@ -438,12 +866,28 @@ static int __on_i_frame_read(tiny_fd_handle_t handle, uint8_t peer, void *data,
     // Provide data to user only if we expect this frame
     if ( result == TINY_SUCCESS )
     {
+        handle->stats.rx_i_frames++;
+        handle->stats.rx_bytes += len - 2;
         if ( handle->on_read_cb )
         {
+            const uint8_t peer_addr = __is_primary_station( handle ) ? (__peer_to_address_field( handle, peer ) >> 2) : TINY_FD_PRIMARY_ADDR;
             tiny_mutex_unlock(&handle->frames.mutex);
-            handle->on_read_cb(handle->user_data,
-                               __is_primary_station( handle ) ? (__peer_to_address_field( handle, peer ) >> 2) : TINY_FD_PRIMARY_ADDR,
-                               (uint8_t *)data + 2, len - 2);
+            if ( handle->peers[peer].aggregation )
+            {
+                // Split aggregated I-frame back to separate messages
+                uint8_t *ptr = (uint8_t *)data + 2;
+                int size = len - 2;
+                int msg_len;
+                uint8_t *msg;
+                while ( (msg = __aggr_get_next_message(&ptr, &size, &msg_len)) != NULL )
+                {
+                    handle->on_read_cb(handle->user_data, peer_addr, msg, msg_len);
+                }
+            }
+            else
+            {
+                handle->on_read_cb(handle->user_data, peer_addr, (uint8_t *)data + 2, len - 2);
+            }
             tiny_mutex_lock(&handle->frames.mutex);
         }
         // Decide whenever we need to send RR after user callback
@@ -473,8 +917,11 @@ static int __on_s_frame_read(tiny_fd_handle_t handle, uint8_t peer, void *data,
         ((control >> 2) & 0x03) == 0x00 ? "RR" : "REJ", ((uint8_t *)data)[0]);
     if ( (control & HDLC_S_FRAME_TYPE_MASK) == HDLC_S_FRAME_TYPE_REJ )
     {
-        __confirm_sent_frames(handle, peer, nr);
-        __resend_all_unconfirmed_frames(handle, peer, control, nr);
+        handle->stats.rej_received++;
+        if ( __confirm_sent_frames(handle, peer, nr) )
+        {
+            __resend_all_unconfirmed_frames(handle, peer, control, nr);
+        }
     }
     else if ( (control & HDLC_S_FRAME_TYPE_MASK) == HDLC_S_FRAME_TYPE_RR )
     {
@@ -505,12 +952,26 @@ static int __on_u_frame_read(tiny_fd_handle_t handle, uint8_t peer, void *data,
     LOG(TINY_LOG_INFO, "[%p] Receiving U-Frame type=%02X with address [%02X]\n", handle, type, ((uint8_t *)data)[0]);
     if ( type == HDLC_U_FRAME_TYPE_SABM || type == HDLC_U_FRAME_TYPE_SNRM )
     {
-        tiny_frame_header_t frame = {
-            .address = __peer_to_address_field( handle, peer ),
-            .control = HDLC_U_FRAME_TYPE_UA | HDLC_U_FRAME_BITS,
+        uint8_t frame[sizeof(tiny_frame_header_t) + FD_XID_SIZE] = {
+            __peer_to_address_field( handle, peer ),
+            HDLC_U_FRAME_TYPE_UA | HDLC_U_FRAME_BITS,
         };
-        __put_u_s_frame_to_tx_queue(handle, TINY_FD_QUEUE_U_FRAME, &frame, 2);
-        __switch_to_connected_state(handle, peer);
+        // UA carries XID information field only in response to XID, so old stations see usual UA frame
+        int frame_len = sizeof(tiny_frame_header_t);
+        if ( __xid_apply(handle, peer, (const uint8_t *)data, len) )
+        {
+            frame_len += __xid_write(handle, &frame[2]);
+        }
+        __put_u_s_frame_to_tx_queue(handle, TINY_FD_QUEUE_U_FRAME, frame, frame_len);
+        if ( handle->peers[peer].state == TINY_FD_STATE_CONNECTED )
+        {
+            // SABM in connected state means that the remote side restarted the link
+            __restart_connection(handle, peer);
+        }
+        else
+        {
+            __switch_to_connected_state(handle, peer);
+        }
     }
     else if ( type == HDLC_U_FRAME_TYPE_DISC )
     {
@@ -536,6 +997,7 @@ static int __on_u_frame_read(tiny_fd_handle_t handle, uint8_t peer, void *data,
         if ( handle->peers[peer].state == TINY_FD_STATE_CONNECTING )
         {
             // confirmation received
+            __xid_apply(handle, peer, (const uint8_t *)data, len);
             __switch_to_connected_state(handle, peer);
         }
         else if ( handle->peers[peer].state == TINY_FD_STATE_DISCONNECTING )
@@ -552,6 +1014,14 @@ static int __on_u_frame_read(tiny_fd_handle_t handle, uint8_t peer, void *data,
 
 ///////////////////////////////////////////////////////////////////////////////
 
+static bool on_frame_filter(void *user_data, uint8_t address)
+{
+    // Frames for other stations on the shared bus are dropped before they are received
+    return __address_field_to_peer( (tiny_fd_handle_t)user_data, address ) != 0xFF;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 static void on_frame_read(void *user_data, uint8_t *data, int len)
 {
     tiny_fd_handle_t handle = (tiny_fd_handle_t)user_data;
@@ -567,7 +1037,7 @@ static void on_frame_read(void *user_data, uint8_t *data, int len)
         return;
     }
     tiny_mutex_lock(&handle->frames.mutex);
-    handle->peers[peer].last_ka_ts = tiny_millis();
+    handle->peers[peer].last_ka_ts = __get_time(handle);
     handle->peers[peer].ka_confirmed = 1;
     uint8_t control = ((uint8_t *)data)[1];
     if ( (control & HDLC_U_FRAME_MASK) == HDLC_U_FRAME_MASK )
@@ -579,11 +1049,7 @@ static void on_frame_read(void *user_data, uint8_t *data, int len)
         // Should send DM in case we receive here S- or I-frames.
         // If connection is not established, we should ignore all frames except U-frames
         LOG(TINY_LOG_CRIT, "[%p] Connection is not established, connecting\n", handle);
-        tiny_frame_header_t frame = {
-            .address = __peer_to_address_field( handle, peer ) | HDLC_CR_BIT,
-            .control = (handle->mode == TINY_FD_MODE_NRM ? HDLC_U_FRAME_TYPE_SNRM : HDLC_U_FRAME_TYPE_SABM) | HDLC_U_FRAME_BITS,
-        };
-        __put_u_s_frame_to_tx_queue(handle, TINY_FD_QUEUE_U_FRAME, &frame, 2);
+        __put_connect_frame_to_tx_queue(handle, TINY_FD_QUEUE_U_FRAME, __peer_to_address_field( handle, peer ) | HDLC_CR_BIT);
         handle->peers[peer].state = TINY_FD_STATE_CONNECTING;
     }
     else if ( (control & HDLC_I_FRAME_MASK) == HDLC_I_FRAME_BITS )
@@ -606,7 +1072,7 @@ static void on_frame_read(void *user_data, uint8_t *data, int len)
             LOG(TINY_LOG_INFO, "[%p] [CAPTURED MARKER]\n", handle);
         }
         // Cool! Now we have marker again, and we can send
-        tiny_events_set( &handle->events, FD_EVENT_HAS_MARKER );
+        __set_tx_events( handle, FD_EVENT_HAS_MARKER );
     }
     tiny_mutex_unlock(&handle->frames.mutex);
 }
@@ -658,6 +1124,36 @@ static void on_frame_send(void *user_data, const uint8_t *data, int len)
 
 ///////////////////////////////////////////////////////////////////////////////
 
+static int __get_layout(const tiny_fd_init_t *init, int mtu, tiny_fd_layout_t *layout)
+{
+    const uint8_t peers_count = init->peers_count == 0 ? 1 : init->peers_count;
+    layout->fd_data = (int)TINY_FD_DATA_REGION_SIZE;
+    layout->i_queue = (int)TINY_FD_I_QUEUE_REGION_SIZE(mtu, init->window_frames, init->tx_ring_size);
+    layout->s_queue = (int)TINY_FD_S_QUEUE_REGION_SIZE;
+    layout->peers = (int)TINY_FD_PEERS_REGION_SIZE(peers_count);
+    // Parity fields of FEC are kept by hdlc level next to the rx ring
+    layout->rx_ring = (int)TINY_FD_RX_RING_REGION_SIZE(mtu, init->crc_type, 1) +
+                      (int)HDLC_LL_FEC_BUF_SIZE(mtu + (int)sizeof(tiny_frame_header_t), init->crc_type, init->fec, 1);
+    // Space to align user buffer, which can have any alignment
+    layout->padding = TINY_ALIGN_STRUCT_VALUE - 1;
+    layout->total = layout->fd_data + layout->i_queue + layout->s_queue + layout->peers + layout->rx_ring + layout->padding;
+    return layout->total;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static bool __buffer_fits_mtu(const tiny_fd_init_t *init, int mtu, int available)
+{
+    if ( init->tx_ring_size && (int)TINY_FD_QUEUE_SLOT_SIZE(mtu) > (int)TINY_ALIGN_SIZE(init->tx_ring_size) )
+    {
+        return false;
+    }
+    tiny_fd_layout_t layout;
+    return __get_layout(init, mtu, &layout) - layout.padding <= available;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 int tiny_fd_init(tiny_fd_handle_t *handle, tiny_fd_init_t *init)
 {
     const uint8_t peers_count = init->peers_count == 0 ? 1 : init->peers_count;
@@ -667,20 +1163,36 @@ int tiny_fd_init(tiny_fd_handle_t *handle, tiny_fd_init_t *init)
         LOG(TINY_LOG_CRIT, "Invalid input data: null pointers%s", "\n");
         return TINY_ERR_INVALID_DATA;
     }
+    /* Buffer space available for the protocol data after alignment of the buffer */
+    const int available = (int)init->buffer_size - (int)(TINY_ALIGN_BUFFER(init->buffer) - (uint8_t *)init->buffer);
+    tiny_fd_layout_t layout;
     if ( init->mtu == 0 )
     {
-        int size = tiny_fd_buffer_size_by_mtu_ex(peers_count, 0, init->window_frames, init->crc_type, 1);
-        init->mtu = (init->buffer_size - size) / (init->window_frames + 1);
+        int size = __get_layout(init, 0, &layout) - layout.padding;
+        /* With tx ring only rx ring depends on mtu, but the tx ring must fit the frame of mtu size */
+        init->mtu = (available - size) / (init->tx_ring_size ? 1 : (init->window_frames + 1));
+        if ( init->tx_ring_size && init->mtu > init->tx_ring_size - (int)TINY_FD_QUEUE_SLOT_SIZE(0) )
+        {
+            init->mtu = init->tx_ring_size - (int)TINY_FD_QUEUE_SLOT_SIZE(0);
+        }
+        /* Frame slots are aligned, so the estimation can differ from the largest possible mtu by alignment */
+        while ( __buffer_fits_mtu(init, init->mtu + 1, available) )
+        {
+            init->mtu++;
+        }
+        while ( init->mtu > 0 && !__buffer_fits_mtu(init, init->mtu, available) )
+        {
+            init->mtu--;
+        }
         if ( init->mtu < 1 )
         {
             LOG(TINY_LOG_CRIT, "Calculated mtu size is zero, no payload transfer is available%s", "\n");
             return TINY_ERR_OUT_OF_MEMORY;
         }
     }
-    if ( init->buffer_size < tiny_fd_buffer_size_by_mtu_ex(peers_count, init->mtu, init->window_frames, init->crc_type, 1) )
+    if ( available < __get_layout(init, init->mtu, &layout) - layout.padding )
     {
-        LOG(TINY_LOG_CRIT, "Too small buffer for FD protocol %i < %i\n", init->buffer_size,
-            tiny_fd_buffer_size_by_mtu_ex(peers_count, init->mtu, init->window_frames, init->crc_type, 1));
+        LOG(TINY_LOG_CRIT, "Too small buffer for FD protocol %i < %i\n", available, layout.total - layout.padding);
         return TINY_ERR_OUT_OF_MEMORY;
     }
     if ( init->window_frames < 2 )
@@ -695,39 +1207,29 @@ int tiny_fd_init(tiny_fd_handle_t *handle, tiny_fd_init_t *init)
     }
     memset(init->buffer, 0, init->buffer_size);
 
-    /* Lets locate main FD protocol data at the beginning of specified buffer.
+    /* Regions are placed according to tiny_fd_get_layout(), every region starts at aligned address.
+     * Lets locate main FD protocol data at the beginning of specified buffer.
      * The buffer must be properly aligned for ARM processors to get correct alignment for tiny_fd_data_t structure.
      * That's why we allocate the space for the tiny_fd_data_t structure at the beginning. */
     uint8_t *ptr = TINY_ALIGN_BUFFER(init->buffer);
     tiny_fd_data_t *protocol = (tiny_fd_data_t *)ptr;
-    ptr += sizeof(tiny_fd_data_t);
-    /* Next let's allocate the space for low level hdlc structure. It will be located right next to the tiny_fd_data_t.
-     * To do that we need to calculate the size required for all FD buffers
-     * We do not need to align the buffer for the HDLC level, since it done by low level API. */
-    uint8_t *hdlc_ll_ptr = ptr;
-    // TODO: Hack: remove - 4
-    int hdlc_ll_size = (int)((uint8_t *)init->buffer + init->buffer_size - ptr - 4 - // Remaining size
-                             init->window_frames *                               // Number of frames multiply by frame size (headers + payload + pointers)
-                                 ( sizeof(tiny_fd_frame_info_t *) + init->mtu + sizeof(tiny_fd_frame_info_t) - sizeof(((tiny_fd_frame_info_t *)0)->payload) ) -
-                             TINY_FD_U_QUEUE_MAX_SIZE *
-                                 (sizeof(tiny_fd_frame_info_t *) + sizeof(tiny_fd_frame_info_t)) -
-                             peers_count * sizeof(tiny_fd_peer_info_t));
-    /* All FD protocol structures must be aligned. */
-    hdlc_ll_size &= ~(TINY_ALIGN_STRUCT_VALUE - 1);
-    ptr += hdlc_ll_size;
-    ptr = TINY_ALIGN_BUFFER(ptr);
-
-    /* Next we need some space to hold pointers to tiny_i_frame_info_t records (window_frames pointers) */
-    int queue_size = tiny_fd_queue_init( &protocol->frames.i_queue, ptr, (int)((uint8_t *)init->buffer + init->buffer_size - ptr),
-                                         init->window_frames, init->mtu );
+    ptr += TINY_FD_DATA_REGION_SIZE;
+
+    /* Next we need some space to hold I-frames (window_frames) and pointers to them */
+    int queue_size = init->tx_ring_size
+                         ? tiny_fd_queue_init_ring( &protocol->frames.i_queue, ptr,
+                                                    (int)TINY_FD_I_QUEUE_REGION_SIZE(init->mtu, init->window_frames, init->tx_ring_size),
+                                                    init->window_frames, init->mtu, init->tx_ring_size )
+                         : tiny_fd_queue_init( &protocol->frames.i_queue, ptr,
+                                               (int)TINY_FD_I_QUEUE_REGION_SIZE(init->mtu, init->window_frames, 0),
+                                               init->window_frames, init->mtu );
     if ( queue_size < 0 )
     {
         return queue_size;
     }
     ptr += queue_size;
-    ptr = TINY_ALIGN_BUFFER(ptr);
-    queue_size = tiny_fd_queue_init( &protocol->frames.s_queue, ptr, (int)((uint8_t *)init->buffer + init->buffer_size - ptr),
-                                     TINY_FD_U_QUEUE_MAX_SIZE, 2 );
+    queue_size = tiny_fd_queue_init( &protocol->frames.s_queue, ptr, (int)TINY_FD_S_QUEUE_REGION_SIZE,
+                                     TINY_FD_U_QUEUE_MAX_SIZE, TINY_FD_U_QUEUE_MTU );
     if ( queue_size < 0 )
     {
         return queue_size;
@@ -735,27 +1237,29 @@ int tiny_fd_init(tiny_fd_handle_t *handle, tiny_fd_init_t *init)
     ptr += queue_size;
 
     /* Next we allocate some space for peer-related data */
-    ptr = TINY_ALIGN_BUFFER(ptr);
     protocol->peers_count = peers_count;
     protocol->peers = (tiny_fd_peer_info_t *)ptr;
     protocol->next_peer = 0;
-    ptr += sizeof(tiny_fd_peer_info_t) * peers_count;
+    ptr += TINY_FD_PEERS_REGION_SIZE(peers_count);
+
+    /* The rest of the buffer is used by low level hdlc structure and rx ring.
+     * The size was checked above, so at least rx ring of single frame fits the buffer. */
+    uint8_t *hdlc_ll_ptr = ptr;
+    int hdlc_ll_size = (int)((uint8_t *)init->buffer + init->buffer_size - ptr);
 
-    if ( ptr > (uint8_t *)init->buffer + init->buffer_size )
-    {
-        LOG(TINY_LOG_CRIT, "Out of provided memory: provided %i bytes, used %i bytes\n", init->buffer_size,
-            (int)(ptr - (uint8_t *)init->buffer));
-        return TINY_ERR_OUT_OF_MEMORY;
-    }
     /* Lets initialize memory for HDLC low level protocol */
     hdlc_ll_init_t _init = { 0 };
     _init.on_frame_read = on_frame_read;
     _init.on_frame_send = on_frame_send;
+    _init.on_frame_filter = on_frame_filter;
     _init.user_data = protocol;
     _init.crc_type = init->crc_type;
+    _init.framing = init->framing;
     _init.buf_size = hdlc_ll_size;
     _init.buf = hdlc_ll_ptr;
     _init.mtu = init->mtu + sizeof(tiny_frame_header_t);
+    _init.rx_compact = init->rx_compact;
+    _init.fec = init->fec;
 
     int result = hdlc_ll_init(&protocol->_hdlc, &_init);
     if ( result != TINY_SUCCESS )
@@ -772,6 +1276,13 @@ int tiny_fd_init(tiny_fd_handle_t *handle, tiny_fd_init_t *init)
     // By default assign primary address
     protocol->addr = (init->addr ? (init->addr << 2) : HDLC_PRIMARY_ADDR ) | HDLC_E_BIT;
     protocol->mode = init->mode;
+    protocol->aggregation = init->aggregation;
+    protocol->aggregation_timeout = init->aggregation_timeout;
+    protocol->timer_wheel = init->timer_wheel;
+    tiny_timer_init(&protocol->marker_timer, __on_timer, protocol);
+    protocol->adaptive = init->adaptive;
+    protocol->negotiation = init->negotiation;
+    protocol->window = init->window_frames;
     // Primary devices always have markers
     protocol->ka_timeout = 5000;
     protocol->retry_timeout =
@@ -792,6 +1303,9 @@ int tiny_fd_init(tiny_fd_handle_t *handle, tiny_fd_init_t *init)
             protocol->peers[peer].addr = 0xFF;
         }
         protocol->peers[peer].state = TINY_FD_STATE_DISCONNECTED;
+        tiny_timer_init(&protocol->peers[peer].timer, __on_timer, protocol);
+        __xid_apply( protocol, peer, NULL, 0 );
+        __adapt_reset( protocol, peer );
         tiny_events_create(&protocol->peers[peer].events);
     }
 
@@ -809,8 +1323,16 @@ int tiny_fd_init(tiny_fd_handle_t *handle, tiny_fd_init_t *init)
 void tiny_fd_close(tiny_fd_handle_t handle)
 {
     hdlc_ll_close(handle->_hdlc);
+    if ( handle->timer_wheel )
+    {
+        tiny_timer_stop(handle->timer_wheel, &handle->marker_timer);
+    }
     for (uint8_t peer = 0; peer < handle->peers_count; peer++ )
     {
+        if ( handle->timer_wheel )
+        {
+            tiny_timer_stop(handle->timer_wheel, &handle->peers[peer].timer);
+        }
         tiny_events_destroy(&handle->peers[peer].events);
     }
     tiny_events_destroy(&handle->events);
@@ -829,6 +1351,17 @@ int tiny_fd_on_rx_data(tiny_fd_handle_t handle, const void *data, int len)
         if ( error == TINY_ERR_WRONG_CRC )
         {
             LOG(TINY_LOG_WRN, "[%p] HDLC CRC sum mismatch\n", handle);
+            tiny_mutex_lock(&handle->frames.mutex);
+            handle->stats.crc_errors++;
+            // The frame address is unknown, so the error is accounted for all connected peers
+            for (uint8_t peer = 0; peer < handle->peers_count; peer++ )
+            {
+                if ( handle->peers[peer].state == TINY_FD_STATE_CONNECTED )
+                {
+                    __adapt_on_error( handle, peer );
+                }
+            }
+            tiny_mutex_unlock(&handle->frames.mutex);
         }
         ptr += processed_bytes;
         len -= processed_bytes;
@@ -838,15 +1371,33 @@ int tiny_fd_on_rx_data(tiny_fd_handle_t handle, const void *data, int len)
 
 ///////////////////////////////////////////////////////////////////////////////
 
-int tiny_fd_run_rx(tiny_fd_handle_t handle, read_block_cb_t read_func)
+int tiny_fd_run_rx_ex(tiny_fd_handle_t handle, read_block_cb_t read_func, void *user_data, void *buf, int size)
 {
-    uint8_t buf[4];
-    int len = read_func(handle->user_data, buf, sizeof(buf));
-    if ( len <= 0 )
+    int total = 0;
+    for ( ;; )
     {
-        return len;
+        int len = read_func(user_data, buf, size);
+        if ( len <= 0 )
+        {
+            return total ? total : len;
+        }
+        tiny_fd_on_rx_data(handle, buf, len);
+        total += len;
+        // Partially filled buffer means there is no more data in the channel
+        if ( len < size )
+        {
+            break;
+        }
     }
-    return tiny_fd_on_rx_data(handle, buf, len);
+    return total;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+int tiny_fd_run_rx(tiny_fd_handle_t handle, read_block_cb_t read_func)
+{
+    uint8_t buf[TINY_FD_RX_BLOCK_SIZE];
+    return tiny_fd_run_rx_ex(handle, read_func, handle->user_data, buf, sizeof(buf));
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -883,7 +1434,7 @@ static uint8_t *tiny_fd_get_next_s_u_frame_to_send(tiny_fd_handle_t handle, int
 
 ///////////////////////////////////////////////////////////////////////////////
 
-static uint8_t *tiny_fd_get_next_i_frame(tiny_fd_handle_t handle, int *len, uint8_t peer, uint8_t address)
+static uint8_t *tiny_fd_get_next_i_frame(tiny_fd_handle_t handle, int *len, uint8_t peer, uint8_t address, uint32_t now)
 {
     uint8_t *data = NULL;
     tiny_fd_frame_info_t *ptr = NULL;
@@ -893,6 +1444,15 @@ static uint8_t *tiny_fd_get_next_i_frame(tiny_fd_handle_t handle, int *len, uint
         return NULL;
     }
     ptr = tiny_fd_queue_get_next( &handle->frames.i_queue, TINY_FD_QUEUE_I_FRAME, address, handle->peers[peer].next_ns );
+    if ( ptr != NULL && ptr == handle->peers[peer].aggr_frame )
+    {
+        // Hold aggregated frame until it is full or aggregation timeout expires
+        if ( !__aggregated_frame_is_ready( handle, peer, now ) )
+        {
+            return NULL;
+        }
+        handle->peers[peer].aggr_frame = NULL;
+    }
     if ( ptr != NULL )
     {
         data = (uint8_t *)&ptr->header;
@@ -901,18 +1461,21 @@ static uint8_t *tiny_fd_get_next_i_frame(tiny_fd_handle_t handle, int *len, uint
             handle->peers[peer].next_ns, data[0], __is_primary_station( handle ) ? "secondary" : "primary" );
         ptr->header.control &= 0x0F;
         ptr->header.control |= (handle->peers[peer].next_nr << 5);
+        handle->stats.tx_i_frames++;
+        handle->stats.tx_bytes += ptr->len;
+        __adapt_on_i_frame_sent( handle, peer, handle->peers[peer].next_ns );
         handle->peers[peer].next_ns++;
         handle->peers[peer].next_ns &= seq_bits_mask;
         // Move to different place
         handle->peers[peer].sent_nr = handle->peers[peer].next_nr;
-        handle->peers[peer].last_i_ts = tiny_millis();
+        handle->peers[peer].last_i_ts = now;
     }
     return data;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
-static uint8_t *tiny_fd_get_next_frame_to_send(tiny_fd_handle_t handle, int *len, uint8_t peer)
+static uint8_t *tiny_fd_get_next_frame_to_send(tiny_fd_handle_t handle, int *len, uint8_t peer, uint32_t now)
 {
     uint8_t *data;
     // Tx data available
@@ -921,7 +1484,7 @@ static uint8_t *tiny_fd_get_next_frame_to_send(tiny_fd_handle_t handle, int *len
     data = tiny_fd_get_next_s_u_frame_to_send(handle, len, peer, address);
     if ( data == NULL )
     {
-        data = tiny_fd_get_next_i_frame(handle, len, peer, address);
+        data = tiny_fd_get_next_i_frame(handle, len, peer, address, now);
     }
     if ( data == NULL && handle->mode == TINY_FD_MODE_NRM )
     {
@@ -930,11 +1493,7 @@ static uint8_t *tiny_fd_get_next_frame_to_send(tiny_fd_handle_t handle, int *len
         if ( __is_primary_station( handle ) &&
             ( handle->peers[peer].state == TINY_FD_STATE_DISCONNECTED || handle->peers[peer].state == TINY_FD_STATE_CONNECTING))
         {
-            tiny_frame_header_t frame = {
-                .address = address,
-                .control = HDLC_U_FRAME_TYPE_SNRM | HDLC_U_FRAME_BITS,
-            };
-            __put_u_s_frame_to_tx_queue(handle, TINY_FD_QUEUE_S_FRAME, &frame, 2);
+            __put_connect_frame_to_tx_queue(handle, TINY_FD_QUEUE_S_FRAME, address);
         }
         else
         {
@@ -950,8 +1509,8 @@ static uint8_t *tiny_fd_get_next_frame_to_send(tiny_fd_handle_t handle, int *len
     {
         tiny_frame_header_t *header = (tiny_frame_header_t *)data;
         header->control |= HDLC_P_BIT;
-        handle->last_marker_ts = tiny_millis();
-        handle->peers[peer].last_ka_ts = tiny_millis();
+        handle->last_marker_ts = now;
+        handle->peers[peer].last_ka_ts = now;
     }
     tiny_mutex_unlock(&handle->frames.mutex);
     return data;
@@ -959,12 +1518,12 @@ static uint8_t *tiny_fd_get_next_frame_to_send(tiny_fd_handle_t handle, int *len
 
 ///////////////////////////////////////////////////////////////////////////////
 
-static void tiny_fd_connected_check_idle_timeout(tiny_fd_handle_t handle, uint8_t peer)
+static void tiny_fd_connected_check_idle_timeout(tiny_fd_handle_t handle, uint8_t peer, uint32_t now)
 {
     tiny_mutex_lock(&handle->frames.mutex);
     // If all I-frames are sent and no respond from the remote side
     if ( __has_unconfirmed_frames(handle, peer) && __all_frames_are_sent(handle, peer) &&
-         __time_passed_since_last_i_frame(handle, peer) >= handle->retry_timeout )
+         __time_passed_since_last_i_frame(handle, peer, now) >= handle->retry_timeout )
     {
         // if sent frame was not confirmed due to noisy line
         if ( handle->peers[peer].retries > 0 )
@@ -972,8 +1531,9 @@ static void tiny_fd_connected_check_idle_timeout(tiny_fd_handle_t handle, uint8_
             LOG(TINY_LOG_WRN,
                 "[%p] Timeout, resending unconfirmed frames: last(%" PRIu32 " ms, now(%" PRIu32 " ms), timeout(%" PRIu32
                 " ms))\n",
-                handle, handle->peers[peer].last_i_ts, tiny_millis(), handle->retry_timeout);
+                handle, handle->peers[peer].last_i_ts, now, handle->retry_timeout);
             handle->peers[peer].retries--;
+            handle->stats.retry_timeouts++;
             // Do not use mutex for confirm_ns value as it is byte-value
             __resend_all_unconfirmed_frames(handle, peer, 0, handle->peers[peer].confirm_ns);
         }
@@ -983,7 +1543,7 @@ static void tiny_fd_connected_check_idle_timeout(tiny_fd_handle_t handle, uint8_
             __switch_to_disconnected_state(handle, peer);
         }
     }
-    else if ( __time_passed_since_last_frame_received(handle, peer) > handle->ka_timeout )
+    else if ( __time_passed_since_last_frame_received(handle, peer, now) > handle->ka_timeout )
     {
         if ( !handle->peers[peer].ka_confirmed )
         {
@@ -1000,34 +1560,36 @@ static void tiny_fd_connected_check_idle_timeout(tiny_fd_handle_t handle, uint8_
             handle->peers[peer].ka_confirmed = 0;
             __put_u_s_frame_to_tx_queue(handle, TINY_FD_QUEUE_S_FRAME, &frame, 2);
         }
-        handle->peers[peer].last_ka_ts = tiny_millis();
+        handle->peers[peer].last_ka_ts = now;
+    }
+    if ( handle->peers[peer].aggr_frame != NULL && __aggregated_frame_is_ready( handle, peer, now ) )
+    {
+        // Wake up tx path to send aggregated I-frame
+        tiny_events_set(&handle->events, FD_EVENT_TX_DATA_AVAILABLE);
     }
     tiny_mutex_unlock(&handle->frames.mutex);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
-static void tiny_fd_disconnected_check_idle_timeout(tiny_fd_handle_t handle, uint8_t peer)
+static void tiny_fd_disconnected_check_idle_timeout(tiny_fd_handle_t handle, uint8_t peer, uint32_t now)
 {
     tiny_mutex_lock(&handle->frames.mutex);
-    if ( __time_passed_since_last_frame_received(handle, peer) >= handle->retry_timeout )
+    if ( __time_passed_since_last_frame_received(handle, peer, now) >= handle->retry_timeout )
     {
         if ( __is_primary_station( handle ) ) // Only primary station can request connection
         {
             LOG(TINY_LOG_ERR, "[%p] Connection is not established, connecting to peer %02X [addr:%02X]\n", handle,
                    handle->next_peer, __peer_to_address_field( handle, peer ));
             // Try to establish Connection
-            tiny_frame_header_t frame = {
-                .address = __peer_to_address_field( handle, peer ) | HDLC_CR_BIT,
-                .control = (handle->mode == TINY_FD_MODE_NRM ? HDLC_U_FRAME_TYPE_SNRM : HDLC_U_FRAME_TYPE_SABM) | HDLC_U_FRAME_BITS,
-            };
-            if ( __put_u_s_frame_to_tx_queue(handle, TINY_FD_QUEUE_U_FRAME, &frame, 2) == NULL )
+            if ( __put_connect_frame_to_tx_queue(handle, TINY_FD_QUEUE_U_FRAME,
+                                                 __peer_to_address_field( handle, peer ) | HDLC_CR_BIT) == NULL )
             {
                 LOG(TINY_LOG_CRIT, "[%p] Failed to queue SNRM/SABM message for peer %02X [addr:%02X]\n", handle,
                        handle->next_peer, __peer_to_address_field( handle, peer ));
             }
             handle->peers[peer].state = TINY_FD_STATE_CONNECTING;
-            handle->peers[peer].last_ka_ts = tiny_millis();
+            handle->peers[peer].last_ka_ts = now;
         }
     }
     tiny_mutex_unlock(&handle->frames.mutex);
@@ -1035,6 +1597,62 @@ static void tiny_fd_disconnected_check_idle_timeout(tiny_fd_handle_t handle, uin
 
 ///////////////////////////////////////////////////////////////////////////////
 
+static uint32_t __get_peer_time_left(tiny_fd_handle_t handle, uint8_t peer, uint32_t now)
+{
+    uint32_t deadline = 0xFFFFFFFF;
+    uint32_t left;
+    if ( handle->peers[peer].state == TINY_FD_STATE_CONNECTED || handle->peers[peer].state == TINY_FD_STATE_DISCONNECTING )
+    {
+        if ( __has_unconfirmed_frames(handle, peer) && __all_frames_are_sent(handle, peer) )
+        {
+            left = __time_left(handle->peers[peer].last_i_ts, handle->retry_timeout, now);
+            deadline = left < deadline ? left : deadline;
+        }
+        // Keep alive timeout is checked with strict comparison
+        left = __time_left(handle->peers[peer].last_ka_ts, handle->ka_timeout + 1, now);
+        deadline = left < deadline ? left : deadline;
+        if ( handle->peers[peer].aggr_frame != NULL )
+        {
+            left = __time_left(handle->peers[peer].aggr_ts, handle->aggregation_timeout, now);
+            deadline = left < deadline ? left : deadline;
+        }
+    }
+    else if ( __is_primary_station( handle ) )
+    {
+        deadline = __time_left(handle->peers[peer].last_ka_ts, handle->retry_timeout, now);
+    }
+    return deadline;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static void __update_timers(tiny_fd_handle_t handle, uint8_t peer)
+{
+    const uint32_t now = tiny_timer_wheel_get_time(handle->timer_wheel);
+    tiny_mutex_lock(&handle->frames.mutex);
+    uint32_t left = __get_peer_time_left(handle, peer, now);
+    if ( left != 0xFFFFFFFF )
+    {
+        tiny_timer_start(handle->timer_wheel, &handle->peers[peer].timer, now + left);
+    }
+    else
+    {
+        tiny_timer_stop(handle->timer_wheel, &handle->peers[peer].timer);
+    }
+    if ( __is_primary_station( handle ) && !tiny_events_wait(&handle->events, FD_EVENT_HAS_MARKER, EVENT_BITS_LEAVE, 0) )
+    {
+        left = __time_left(handle->last_marker_ts, handle->retry_timeout, now);
+        tiny_timer_start(handle->timer_wheel, &handle->marker_timer, now + left);
+    }
+    else
+    {
+        tiny_timer_stop(handle->timer_wheel, &handle->marker_timer);
+    }
+    tiny_mutex_unlock(&handle->frames.mutex);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 int tiny_fd_get_tx_data(tiny_fd_handle_t handle, void *data, int len, uint32_t timeout)
 {
     bool repeat = true;
@@ -1056,13 +1674,15 @@ int tiny_fd_get_tx_data(tiny_fd_handle_t handle, void *data, int len, uint32_t t
                 result = TINY_ERR_UNKNOWN_PEER;
                 break;
             }
+            // Read the clock once per pass, all timer checks below use the same timestamp
+            uint32_t now = __get_time(handle);
             if ( handle->peers[peer].state == TINY_FD_STATE_CONNECTED || handle->peers[peer].state == TINY_FD_STATE_DISCONNECTING )
             {
-                tiny_fd_connected_check_idle_timeout(handle, peer);
+                tiny_fd_connected_check_idle_timeout(handle, peer, now);
             }
             else // TINY_FD_STATE_CONNECTING || TINY_FD_STATE_DISCONNECTED
             {
-                tiny_fd_disconnected_check_idle_timeout(handle, peer);
+                tiny_fd_disconnected_check_idle_timeout(handle, peer, now);
             }
             // Since no send operation is in progress, check if we have something to send
             // Check if the station has marker to send FIRST (That means, we are allowed to send anything still)
@@ -1071,7 +1691,12 @@ int tiny_fd_get_tx_data(tiny_fd_handle_t handle, void *data, int len, uint32_t t
                 if ( tiny_events_wait(&handle->events, FD_EVENT_TX_DATA_AVAILABLE, EVENT_BITS_CLEAR, timeout) || handle->mode == TINY_FD_MODE_NRM )
                 {
                     int frame_len = 0;
-                    uint8_t *frame_data = tiny_fd_get_next_frame_to_send(handle, &frame_len, peer);
+                    if ( timeout )
+                    {
+                        // The thread could wait for the events above, so refresh the timestamp
+                        now = __get_time(handle);
+                    }
+                    uint8_t *frame_data = tiny_fd_get_next_frame_to_send(handle, &frame_len, peer, now);
                     if ( frame_data != NULL )
                     {
                         // Force to check for new frame once again
@@ -1095,7 +1720,7 @@ int tiny_fd_get_tx_data(tiny_fd_handle_t handle, void *data, int len, uint32_t t
             }
             else if ( __is_primary_station( handle ) )
             {
-                if ( __time_passed_since_last_marker_seen(handle) >= handle->retry_timeout )
+                if ( __time_passed_since_last_marker_seen(handle, now) >= handle->retry_timeout )
                 {
                     // Return marker back as remote station not responding
                     LOG(TINY_LOG_CRIT, "[%p] RETURN MARKER BACK\n", handle );
@@ -1121,46 +1746,80 @@ int tiny_fd_get_tx_data(tiny_fd_handle_t handle, void *data, int len, uint32_t t
             repeat = true;
         }
     }
+    if ( handle->timer_wheel && handle->peers[peer].addr != 0xFF )
+    {
+        // Re-arm timers of the peer, as the checks above could restart or complete them
+        __update_timers(handle, peer);
+    }
     return result;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
-int tiny_fd_run_tx(tiny_fd_handle_t handle, write_block_cb_t write_func)
+int tiny_fd_run_tx_ex(tiny_fd_handle_t handle, write_block_cb_t write_func, void *user_data, void *buf, int size,
+                      uint32_t timeout)
 {
-    uint8_t buf[4];
-    int len = tiny_fd_get_tx_data(handle, buf, sizeof(buf), 1);
-    if ( len <= 0 )
+    int total = 0;
+    for ( ;; )
     {
-        return len;
-    }
-    uint8_t *ptr = buf;
-    while ( len )
-    {
-        int result = write_func(handle->user_data, ptr, len);
-        if ( result < 0 )
+        // Wait for the data only once, next blocks are taken only if they are ready
+        int len = tiny_fd_get_tx_data(handle, buf, size, timeout);
+        if ( len <= 0 )
         {
-            return result;
+            return total ? total : len;
+        }
+        timeout = 0;
+        bool would_block = false;
+        uint8_t *ptr = (uint8_t *)buf;
+        total += len;
+        while ( len )
+        {
+            int result = write_func(user_data, ptr, len);
+            if ( result < 0 )
+            {
+                return result;
+            }
+            would_block = would_block || result < len;
+            len -= result;
+            ptr += result;
+        }
+        // Stop if nothing more to send, or if the channel doesn't accept data at full speed
+        if ( would_block || (int)(ptr - (uint8_t *)buf) < size )
+        {
+            break;
         }
-        len -= result;
-        ptr += result;
     }
-    return TINY_SUCCESS;
+    return total;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
-int tiny_fd_send_packet_to(tiny_fd_handle_t handle, uint8_t address, const void *data, int len, uint32_t timeout)
+int tiny_fd_run_tx(tiny_fd_handle_t handle, write_block_cb_t write_func)
+{
+    uint8_t buf[TINY_FD_TX_BLOCK_SIZE];
+    return tiny_fd_run_tx_ex(handle, write_func, handle->user_data, buf, sizeof(buf), 1);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static uint8_t __address_to_peer(tiny_fd_handle_t handle, uint8_t address)
 {
-    int result;
-    uint8_t peer;
-    LOG(TINY_LOG_DEB, "[%p] PUT frame\n", handle);
     if ( __is_secondary_station( handle ) && address == TINY_FD_PRIMARY_ADDR )
     {
         // For secondary stations the address is actually from field
         address = handle->addr;
     }
-    peer = __address_field_to_peer( handle, (address << 2) | HDLC_E_BIT );
+    return __address_field_to_peer( handle, (address << 2) | HDLC_E_BIT );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+int tiny_fd_send_packet_to(tiny_fd_handle_t handle, uint8_t address, const void *data, int len, uint32_t timeout)
+{
+    int result;
+    uint8_t peer;
+    LOG(TINY_LOG_DEB, "[%p] PUT frame\n", handle);
+    peer = __address_to_peer( handle, address );
     if ( peer == 0xFF )
     {
         LOG(TINY_LOG_ERR, "[%p] PUT frame error: Unknown peer\n", handle);
@@ -1169,11 +1828,20 @@ int tiny_fd_send_packet_to(tiny_fd_handle_t handle, uint8_t address, const void
     // Check frame size againts mtu
     // MTU doesn't include header and crc fields, only user payload
     uint32_t start_ms = tiny_millis();
-    if ( len > tiny_fd_queue_get_mtu( &handle->frames.i_queue ) )
+    // The limit is the mtu, agreed with the remote station. Rx path updates it on reconnect
+    tiny_mutex_lock(&handle->frames.mutex);
+    int max_size = __mtu_to_packet_size( handle, peer, handle->peers[peer].mtu );
+    tiny_mutex_unlock(&handle->frames.mutex);
+    if ( len > max_size )
     {
-        LOG(TINY_LOG_ERR, "[%p] PUT frame error: data len %i is greater MTU %i\n", handle, len, handle->frames.i_queue.mtu);
+        LOG(TINY_LOG_ERR, "[%p] PUT frame error: data len %i is greater MTU %i\n", handle, len, max_size);
         result = TINY_ERR_DATA_TOO_LARGE;
     }
+    // Small messages are appended to the I-frame being aggregated, if it has enough room
+    else if ( __put_message_to_aggregated_frame(handle, peer, data, len) )
+    {
+        result = TINY_SUCCESS;
+    }
     // Wait until there is room for new frame
     else if ( tiny_events_wait(&handle->peers[peer].events, FD_EVENT_CAN_ACCEPT_I_FRAMES, EVENT_BITS_CLEAR, timeout) )
     {
@@ -1249,16 +1917,62 @@ int tiny_fd_buffer_size_by_mtu_ex(uint8_t peers_count, int mtu, int tx_window, h
     {
         peers_count = 1;
     }
-    // Alignment requirements are already satisfied by hdlc_ll_get_buf_size_ex() subfunction call
-    return sizeof(tiny_fd_data_t) + TINY_ALIGN_STRUCT_VALUE - 1 +
-           peers_count * sizeof(tiny_fd_peer_info_t) +
-           // RX side
-           hdlc_ll_get_buf_size_ex(mtu + sizeof(tiny_frame_header_t), crc_type, rx_window) +
-           // TX side
-           (sizeof(tiny_fd_frame_info_t *) + sizeof(tiny_fd_frame_info_t) + mtu -
-            sizeof(((tiny_fd_frame_info_t *)0)->payload)) *
-               tx_window +
-           (sizeof(tiny_fd_frame_info_t *) + sizeof(tiny_fd_frame_info_t)) * TINY_FD_U_QUEUE_MAX_SIZE;
+    return (int)TINY_FD_BUF_SIZE_EX(peers_count, mtu, tx_window, crc_type, rx_window);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+int tiny_fd_get_layout(const tiny_fd_init_t *init, tiny_fd_layout_t *layout)
+{
+    tiny_fd_layout_t temp;
+    return __get_layout(init, init->mtu, layout ? layout : &temp);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+uint32_t tiny_fd_get_next_deadline(tiny_fd_handle_t handle)
+{
+    if ( tiny_events_wait(&handle->events, FD_EVENT_TX_SENDING, EVENT_BITS_LEAVE, 0) )
+    {
+        return 0;
+    }
+    uint32_t deadline = 0xFFFFFFFF;
+    const uint32_t now = tiny_millis();
+    tiny_mutex_lock(&handle->frames.mutex);
+    if ( tiny_events_wait(&handle->events, FD_EVENT_HAS_MARKER, EVENT_BITS_LEAVE, 0) )
+    {
+        // In NRM mode the station with the marker always sends something to pass the marker
+        if ( handle->mode == TINY_FD_MODE_NRM ||
+             tiny_events_wait(&handle->events, FD_EVENT_TX_DATA_AVAILABLE, EVENT_BITS_LEAVE, 0) )
+        {
+            deadline = 0;
+        }
+    }
+    else if ( __is_primary_station( handle ) )
+    {
+        deadline = __time_left(handle->last_marker_ts, handle->retry_timeout, now);
+    }
+    for ( uint8_t peer = 0; peer < handle->peers_count && deadline; peer++ )
+    {
+        if ( handle->peers[peer].addr == 0xFF )
+        {
+            continue;
+        }
+        uint32_t left = __get_peer_time_left(handle, peer, now);
+        deadline = left < deadline ? left : deadline;
+    }
+    tiny_mutex_unlock(&handle->frames.mutex);
+    return deadline;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void tiny_fd_set_tx_ready_cb(tiny_fd_handle_t handle, tiny_fd_tx_ready_cb_t cb, void *arg)
+{
+    tiny_mutex_lock(&handle->frames.mutex);
+    handle->on_tx_ready_cb = cb;
+    handle->tx_ready_arg = arg;
+    tiny_mutex_unlock(&handle->frames.mutex);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -1272,7 +1986,55 @@ void tiny_fd_set_ka_timeout(tiny_fd_handle_t handle, uint32_t keep_alive)
 
 int tiny_fd_get_mtu(tiny_fd_handle_t handle)
 {
-    return tiny_fd_queue_get_mtu( &handle->frames.i_queue );
+    return __get_max_packet_size( handle );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+int tiny_fd_get_adaptive_params(tiny_fd_handle_t handle, uint8_t address, int *mtu, int *window)
+{
+    uint8_t peer = __address_to_peer( handle, address );
+    if ( peer == 0xFF )
+    {
+        return TINY_ERR_UNKNOWN_PEER;
+    }
+    tiny_mutex_lock(&handle->frames.mutex);
+    if ( mtu )
+    {
+        *mtu = __get_peer_max_packet_size( handle, peer );
+    }
+    if ( window )
+    {
+        *window = handle->adaptive ? handle->peers[peer].adapt_window : handle->peers[peer].window;
+    }
+    tiny_mutex_unlock(&handle->frames.mutex);
+    return TINY_SUCCESS;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+int tiny_fd_get_negotiated_params(tiny_fd_handle_t handle, uint8_t address, int *mtu, int *window, bool *aggregation)
+{
+    uint8_t peer = __address_to_peer( handle, address );
+    if ( peer == 0xFF )
+    {
+        return TINY_ERR_UNKNOWN_PEER;
+    }
+    tiny_mutex_lock(&handle->frames.mutex);
+    if ( mtu )
+    {
+        *mtu = __mtu_to_packet_size( handle, peer, handle->peers[peer].mtu );
+    }
+    if ( window )
+    {
+        *window = handle->peers[peer].window;
+    }
+    if ( aggregation )
+    {
+        *aggregation = handle->peers[peer].aggregation;
+    }
+    tiny_mutex_unlock(&handle->frames.mutex);
+    return TINY_SUCCESS;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -1280,18 +2042,22 @@ int tiny_fd_get_mtu(tiny_fd_handle_t handle)
 int tiny_fd_send_to(tiny_fd_handle_t handle, uint8_t address, const void *data, int len, uint32_t timeout)
 {
     const uint8_t *ptr = (const uint8_t *)data;
+    uint8_t peer = __address_to_peer( handle, address );
     int left = len;
     while ( left > 0 )
     {
-        int size = left < tiny_fd_queue_get_mtu( &handle->frames.i_queue ) ? left : tiny_fd_queue_get_mtu( &handle->frames.i_queue );
+        // In adaptive mode the payload size is selected for each chunk, since it changes with the error rate
+        int max_size = peer != 0xFF ? __get_peer_max_packet_size( handle, peer ) : __get_max_packet_size( handle );
+        int size = left < max_size ? left : max_size;
         int result = tiny_fd_send_packet_to(handle, address, ptr, size, timeout);
         if ( result != TINY_SUCCESS )
         {
             break;
         }
-        left -= result;
+        left -= size;
+        ptr += size;
     }
-    return left;
+    return len - left;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -1322,6 +2088,29 @@ int tiny_fd_get_status(tiny_fd_handle_t handle)
 
 ///////////////////////////////////////////////////////////////////////////////
 
+int tiny_fd_get_stats(tiny_fd_handle_t handle, tiny_fd_stats_t *stats)
+{
+    if ( !handle || !stats )
+    {
+        return TINY_ERR_INVALID_DATA;
+    }
+    tiny_mutex_lock(&handle->frames.mutex);
+    *stats = handle->stats;
+    tiny_mutex_unlock(&handle->frames.mutex);
+    return TINY_SUCCESS;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void tiny_fd_reset_stats(tiny_fd_handle_t handle)
+{
+    tiny_mutex_lock(&handle->frames.mutex);
+    memset(&handle->stats, 0, sizeof(handle->stats));
+    tiny_mutex_unlock(&handle->frames.mutex);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 int tiny_fd_disconnect(tiny_fd_handle_t handle)
 {
     uint8_t peer = 0; // TODO: Loop for all peers or for specific peer
@@ -1372,7 +2161,7 @@ int tiny_fd_register_peer(tiny_fd_handle_t handle, uint8_t address)
         if ( handle->peers[peer].addr == 0xFF )
         {
             handle->peers[peer].addr = address;
-            handle->peers[peer].last_ka_ts = (uint32_t)(tiny_millis() - handle->retry_timeout);
+            handle->peers[peer].last_ka_ts = (uint32_t)(__get_time(handle) - handle->retry_timeout);
             tiny_mutex_unlock(&handle->frames.mutex);
             return TINY_SUCCESS;
         }
@@ -44,7 +44,10 @@ extern "C"
 
 #include <stdint.h>
 #include "proto/crc/tiny_crc.h"
+#include "proto/hdlc/low_level/hdlc.h"
 #include "hal/tiny_types.h"
+#include "hal/tiny_timer_wheel.h"
+#include "proto/hdlc/low_level/hdlc.h"
 
     /**
      * @defgroup FULL_DUPLEX_API Tiny Full Duplex API functions
@@ -56,6 +59,115 @@ extern "C"
      */
     #define TINY_FD_PRIMARY_ADDR (0)
 
+#ifndef TINY_FD_RX_BLOCK_SIZE
+#if defined(ARDUINO) || defined(__AVR__) || defined(__XTENSA__)
+#define TINY_FD_RX_BLOCK_SIZE 4
+#else
+/**
+ * Size of stack buffer, used by tiny_fd_run_rx() to read data from the channel.
+ * Can be redefined in compilation flags.
+ */
+#define TINY_FD_RX_BLOCK_SIZE 512
+#endif
+#endif
+
+#ifndef TINY_FD_TX_BLOCK_SIZE
+#if defined(ARDUINO) || defined(__AVR__) || defined(__XTENSA__)
+#define TINY_FD_TX_BLOCK_SIZE 4
+#else
+/**
+ * Size of stack buffer, used by tiny_fd_run_tx() to pass data to the channel.
+ * Can be redefined in compilation flags.
+ */
+#define TINY_FD_TX_BLOCK_SIZE 512
+#endif
+#endif
+
+/// Maximum number of S- and U-frames, queued for sending
+#define TINY_FD_U_QUEUE_MAX_SIZE 4
+
+/// Maximum size of S- and U-frames: FRMR data or XID information field
+#define TINY_FD_U_QUEUE_MTU 6
+
+/**
+ * Size of protocol control data at the beginning of the buffer. This is upper bound
+ * for the size of the internal structure, which is checked at compile time.
+ */
+#define TINY_FD_DATA_SIZE                                                                                              \
+    (sizeof(tiny_mutex_t) + sizeof(tiny_events_t) + sizeof(tiny_timer_t) + sizeof(tiny_fd_stats_t) +                   \
+     TINY_SCALAR_SIZE * 26)
+
+/**
+ * Size of control data per peer station, upper bound checked at compile time.
+ * Peer data are mostly 32-bit fields, and only one pointer, which is counted with its alignment.
+ */
+#define TINY_FD_PEER_SIZE (sizeof(tiny_events_t) + sizeof(tiny_timer_t) + TINY_SCALAR_SIZE * 2 + sizeof(uint32_t) * 9)
+
+/// Size of frame header in tx queues, preceding the frame payload. Checked at compile time
+#define TINY_FD_FRAME_HEADER_SIZE (sizeof(int) * 2 + 2)
+
+/// Size of the frame slot in the queue for the payload of mtu bytes. Slots are kept aligned
+#define TINY_FD_QUEUE_SLOT_SIZE(mtu) TINY_ALIGN_SIZE(TINY_FD_FRAME_HEADER_SIZE + (mtu))
+
+/// Size of the queue: aligned table of frame pointers, followed by frame slots
+#define TINY_FD_QUEUE_SIZE(frames, mtu)                                                                                \
+    (TINY_ALIGN_SIZE(sizeof(void *) * (frames)) + (frames) * TINY_FD_QUEUE_SLOT_SIZE(mtu))
+
+/*
+ * Layout of the protocol data in the buffer. Every region starts at aligned address:
+ * | control data | i_queue | s_queue | peers | hdlc rx ring |
+ * i_queue is either a table of fixed mtu-sized slots or a byte ring (see tiny_fd_init_t::tx_ring_size).
+ * tiny_fd_init() places the regions using the same macros, see also tiny_fd_get_layout().
+ */
+
+/// Size of the protocol control data region
+#define TINY_FD_DATA_REGION_SIZE TINY_ALIGN_SIZE(TINY_FD_DATA_SIZE)
+
+/// Size of the byte ring state, stored in the queue buffer. Upper bound checked at compile time
+#define TINY_FD_QUEUE_RING_HEADER_SIZE (TINY_SCALAR_SIZE * 9)
+
+/// Size of the ring queue: aligned table of frame pointers, followed by the ring state and the byte ring
+#define TINY_FD_QUEUE_RING_SIZE(frames, ring_size)                                                                     \
+    (TINY_ALIGN_SIZE(sizeof(void *) * (frames)) + TINY_ALIGN_SIZE(TINY_FD_QUEUE_RING_HEADER_SIZE) +                   \
+     TINY_ALIGN_SIZE(ring_size))
+
+/// Size of I-frames queue region. tx_ring_size 0 selects fixed frame slots, see tiny_fd_init_t::tx_ring_size
+#define TINY_FD_I_QUEUE_REGION_SIZE(mtu, tx_window, tx_ring_size)                                                      \
+    ((tx_ring_size) ? TINY_FD_QUEUE_RING_SIZE(tx_window, tx_ring_size) : TINY_FD_QUEUE_SIZE(tx_window, mtu))
+
+/// Size of S- and U-frames queue region
+#define TINY_FD_S_QUEUE_REGION_SIZE TINY_FD_QUEUE_SIZE(TINY_FD_U_QUEUE_MAX_SIZE, TINY_FD_U_QUEUE_MTU)
+
+/// Size of peers region
+#define TINY_FD_PEERS_REGION_SIZE(peers_count) TINY_ALIGN_SIZE((peers_count) * TINY_FD_PEER_SIZE)
+
+/// Size of hdlc low level region with rx ring. 2 bytes of HDLC address and control fields are added to the mtu
+#define TINY_FD_RX_RING_REGION_SIZE(mtu, crc, rx_window) HDLC_LL_LAYOUT_SIZE((mtu) + 2, crc, rx_window)
+
+/// Size of all regions, when the buffer is aligned to TINY_ALIGN_STRUCT_VALUE
+#define TINY_FD_LAYOUT_SIZE_EX(peers_count, mtu, tx_window, tx_ring_size, crc, rx_window)                             \
+    (TINY_FD_DATA_REGION_SIZE + TINY_FD_I_QUEUE_REGION_SIZE(mtu, tx_window, tx_ring_size) +                            \
+     TINY_FD_S_QUEUE_REGION_SIZE + TINY_FD_PEERS_REGION_SIZE(peers_count) +                                           \
+     TINY_FD_RX_RING_REGION_SIZE(mtu, crc, rx_window))
+
+/// Size of all regions with fixed I-frame slots, when the buffer is aligned to TINY_ALIGN_STRUCT_VALUE
+#define TINY_FD_LAYOUT_SIZE(peers_count, mtu, tx_window, crc, rx_window)                                               \
+    TINY_FD_LAYOUT_SIZE_EX(peers_count, mtu, tx_window, 0, crc, rx_window)
+
+/**
+ * Buffer size required for the protocol with specified parameters, the same as
+ * tiny_fd_buffer_size_by_mtu_ex() returns. The macro can be used to allocate the buffer statically.
+ * The buffer can have any alignment, so the space for alignment is added.
+ */
+#define TINY_FD_BUF_SIZE_EX(peers_count, mtu, tx_window, crc, rx_window)                                                \
+    (TINY_FD_LAYOUT_SIZE(peers_count, mtu, tx_window, crc, rx_window) + TINY_ALIGN_STRUCT_VALUE - 1)
+
+/// Buffer size required for the protocol with single peer
+#define FD_BUF_SIZE_EX(mtu, tx_window, crc, rx_window) TINY_FD_BUF_SIZE_EX(1, mtu, tx_window, crc, rx_window)
+
+/// Buffer size required for the protocol with single peer, HDLC_CRC_16 and single frame rx window
+#define FD_MIN_BUF_SIZE(mtu, window) FD_BUF_SIZE_EX(mtu, window, HDLC_CRC_16, 1)
+
     enum
     {
         /**
@@ -86,6 +198,42 @@ extern "C"
      */
     typedef struct tiny_fd_data_t *tiny_fd_handle_t;
 
+    /**
+     * Callback, which is called when the protocol gets new data to send, so
+     * tiny_fd_get_tx_data() should be called. The callback is called from the context
+     * of the thread, which caused the event, with internal lock held, and must not call tiny_fd API.
+     * @param arg user argument passed to tiny_fd_set_tx_ready_cb()
+     */
+    typedef void (*tiny_fd_tx_ready_cb_t)(void *arg);
+
+    /**
+     * This structure describes how tiny_fd_init() places protocol data in the user buffer.
+     * All sizes are in bytes.
+     */
+    typedef struct tiny_fd_layout_t_
+    {
+        /// Size of protocol control data
+        int fd_data;
+
+        /// Size of I-frames queue (tx window or tx ring)
+        int i_queue;
+
+        /// Size of S- and U-frames queue
+        int s_queue;
+
+        /// Size of peers information
+        int peers;
+
+        /// Size of hdlc low level data including rx ring
+        int rx_ring;
+
+        /// Reserved for alignment of the user buffer
+        int padding;
+
+        /// Total size of all regions, the same as tiny_fd_buffer_size_by_mtu_ex() returns
+        int total;
+    } tiny_fd_layout_t;
+
     /**
      * This structure is used for initialization of Tiny Full Duplex protocol.
      */
@@ -106,8 +254,11 @@ extern "C"
          */
         void *buffer;
 
-        /// maximum input buffer size, see tiny_fd_buffer_size_by_mtu()
-        uint16_t buffer_size;
+        /**
+         * maximum input buffer size, see tiny_fd_buffer_size_by_mtu().
+         * The size is limited to 64 KiB unless CONFIG_TINY_LARGE_BUFFERS is enabled.
+         */
+        tiny_buf_size_t buffer_size;
 
         /**
          * timeout. Can be set to 0 during initialization. In this case timeout will be set to default.
@@ -149,6 +300,9 @@ extern "C"
 
         /**
          * Callback to get the notification when connect or disconnect event takes place.
+         * If the remote side restarts the link (SABM/SNRM is received in connected state), the callback
+         * is called twice: with false and then with true. I-frames, which are not confirmed yet, are
+         * kept in the queue and sent again to the new connection.
          * Can be NULL.
          */
         on_connect_event_cb_t on_connect_event_cb;
@@ -174,8 +328,113 @@ extern "C"
          */
         uint8_t mode;
 
+        /**
+         * Enables aggregation of small messages. If non-zero, several messages sent by
+         * tiny_fd_send_packet_to() are packed into a single I-frame (each message is prefixed with
+         * its length), and are split back before on_read_cb/on_send_cb callbacks.
+         * Both stations must enable aggregation.
+         */
+        uint8_t aggregation;
+
+        /**
+         * Maximum time in milliseconds the aggregated I-frame waits for new messages before it is sent.
+         * If zero value is specified, the frame is sent at the first opportunity, so only the messages
+         * queued while the channel is busy are aggregated. Applicable only if aggregation is enabled.
+         */
+        uint16_t aggregation_timeout;
+
+        /**
+         * Optional timer wheel to register protocol timers with. If NULL, the protocol reads
+         * tiny_millis() in rx and tx paths. If specified, the protocol takes the current time from
+         * tiny_timer_wheel_get_time() and arms per-peer wheel timers for the nearest retry, keep alive
+         * and connection request deadlines, and one timer for the marker timeout. Expired timers
+         * wake up the tx path via tiny_fd_set_tx_ready_cb() callback.
+         * The wheel is not thread safe: tiny_timer_wheel_advance(), tiny_fd_run_rx(), tiny_fd_on_rx_data(),
+         * tiny_fd_run_tx(), tiny_fd_get_tx_data(), tiny_fd_register_peer() and tiny_fd_close() of all
+         * handles, bound to the same wheel, must be called from the thread, which owns the wheel.
+         * tiny_fd_send_packet_to() can be called from any thread. If aggregation is enabled, the wheel
+         * must be advanced with tiny_millis() time.
+         */
+        tiny_timer_wheel_t *timer_wheel;
+
+        /**
+         * Size of the byte ring in bytes to store I-frames, waiting for confirmation.
+         * If zero value is specified, window_frames slots of mtu size are allocated.
+         * Otherwise each queued I-frame takes only the space required for its payload, so the
+         * number of frames in flight is limited by both window_frames and the bytes in the ring.
+         * This allows to use large mtu with a deep window of short frames on RAM limited devices.
+         * The ring must fit at least one frame of mtu size.
+         */
+        int tx_ring_size;
+
+        /**
+         * RX storage mode, see hdlc_ll_init_t::rx_compact. If non-zero, received frames are packed
+         * back to back in the rx ring, so payload pointers, passed to on_read_cb, stay valid longer
+         * for the mixed traffic. The rx ring takes the rest of the buffer after the regions, reported
+         * by tiny_fd_get_layout(), so the ring is sized in bytes by the buffer size.
+         */
+        uint8_t rx_compact;
+
+        /**
+         * Framing to use on the line. HDLC_FRAMING_HDLC (default) uses HDLC byte stuffing.
+         * HDLC_FRAMING_COBS bounds the overhead of dense binary payloads to about 0.4%.
+         * HDLC_FRAMING_RAW only prefixes frames with the length, and is intended for the transports,
+         * which never lose or corrupt bytes (TCP, Unix sockets, USB bulk). Use HDLC_CRC_OFF with it
+         * if the transport also guarantees integrity.
+         * Both stations must use the same framing.
+         */
+        hdlc_framing_t framing;
+
+        /**
+         * Enables adaptive payload size and window. If non-zero, the station tracks retransmissions and
+         * crc errors for each peer, and reduces payload size of new I-frames and the number of frames in flight,
+         * when the line is noisy, and grows them back up to mtu and window_frames, when the line is clean.
+         * The payload size is applied by tiny_fd_send() and tiny_fd_send_to(), which split user data into
+         * frames, and by aggregation. tiny_fd_send_packet_to() still sends the messages up to mtu as is.
+         * The remote side doesn't need to enable adaptive mode.
+         */
+        uint8_t adaptive;
+
+        /**
+         * Enables negotiation of connection parameters. If non-zero, SABM/SNRM and UA frames carry
+         * XID information field with mtu, window, modulus of sequence numbers and supported features
+         * (aggregation) of the station, and both stations use the largest values supported by both sides.
+         * The stations can have different mtu and window then. If the remote side doesn't support negotiation,
+         * the configured parameters are used. Both stations must have mtu of at least 6 bytes to receive
+         * XID information field. crc_type and framing are not negotiated, since they must match to exchange
+         * any frame.
+         */
+        uint8_t negotiation;
+
+        /**
+         * Number of byte errors, corrected by hdlc level in each 255-byte block of the frame, 0 disables
+         * forward error correction. Each block carries 2 * fec parity bytes, so the frames, damaged by
+         * the noise, are recovered without retransmission. The parity fields take the space in the buffer,
+         * and tiny_fd_get_layout() includes them. Both stations must use the same value.
+         * See hdlc_ll_init_t::fec.
+         */
+        uint8_t fec;
+
     } tiny_fd_init_t;
 
+    /**
+     * Protocol counters, accumulated since tiny_fd_init() or tiny_fd_reset_stats().
+     * The counters cover all peers of the station.
+     */
+    typedef struct
+    {
+        uint32_t tx_i_frames;     ///< I-frames sent, including retransmissions
+        uint32_t tx_bytes;        ///< payload bytes of sent I-frames, including retransmissions
+        uint32_t rx_i_frames;     ///< I-frames received in order and passed to the application
+        uint32_t rx_bytes;        ///< payload bytes of received in order I-frames
+        uint32_t retransmissions; ///< I-frames scheduled for sending again after REJ or retry timeout
+        uint32_t retry_timeouts;  ///< number of times, when I-frames were not confirmed in retry_timeout
+        uint32_t rej_sent;        ///< REJ frames sent to request retransmission
+        uint32_t rej_received;    ///< REJ frames received from remote side
+        uint32_t out_of_order;    ///< I-frames dropped, because they came out of order
+        uint32_t crc_errors;      ///< frames dropped by hdlc level due to wrong crc
+    } tiny_fd_stats_t;
+
     /**
      * @brief Initialized communication for Tiny Full Duplex protocol.
      *
@@ -201,6 +460,26 @@ extern "C"
      */
     extern int tiny_fd_get_status(tiny_fd_handle_t handle);
 
+    /**
+     * @brief Returns protocol counters
+     *
+     * Copies protocol counters to specified structure. The function is thread-safe, so it
+     * can be used to monitor the link from any thread.
+     *
+     * @param handle pointer to Tiny Full Duplex data
+     * @param stats pointer to the structure to fill with counters
+     * @return TINY_ERR_INVALID_DATA in case of error
+     *         TINY_SUCCESS otherwise
+     */
+    extern int tiny_fd_get_stats(tiny_fd_handle_t handle, tiny_fd_stats_t *stats);
+
+    /**
+     * @brief Resets protocol counters to zero
+     *
+     * @param handle pointer to Tiny Full Duplex data
+     */
+    extern void tiny_fd_reset_stats(tiny_fd_handle_t handle);
+
     /**
      * @brief Sends DISC command to remote side
      *
@@ -239,17 +518,36 @@ extern "C"
      * @brief sends tx data to the communication channel via user callback `write_func()`.
      *
      * Sends tx data to the communication channel via user callback `write_func()`.
-     * Internally this function generates next 4 bytes to send (or less if nothing to send),
+     * Internally this function generates next TINY_FD_TX_BLOCK_SIZE bytes to send (or less if nothing to send),
      * and calls user callback write_func() until all generated bytes are sent, or error
-     * happens. This function helps to simplify application code.
+     * happens. This is repeated until there is nothing to send or until write_func() accepts less
+     * bytes than requested, i.e. the channel would block. This function helps to simplify application code.
      *
      * @param handle handle of full-duplex protocol
      * @param write_func callback to the function to write data to the physical channel.
      *
-     * @return number of bytes sent
+     * @return number of bytes sent or negative error code
      */
     extern int tiny_fd_run_tx(tiny_fd_handle_t handle, write_block_cb_t write_func);
 
+    /**
+     * @brief sends tx data to the communication channel via user callback `write_func()` using user buffer.
+     *
+     * The same as tiny_fd_run_tx(), but uses buffer provided by the application instead of
+     * stack buffer of TINY_FD_TX_BLOCK_SIZE bytes, and passes specified user data to write_func().
+     *
+     * @param handle handle of full-duplex protocol
+     * @param write_func callback to the function to write data to the physical channel.
+     * @param user_data user data to pass to write_func()
+     * @param buf buffer to generate tx data to
+     * @param size size of the buffer
+     * @param timeout time in milliseconds to wait for the first block of data
+     *
+     * @return number of bytes sent or negative error code
+     */
+    extern int tiny_fd_run_tx_ex(tiny_fd_handle_t handle, write_block_cb_t write_func, void *user_data, void *buf,
+                                 int size, uint32_t timeout);
+
     /**
      * @brief runs rx bytes processing for specified buffer.
      *
@@ -269,18 +567,34 @@ extern "C"
      * @brief reads rx data from the communication channel via user callback `read_func()`
      *
      * Reads rx data from the communication channel via user callback `read_func()`.
-     * Internally this function has 4-byte buffer, and tries to read 4 bytes from the channel.
+     * Internally this function has TINY_FD_RX_BLOCK_SIZE buffer, and tries to read the full buffer from the channel.
      * Then received bytes are processed by the protocol. If FD protocol detects new incoming
-     * message then it calls on_send_callback.
+     * message then it calls on_read_cb. Reading is repeated while read_func() fills the whole buffer.
      * If no data available in the channel, the function returns immediately after read_func() callback
      * returns control.
      *
      * @param handle handle of full-duplex protocol
      * @param read_func callback to the function to read data from the physical channel.
-     * @return number of bytes received
+     * @return number of bytes received or negative error code
      */
     extern int tiny_fd_run_rx(tiny_fd_handle_t handle, read_block_cb_t read_func);
 
+    /**
+     * @brief reads rx data from the communication channel via user callback `read_func()` using user buffer.
+     *
+     * The same as tiny_fd_run_rx(), but uses buffer provided by the application instead of
+     * stack buffer of TINY_FD_RX_BLOCK_SIZE bytes, and passes specified user data to read_func().
+     *
+     * @param handle handle of full-duplex protocol
+     * @param read_func callback to the function to read data from the physical channel.
+     * @param user_data user data to pass to read_func()
+     * @param buf buffer to read data to
+     * @param size size of the buffer
+     * @return number of bytes received or negative error code
+     */
+    extern int tiny_fd_run_rx_ex(tiny_fd_handle_t handle, read_block_cb_t read_func, void *user_data, void *buf,
+                                 int size);
+
     /**
      * @brief Sends userdata over full-duplex protocol.
      *
@@ -332,6 +646,22 @@ extern "C"
      */
     extern int tiny_fd_buffer_size_by_mtu_ex(uint8_t peers_count, int mtu, int tx_window, hdlc_crc_t crc_type, int rx_window);
 
+    /**
+     * @brief Returns breakdown of the buffer, required for specified initialization parameters.
+     *
+     * Fills layout structure with the size of each region, which tiny_fd_init() places in the buffer.
+     * tiny_fd_init() gives the rest of the buffer, if any, to the rx ring.
+     * peers_count, mtu, window_frames, tx_ring_size, crc_type and fec fields of init structure are used.
+     * If mtu is 0, the layout describes the space required in addition to the payload.
+     * Padding is the space reserved for alignment of the buffer, it is not used if
+     * the buffer is already aligned to TINY_ALIGN_STRUCT_VALUE.
+     *
+     * @param init pointer to initialization parameters
+     * @param layout pointer to the structure to fill, can be NULL
+     * @return total buffer size in bytes
+     */
+    extern int tiny_fd_get_layout(const tiny_fd_init_t *init, tiny_fd_layout_t *layout);
+
     /**
      * @brief returns max packet size in bytes.
      *
@@ -343,6 +673,39 @@ extern "C"
      */
     extern int tiny_fd_get_mtu(tiny_fd_handle_t handle);
 
+    /**
+     * @brief Returns payload size and window, currently used for the peer.
+     *
+     * In adaptive mode the values are selected by the protocol depending on the error rate,
+     * otherwise they are the values, agreed with the remote station (see tiny_fd_init_t::negotiation),
+     * or the values, returned by tiny_fd_get_mtu() and window_frames.
+     *
+     * @param handle   tiny_fd_handle_t handle
+     * @param address  address of the remote station, TINY_FD_PRIMARY_ADDR for secondary stations
+     * @param mtu      pointer to store payload size in bytes, can be NULL
+     * @param window   pointer to store number of frames in flight, can be NULL
+     * @return TINY_SUCCESS or TINY_ERR_UNKNOWN_PEER
+     */
+    extern int tiny_fd_get_adaptive_params(tiny_fd_handle_t handle, uint8_t address, int *mtu, int *window);
+
+    /**
+     * @brief Returns connection parameters, agreed with the remote station.
+     *
+     * If negotiation is enabled (see tiny_fd_init_t::negotiation) and the remote station sent XID
+     * information field, the values are the largest common values of both stations. Otherwise they are
+     * the local values: tiny_fd_get_mtu(), window_frames and aggregation state.
+     * Unlike tiny_fd_get_adaptive_params() the values don't depend on the error rate.
+     *
+     * @param handle      tiny_fd_handle_t handle
+     * @param address     address of the remote station, TINY_FD_PRIMARY_ADDR for secondary stations
+     * @param mtu         pointer to store maximum payload size in bytes, can be NULL
+     * @param window      pointer to store window size in frames, can be NULL
+     * @param aggregation pointer to store aggregation state, can be NULL
+     * @return TINY_SUCCESS or TINY_ERR_UNKNOWN_PEER
+     */
+    extern int tiny_fd_get_negotiated_params(tiny_fd_handle_t handle, uint8_t address, int *mtu, int *window,
+                                             bool *aggregation);
+
     /**
      * @brief Sends userdata over full-duplex protocol.
      *
@@ -371,6 +734,28 @@ extern "C"
      */
     extern void tiny_fd_set_ka_timeout(tiny_fd_handle_t handle, uint32_t keep_alive);
 
+    /**
+     * Returns time in milliseconds until the next protocol timer event (retry, keep alive,
+     * connection request or marker timeout), when tiny_fd_get_tx_data() must be called.
+     * External event loops can sleep for this time instead of polling tiny_fd_get_tx_data()
+     * with short timeouts. Data queued by the application are signalled via tiny_fd_set_tx_ready_cb().
+     *
+     * @param handle   pointer to tiny_fd_handle_t
+     * @return 0 if tiny_fd_get_tx_data() has data to send right now,
+     *         0xFFFFFFFF if there are no active timers, or number of milliseconds until next deadline.
+     */
+    extern uint32_t tiny_fd_get_next_deadline(tiny_fd_handle_t handle);
+
+    /**
+     * Sets callback to be notified when tx data become available. This allows external
+     * event loops to wake up, for example by writing to eventfd, instead of polling.
+     *
+     * @param handle   pointer to tiny_fd_handle_t
+     * @param cb       callback or NULL to disable notifications
+     * @param arg      argument to pass to the callback
+     */
+    extern void tiny_fd_set_tx_ready_cb(tiny_fd_handle_t handle, tiny_fd_tx_ready_cb_t cb, void *arg);
+
     /**
      * Registers remote peer with specified address. This API can be used only in NRM mode
      * on primary station. The allowable range of the addresses is 1 - 62.
@@ -27,6 +27,7 @@
 */
 
 #include "tiny_fd_frames_int.h"
+#include "tiny_fd.h"
 #include "hal/tiny_debug.h"
 
 #include <string.h>
@@ -46,17 +47,14 @@ int tiny_fd_queue_init(tiny_fd_queue_t *queue, uint8_t *buffer,
 {
     uint8_t *ptr = buffer;
     queue->frames = (tiny_fd_frame_info_t **)(ptr);
-    ptr += sizeof(tiny_fd_frame_info_t *) * max_frames;
-    /* At this point we still have correct alignment in the buffer if init->window_frames is even.
-     * pointer is 4 bytes on ARM 32-bit, and if window_frames is even, that gives us multiply of 8.
-     */
+    /* Frame slots must be aligned, so skip padding after the table of pointers */
+    ptr += TINY_ALIGN_SIZE(sizeof(tiny_fd_frame_info_t *) * max_frames);
     queue->size = max_frames;
     /* Lets allocate memory for TX frames, we have <window_frames> TX frames */
     for ( int i = 0; i < queue->size; i++ )
     {
         queue->frames[i] = (tiny_fd_frame_info_t *)ptr;
-        /* mtu must be correctly aligned also, so the developer must use only mtu multiple of 8 on 32-bit ARM systems */
-        ptr += mtu + sizeof(tiny_fd_frame_info_t) - sizeof(((tiny_fd_frame_info_t *)0)->payload);
+        ptr += TINY_FD_QUEUE_SLOT_SIZE(mtu);
     }
     if ( ptr > buffer + max_size )
     {
@@ -64,12 +62,130 @@ int tiny_fd_queue_init(tiny_fd_queue_t *queue, uint8_t *buffer,
         return TINY_ERR_INVALID_DATA;
     }
     queue->mtu = mtu;
+    queue->ring = NULL;
     tiny_fd_queue_reset( queue );
     return (int)(ptr - buffer);
 }
 
+int tiny_fd_queue_init_ring(tiny_fd_queue_t *queue, uint8_t *buffer,
+                            int max_size, int max_frames, int mtu, int ring_size)
+{
+    uint8_t *ptr = buffer;
+    queue->frames = (tiny_fd_frame_info_t **)(ptr);
+    ptr += TINY_ALIGN_SIZE(sizeof(tiny_fd_frame_info_t *) * max_frames);
+    queue->size = max_frames;
+    /* Ring state is kept in the queue buffer, so only the queues with the ring pay for it */
+    tiny_fd_queue_ring_t *ring = (tiny_fd_queue_ring_t *)ptr;
+    ptr += TINY_ALIGN_SIZE(TINY_FD_QUEUE_RING_HEADER_SIZE);
+    uint8_t *data = ptr;
+    ptr += TINY_ALIGN_SIZE(ring_size);
+    if ( ptr > buffer + max_size )
+    {
+        LOG(TINY_LOG_CRIT, "Queue out of provided memory: provided %i bytes, used %i bytes\n", max_size, (int)(ptr - buffer));
+        return TINY_ERR_INVALID_DATA;
+    }
+    queue->ring = ring;
+    ring->data = data;
+    ring->size = (int)TINY_ALIGN_SIZE(ring_size);
+    if ( ring->size < (int)TINY_FD_QUEUE_SLOT_SIZE(mtu) )
+    {
+        LOG(TINY_LOG_CRIT, "Queue ring is too small for mtu: ring %i bytes, frame %i bytes\n", ring->size,
+            (int)TINY_FD_QUEUE_SLOT_SIZE(mtu));
+        return TINY_ERR_INVALID_DATA;
+    }
+    queue->mtu = mtu;
+    tiny_fd_queue_reset( queue );
+    return (int)(ptr - buffer);
+}
+
+/**
+ * Finds the place for the record of specified size in the ring.
+ * The records are never split, so if there is no room at the end of the ring, the record
+ * is placed at the ring start, and wrap marks the end of the records before the wrap.
+ * Returns offset of the record or -1. If commit is false, the ring state is not changed.
+ */
+static int __tiny_fd_queue_ring_reserve(tiny_fd_queue_ring_t *ring, int size, bool commit)
+{
+    int offset = -1;
+    if ( ring->head < ring->tail || ( ring->used > 0 && ring->head == ring->tail ) )
+    {
+        // The records are wrapped, the free space is between head and tail
+        if ( ring->tail - ring->head >= size )
+        {
+            offset = ring->head;
+        }
+    }
+    else if ( ring->size - ring->head >= size )
+    {
+        offset = ring->head;
+    }
+    else if ( ring->tail >= size )
+    {
+        offset = 0;
+    }
+    if ( offset >= 0 && commit )
+    {
+        if ( offset < ring->head )
+        {
+            ring->wrap = ring->head;
+        }
+        ring->head = offset + size;
+        ring->used += size;
+    }
+    return offset;
+}
+
+/**
+ * Releases the space of the oldest freed records. Since frames are confirmed in order of
+ * their sequence numbers, the records are usually released right after they are freed.
+ */
+static void __tiny_fd_queue_ring_reclaim(tiny_fd_queue_t *queue)
+{
+    tiny_fd_queue_ring_t *ring = queue->ring;
+    while ( ring->used > 0 )
+    {
+        if ( ring->tail >= ring->wrap )
+        {
+            ring->tail = 0;
+            ring->wrap = ring->size;
+        }
+        tiny_fd_frame_info_t *frame = (tiny_fd_frame_info_t *)&ring->data[ring->tail];
+        if ( frame->type != TINY_FD_QUEUE_FREE )
+        {
+            break;
+        }
+        // Table entries must not point to the released space
+        for (int i=0; i < queue->size; i++)
+        {
+            if ( queue->frames[i] == frame )
+            {
+                queue->frames[i] = &ring->free_frame;
+            }
+        }
+        int size = (int)TINY_FD_QUEUE_SLOT_SIZE(frame->len);
+        ring->tail += size;
+        ring->used -= size;
+    }
+    if ( ring->used == 0 )
+    {
+        ring->head = 0;
+        ring->tail = 0;
+        ring->wrap = ring->size;
+    }
+}
+
 void tiny_fd_queue_reset(tiny_fd_queue_t *queue)
 {
+    if ( queue->ring != NULL )
+    {
+        queue->ring->free_frame.type = TINY_FD_QUEUE_FREE;
+        for (int i=0; i < queue->size; i++)
+        {
+            queue->frames[i] = &queue->ring->free_frame;
+        }
+        queue->ring->used = 0;
+        __tiny_fd_queue_ring_reclaim( queue );
+    }
     for (int i=0; i < queue->size; i++)
     {
         queue->frames[i]->type = TINY_FD_QUEUE_FREE;
@@ -86,20 +202,85 @@ void tiny_fd_queue_reset_for(tiny_fd_queue_t *queue, uint8_t address)
             queue->frames[i]->type = TINY_FD_QUEUE_FREE;
         }
     }
+    if ( queue->ring != NULL )
+    {
+        __tiny_fd_queue_ring_reclaim( queue );
+    }
+}
+
+static tiny_fd_frame_info_t *__tiny_fd_queue_ring_allocate(tiny_fd_queue_t *queue, int len)
+{
+    for (int i=0; i < queue->size; i++)
+    {
+        if ( queue->frames[i]->type == TINY_FD_QUEUE_FREE )
+        {
+            int offset = __tiny_fd_queue_ring_reserve( queue->ring, (int)TINY_FD_QUEUE_SLOT_SIZE(len), true );
+            if ( offset < 0 )
+            {
+                break;
+            }
+            // The entry can still point to the freed record, which is not reclaimed yet.
+            // It is safe to reuse the entry, since the record keeps its own type and length.
+            queue->frames[i] = (tiny_fd_frame_info_t *)&queue->ring->data[offset];
+            return queue->frames[i];
+        }
+    }
+    return NULL;
 }
 
 tiny_fd_frame_info_t *tiny_fd_queue_allocate(tiny_fd_queue_t *queue, uint8_t type, const uint8_t *data, int len)
 {
-    tiny_fd_frame_info_t *ptr = len <= queue->mtu ?  tiny_fd_queue_get_next(queue, TINY_FD_QUEUE_FREE, 0, 0) : NULL;
+    tiny_fd_frame_info_t *ptr = NULL;
+    if ( len <= queue->mtu )
+    {
+        ptr = queue->ring != NULL ? __tiny_fd_queue_ring_allocate(queue, len)
+                                  : tiny_fd_queue_get_next(queue, TINY_FD_QUEUE_FREE, 0, 0);
+    }
     if ( ptr != NULL )
     {
-        memcpy( &ptr->payload[0], data, len );
+        if ( data != NULL )
+        {
+            memcpy( &ptr->payload[0], data, len );
+        }
         ptr->len = len;
         ptr->type = type;
     }
     return ptr;
 }
 
+bool tiny_fd_queue_resize(tiny_fd_queue_t *queue, tiny_fd_frame_info_t *frame, int len)
+{
+    if ( len > queue->mtu )
+    {
+        return false;
+    }
+    if ( queue->ring == NULL )
+    {
+        return true;
+    }
+    tiny_fd_queue_ring_t *ring = queue->ring;
+    int old_size = (int)TINY_FD_QUEUE_SLOT_SIZE(frame->len);
+    int new_size = (int)TINY_FD_QUEUE_SLOT_SIZE(len);
+    if ( new_size <= old_size )
+    {
+        return true;
+    }
+    // Only the last record can grow, and only if there is room right after it
+    if ( (uint8_t *)frame + old_size != &ring->data[ring->head] )
+    {
+        return false;
+    }
+    bool wrapped = ring->head < ring->tail || ring->head == ring->tail;
+    int limit = wrapped ? ring->tail : ring->size;
+    if ( ring->head + new_size - old_size > limit )
+    {
+        return false;
+    }
+    ring->head += new_size - old_size;
+    ring->used += new_size - old_size;
+    return true;
+}
+
 tiny_fd_frame_info_t *tiny_fd_queue_get_next(tiny_fd_queue_t *queue, uint8_t type, uint8_t address, uint8_t arg)
 {
     tiny_fd_frame_info_t *ptr = NULL;
@@ -157,6 +338,10 @@ void tiny_fd_queue_free_by_header(tiny_fd_queue_t *queue, const void *header)
             {
                 queue->lookup_index -= queue->size;
             }
+            if ( queue->ring != NULL )
+            {
+                __tiny_fd_queue_ring_reclaim( queue );
+            }
             break;
         }
     }
@@ -169,5 +354,10 @@ int tiny_fd_queue_get_mtu(tiny_fd_queue_t *queue)
 
 bool tiny_fd_queue_has_free_slots(tiny_fd_queue_t *queue)
 {
-    return tiny_fd_queue_get_next(queue, TINY_FD_QUEUE_FREE, 0, 0) != NULL;
+    bool result = tiny_fd_queue_get_next(queue, TINY_FD_QUEUE_FREE, 0, 0) != NULL;
+    if ( result && queue->ring != NULL )
+    {
+        result = __tiny_fd_queue_ring_reserve( queue->ring, (int)TINY_FD_QUEUE_SLOT_SIZE(queue->mtu), false ) >= 0;
+    }
+    return result;
 }
@@ -62,12 +62,24 @@ extern "C"
         uint8_t payload[2];       ///< this byte and all bytes after are user payload
     } tiny_fd_frame_info_t;
 
+    typedef struct
+    {
+        uint8_t *data;                   ///< ring bytes, following the ring state in the queue buffer
+        int size;                        ///< size of the byte ring
+        int head;                        ///< offset of the next record in the ring
+        int tail;                        ///< offset of the oldest record in the ring
+        int wrap;                        ///< offset, where the records end before wrapping to the ring start
+        int used;                        ///< number of bytes, occupied by the records not reclaimed yet
+        tiny_fd_frame_info_t free_frame; ///< stub record for the table entries without a frame in the ring
+    } tiny_fd_queue_ring_t;
+
     typedef struct
     {
         tiny_fd_frame_info_t **frames;  ///< pointer to the frame table
         int size;                       ///< number of elements in the table
         int lookup_index;               ///< First index to start search from
         int mtu;                        ///< Maximum supported payload size
+        tiny_fd_queue_ring_t *ring;     ///< byte ring for variable size frames, NULL if fixed slots are used
     } tiny_fd_queue_t;
 
 
@@ -84,6 +96,22 @@ extern "C"
     int tiny_fd_queue_init(tiny_fd_queue_t *queue, uint8_t *buffer,
                            int max_size, int max_frames, int mtu);
 
+    /**
+     * Initializes the queue, which stores frames in the byte ring. Each frame takes only
+     * the space required for its actual payload, so the number of queued frames is limited
+     * by max_frames and by the bytes in flight. Returns number of bytes allocated in the provided
+     * buffer. In case of error returns negative values (error codes)
+     *
+     * @param queue pointer to queue structure
+     * @param buffer buffer to store queue data
+     * @param max_size maximum size of the provided buffer
+     * @param max_frames maximum number of frames to store
+     * @param mtu maximum size of user payload
+     * @param ring_size size of the byte ring, must fit at least one frame of mtu size
+     */
+    int tiny_fd_queue_init_ring(tiny_fd_queue_t *queue, uint8_t *buffer,
+                                int max_size, int max_frames, int mtu, int ring_size);
+
     /**
      * Resets the queue to its default state, flushes all stored frames
      */
@@ -95,7 +123,8 @@ extern "C"
     void tiny_fd_queue_reset_for(tiny_fd_queue_t *queue, uint8_t address);
 
     /**
-     * Returns true if the queue has free slots
+     * Returns true if the queue has free slots.
+     * For the ring queue that means, that a frame of mtu size can be allocated.
      */
     bool tiny_fd_queue_has_free_slots(tiny_fd_queue_t *queue);
 
@@ -106,10 +135,22 @@ extern "C"
 
     /**
      * Allocates free slot in the queue and copies user data to the queue.
+     * If data is NULL, the payload is left uninitialized.
      * If there are no space returns NULL, otherwise returns pointer to allocated frame info structure.
      */
     tiny_fd_frame_info_t *tiny_fd_queue_allocate(tiny_fd_queue_t *queue, uint8_t type, const uint8_t *data, int len);
 
+    /**
+     * Checks if the frame payload can grow up to len bytes. The function doesn't change len field
+     * of the frame. For the ring queue only the last allocated frame can grow.
+     *
+     * @param queue pointer to queue structure
+     * @param frame pointer to the frame information
+     * @param len new payload size
+     * @return true if the frame has room for len bytes of payload
+     */
+    bool tiny_fd_queue_resize(tiny_fd_queue_t *queue, tiny_fd_frame_info_t *frame, int len);
+
     /**
      * Returns pointer to the next element with speciifed type and arg or NULL.
      *
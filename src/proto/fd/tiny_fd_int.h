@@ -30,37 +30,18 @@
 
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
 
-#define TINY_FD_U_QUEUE_MAX_SIZE 4
-
 #ifdef __cplusplus
 extern "C"
 {
 #endif
 
 #include <stdint.h>
+#include "tiny_fd.h"
 #include "proto/hdlc/low_level/hdlc.h"
 #include "proto/hdlc/low_level/hdlc_int.h"
 #include "hal/tiny_types.h"
 #include "tiny_fd_frames_int.h"
 
-#define FD_PEER_BUF_SIZE() ( sizeof(tiny_fd_peer_info_t) )
-
-#define FD_MIN_BUF_SIZE(mtu, window)                                                                                   \
-    (sizeof(tiny_fd_data_t) + TINY_ALIGN_STRUCT_VALUE - 1 + \
-     HDLC_MIN_BUF_SIZE(mtu + sizeof(tiny_frame_header_t), HDLC_CRC_16) +                     \
-      ( 1 * FD_PEER_BUF_SIZE() ) + \
-      (sizeof(tiny_fd_frame_info_t *) + sizeof(tiny_fd_frame_info_t) + mtu \
-                                      - sizeof(((tiny_fd_frame_info_t *)0)->payload) ) * window + \
-          ( sizeof(tiny_fd_frame_info_t) + sizeof(tiny_fd_frame_info_t *) ) * TINY_FD_U_QUEUE_MAX_SIZE )
-
-#define FD_BUF_SIZE_EX(mtu, tx_window, crc, rx_window)                                                                      \
-    (sizeof(tiny_fd_data_t) + TINY_ALIGN_STRUCT_VALUE - 1 + \
-     HDLC_BUF_SIZE_EX(mtu + sizeof(tiny_frame_header_t), crc, rx_window) +           \
-      ( 1 * FD_PEER_BUF_SIZE() ) + \
-      (sizeof(tiny_fd_frame_info_t *) + sizeof(tiny_i_frame_info_t) + mtu \
-                                      - sizeof(((tiny_fd_frame_info_t *)0)->payload)) * tx_window + \
-       ( sizeof(tiny_fd_frame_info_t) + sizeof(tiny_fd_frame_info_t *) ) * TINY_FD_U_QUEUE_MAX_SIZE)
-
     typedef enum
     {
         TINY_FD_STATE_DISCONNECTED,
@@ -89,10 +70,24 @@ extern "C"
         uint8_t confirm_ns;  // next frame to be confirmed
         uint8_t last_ns;     // next free frame in cycle buffer
 
-        uint32_t last_i_ts;  // last sent I-frame timestamp
-        uint32_t last_ka_ts; // last keep alive timestamp
         uint8_t ka_confirmed;
         uint8_t retries;     // Number of retries to perform before timeout takes place
+        uint8_t adapt_window; // maximum number of frames in flight in adaptive mode
+        uint8_t adapt_frames; // I-frames sent during current adaptation period
+        uint8_t adapt_errors; // retransmission requests and crc errors during current adaptation period
+        uint8_t adapt_ns;     // N(S) of the first I-frame, which was not transmitted yet
+        uint8_t window;       // window, agreed with the peer during connection
+        uint8_t aggregation;  // non-zero if both stations use aggregated I-frames
+
+        uint32_t last_i_ts;  // last sent I-frame timestamp
+        uint32_t last_ka_ts; // last keep alive timestamp
+        uint32_t aggr_ts;    // timestamp of the first message in aggr_frame
+        int mtu;             // payload size, agreed with the peer during connection
+        int adapt_mtu;       // payload size of new I-frames in adaptive mode
+
+        tiny_fd_frame_info_t *aggr_frame; // I-frame still accepting aggregated messages
+
+        tiny_timer_t timer;  // retry, keep alive and connection request timer, if timer wheel is used
 
         tiny_events_t events;
 
@@ -117,6 +112,10 @@ extern "C"
         on_frame_send_cb_t on_send_cb;
         /// Callback to get connect/disconnect notification
         on_connect_event_cb_t on_connect_event_cb;
+        /// Callback to notify external event loop about tx data
+        tiny_fd_tx_ready_cb_t on_tx_ready_cb;
+        /// Argument for on_tx_ready_cb
+        void *tx_ready_arg;
         /// hdlc information
         hdlc_ll_handle_t _hdlc;
         /// Timeout for operations with acknowledge
@@ -139,10 +138,26 @@ extern "C"
         uint8_t next_peer;
         /// Last marker timestamp
         uint32_t last_marker_ts;
+        /// Optional timer wheel for protocol timers
+        tiny_timer_wheel_t *timer_wheel;
+        /// Marker timeout timer, if timer wheel is used
+        tiny_timer_t marker_timer;
         /// HDLC mode;
         uint8_t mode;
+        /// Non-zero if small messages aggregation is enabled
+        uint8_t aggregation;
+        /// Maximum time the aggregated I-frame waits for new messages
+        uint16_t aggregation_timeout;
+        /// Non-zero if adaptive payload size and window are enabled
+        uint8_t adaptive;
+        /// Number of frames in window, configured by the application
+        uint8_t window;
+        /// Non-zero if connection parameters are negotiated with XID information field
+        uint8_t negotiation;
         /// Global events for HDLC protocol
         tiny_events_t events;
+        /// Protocol counters, protected by frames.mutex
+        tiny_fd_stats_t stats;
         /// user specific data
         void *user_data;
     } tiny_fd_data_t;
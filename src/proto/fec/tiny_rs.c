@@ -0,0 +1,322 @@
+/*
+    Copyright 2022 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    GNU General Public License Usage
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Commercial License Usage
+
+    Licensees holding valid commercial Tiny Protocol licenses may use this file in
+    accordance with the commercial license agreement provided in accordance with
+    the terms contained in a written agreement between you and Alexey Dynda.
+    For further information contact via email on github account.
+*/
+
+/*
+ * Reed-Solomon codec is based on the well known decoder by Phil Karn: syndromes are
+ * calculated for the received codeword, Berlekamp-Massey algorithm finds error locator polynomial,
+ * Chien search finds error locations and Forney algorithm calculates error values.
+ * All multiplications are performed via log and antilog tables.
+ */
+
+#include "tiny_rs.h"
+
+#include <string.h>
+
+#ifdef CONFIG_ENABLE_FEC
+
+/* Index form of zero */
+#define A0 255
+#define NN 255
+
+/* alpha^i, the last entry is the value for A0 */
+static const uint8_t gf_exp[256] = {
+    0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1D, 0x3A, 0x74, 0xE8, 0xCD, 0x87, 0x13, 0x26,
+    0x4C, 0x98, 0x2D, 0x5A, 0xB4, 0x75, 0xEA, 0xC9, 0x8F, 0x03, 0x06, 0x0C, 0x18, 0x30, 0x60, 0xC0,
+    0x9D, 0x27, 0x4E, 0x9C, 0x25, 0x4A, 0x94, 0x35, 0x6A, 0xD4, 0xB5, 0x77, 0xEE, 0xC1, 0x9F, 0x23,
+    0x46, 0x8C, 0x05, 0x0A, 0x14, 0x28, 0x50, 0xA0, 0x5D, 0xBA, 0x69, 0xD2, 0xB9, 0x6F, 0xDE, 0xA1,
+    0x5F, 0xBE, 0x61, 0xC2, 0x99, 0x2F, 0x5E, 0xBC, 0x65, 0xCA, 0x89, 0x0F, 0x1E, 0x3C, 0x78, 0xF0,
+    0xFD, 0xE7, 0xD3, 0xBB, 0x6B, 0xD6, 0xB1, 0x7F, 0xFE, 0xE1, 0xDF, 0xA3, 0x5B, 0xB6, 0x71, 0xE2,
+    0xD9, 0xAF, 0x43, 0x86, 0x11, 0x22, 0x44, 0x88, 0x0D, 0x1A, 0x34, 0x68, 0xD0, 0xBD, 0x67, 0xCE,
+    0x81, 0x1F, 0x3E, 0x7C, 0xF8, 0xED, 0xC7, 0x93, 0x3B, 0x76, 0xEC, 0xC5, 0x97, 0x33, 0x66, 0xCC,
+    0x85, 0x17, 0x2E, 0x5C, 0xB8, 0x6D, 0xDA, 0xA9, 0x4F, 0x9E, 0x21, 0x42, 0x84, 0x15, 0x2A, 0x54,
+    0xA8, 0x4D, 0x9A, 0x29, 0x52, 0xA4, 0x55, 0xAA, 0x49, 0x92, 0x39, 0x72, 0xE4, 0xD5, 0xB7, 0x73,
+    0xE6, 0xD1, 0xBF, 0x63, 0xC6, 0x91, 0x3F, 0x7E, 0xFC, 0xE5, 0xD7, 0xB3, 0x7B, 0xF6, 0xF1, 0xFF,
+    0xE3, 0xDB, 0xAB, 0x4B, 0x96, 0x31, 0x62, 0xC4, 0x95, 0x37, 0x6E, 0xDC, 0xA5, 0x57, 0xAE, 0x41,
+    0x82, 0x19, 0x32, 0x64, 0xC8, 0x8D, 0x07, 0x0E, 0x1C, 0x38, 0x70, 0xE0, 0xDD, 0xA7, 0x53, 0xA6,
+    0x51, 0xA2, 0x59, 0xB2, 0x79, 0xF2, 0xF9, 0xEF, 0xC3, 0x9B, 0x2B, 0x56, 0xAC, 0x45, 0x8A, 0x09,
+    0x12, 0x24, 0x48, 0x90, 0x3D, 0x7A, 0xF4, 0xF5, 0xF7, 0xF3, 0xFB, 0xEB, 0xCB, 0x8B, 0x0B, 0x16,
+    0x2C, 0x58, 0xB0, 0x7D, 0xFA, 0xE9, 0xCF, 0x83, 0x1B, 0x36, 0x6C, 0xD8, 0xAD, 0x47, 0x8E, 0x00
+};
+
+/* log(x), log(0) is A0 */
+static const uint8_t gf_log[256] = {
+    0xFF, 0x00, 0x01, 0x19, 0x02, 0x32, 0x1A, 0xC6, 0x03, 0xDF, 0x33, 0xEE, 0x1B, 0x68, 0xC7, 0x4B,
+    0x04, 0x64, 0xE0, 0x0E, 0x34, 0x8D, 0xEF, 0x81, 0x1C, 0xC1, 0x69, 0xF8, 0xC8, 0x08, 0x4C, 0x71,
+    0x05, 0x8A, 0x65, 0x2F, 0xE1, 0x24, 0x0F, 0x21, 0x35, 0x93, 0x8E, 0xDA, 0xF0, 0x12, 0x82, 0x45,
+    0x1D, 0xB5, 0xC2, 0x7D, 0x6A, 0x27, 0xF9, 0xB9, 0xC9, 0x9A, 0x09, 0x78, 0x4D, 0xE4, 0x72, 0xA6,
+    0x06, 0xBF, 0x8B, 0x62, 0x66, 0xDD, 0x30, 0xFD, 0xE2, 0x98, 0x25, 0xB3, 0x10, 0x91, 0x22, 0x88,
+    0x36, 0xD0, 0x94, 0xCE, 0x8F, 0x96, 0xDB, 0xBD, 0xF1, 0xD2, 0x13, 0x5C, 0x83, 0x38, 0x46, 0x40,
+    0x1E, 0x42, 0xB6, 0xA3, 0xC3, 0x48, 0x7E, 0x6E, 0x6B, 0x3A, 0x28, 0x54, 0xFA, 0x85, 0xBA, 0x3D,
+    0xCA, 0x5E, 0x9B, 0x9F, 0x0A, 0x15, 0x79, 0x2B, 0x4E, 0xD4, 0xE5, 0xAC, 0x73, 0xF3, 0xA7, 0x57,
+    0x07, 0x70, 0xC0, 0xF7, 0x8C, 0x80, 0x63, 0x0D, 0x67, 0x4A, 0xDE, 0xED, 0x31, 0xC5, 0xFE, 0x18,
+    0xE3, 0xA5, 0x99, 0x77, 0x26, 0xB8, 0xB4, 0x7C, 0x11, 0x44, 0x92, 0xD9, 0x23, 0x20, 0x89, 0x2E,
+    0x37, 0x3F, 0xD1, 0x5B, 0x95, 0xBC, 0xCF, 0xCD, 0x90, 0x87, 0x97, 0xB2, 0xDC, 0xFC, 0xBE, 0x61,
+    0xF2, 0x56, 0xD3, 0xAB, 0x14, 0x2A, 0x5D, 0x9E, 0x84, 0x3C, 0x39, 0x53, 0x47, 0x6D, 0x41, 0xA2,
+    0x1F, 0x2D, 0x43, 0xD8, 0xB7, 0x7B, 0xA4, 0x76, 0xC4, 0x17, 0x49, 0xEC, 0x7F, 0x0C, 0x6F, 0xF6,
+    0x6C, 0xA1, 0x3B, 0x52, 0x29, 0x9D, 0x55, 0xAA, 0xFB, 0x60, 0x86, 0xB1, 0xBB, 0xCC, 0x3E, 0x5A,
+    0xCB, 0x59, 0x5F, 0xB0, 0x9C, 0xA9, 0xA0, 0x51, 0x0B, 0xF5, 0x16, 0xEB, 0x7A, 0x75, 0x2C, 0xD7,
+    0x4F, 0xAE, 0xD5, 0xE9, 0xE6, 0xE7, 0xAD, 0xE8, 0x74, 0xD6, 0xF4, 0xEA, 0xA8, 0x50, 0x58, 0xAF
+};
+
+static inline int modnn(int x)
+{
+    while ( x >= NN )
+    {
+        x -= NN;
+        x = (x >> 8) + (x & NN);
+    }
+    return x;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+int tiny_rs_init(tiny_rs_t *rs, int nroots)
+{
+    if ( nroots < 2 || nroots > TINY_RS_MAX_ROOTS )
+    {
+        return TINY_ERR_INVALID_DATA;
+    }
+    rs->nroots = (uint8_t)nroots;
+    // Roots of generator polynomial are alpha^0 ... alpha^(nroots-1)
+    rs->genpoly[0] = 1;
+    for ( int i = 0; i < nroots; i++ )
+    {
+        rs->genpoly[i + 1] = 1;
+        for ( int j = i; j > 0; j-- )
+        {
+            rs->genpoly[j] = rs->genpoly[j] != 0 ? rs->genpoly[j - 1] ^ gf_exp[modnn(gf_log[rs->genpoly[j]] + i)]
+                                                 : rs->genpoly[j - 1];
+        }
+        rs->genpoly[0] = gf_exp[modnn(gf_log[rs->genpoly[0]] + i)];
+    }
+    for ( int i = 0; i <= nroots; i++ )
+    {
+        rs->genpoly[i] = gf_log[rs->genpoly[i]];
+    }
+    return TINY_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void tiny_rs_encode_byte(const tiny_rs_t *rs, uint8_t *parity, uint8_t data)
+{
+    const int nroots = rs->nroots;
+    uint8_t feedback = gf_log[data ^ parity[0]];
+    if ( feedback != A0 )
+    {
+        for ( int j = 1; j < nroots; j++ )
+        {
+            parity[j] ^= gf_exp[modnn(feedback + rs->genpoly[nroots - j])];
+        }
+    }
+    memmove(&parity[0], &parity[1], nroots - 1);
+    parity[nroots - 1] = feedback != A0 ? gf_exp[modnn(feedback + rs->genpoly[0])] : 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+int tiny_rs_decode(const tiny_rs_t *rs, uint8_t *data, int len, int stride, uint8_t *parity)
+{
+    const int nroots = rs->nroots;
+    const int pad = NN - nroots - len;
+    uint8_t s[TINY_RS_MAX_ROOTS];
+    uint8_t lambda[TINY_RS_MAX_ROOTS + 1];
+    uint8_t b[TINY_RS_MAX_ROOTS + 1];
+    uint8_t t[TINY_RS_MAX_ROOTS + 1];
+    uint8_t omega[TINY_RS_MAX_ROOTS + 1];
+    uint8_t reg[TINY_RS_MAX_ROOTS + 1];
+    uint8_t root[TINY_RS_MAX_ROOTS];
+    uint8_t loc[TINY_RS_MAX_ROOTS];
+    if ( pad < 0 )
+    {
+        return TINY_ERR_INVALID_DATA;
+    }
+    // Syndromes are evaluated at the roots of generator polynomial
+    memset(s, 0, nroots);
+    for ( int j = 0; j < len + nroots; j++ )
+    {
+        uint8_t byte = j < len ? data[j * stride] : parity[j - len];
+        for ( int i = 0; i < nroots; i++ )
+        {
+            s[i] = s[i] == 0 ? byte : byte ^ gf_exp[modnn(gf_log[s[i]] + i)];
+        }
+    }
+    uint8_t syn_error = 0;
+    for ( int i = 0; i < nroots; i++ )
+    {
+        syn_error |= s[i];
+        s[i] = gf_log[s[i]];
+    }
+    if ( !syn_error )
+    {
+        return 0;
+    }
+    // Berlekamp-Massey algorithm
+    memset(&lambda[1], 0, nroots);
+    lambda[0] = 1;
+    for ( int i = 0; i <= nroots; i++ )
+    {
+        b[i] = gf_log[lambda[i]];
+    }
+    int el = 0;
+    for ( int r = 1; r <= nroots; r++ )
+    {
+        uint8_t discr_r = 0;
+        for ( int i = 0; i < r; i++ )
+        {
+            if ( lambda[i] != 0 && s[r - i - 1] != A0 )
+            {
+                discr_r ^= gf_exp[modnn(gf_log[lambda[i]] + s[r - i - 1])];
+            }
+        }
+        discr_r = gf_log[discr_r];
+        if ( discr_r == A0 )
+        {
+            memmove(&b[1], b, nroots);
+            b[0] = A0;
+            continue;
+        }
+        t[0] = lambda[0];
+        for ( int i = 0; i < nroots; i++ )
+        {
+            t[i + 1] = b[i] != A0 ? lambda[i + 1] ^ gf_exp[modnn(discr_r + b[i])] : lambda[i + 1];
+        }
+        if ( 2 * el <= r - 1 )
+        {
+            el = r - el;
+            for ( int i = 0; i <= nroots; i++ )
+            {
+                b[i] = lambda[i] == 0 ? A0 : (uint8_t)modnn(gf_log[lambda[i]] - discr_r + NN);
+            }
+        }
+        else
+        {
+            memmove(&b[1], b, nroots);
+            b[0] = A0;
+        }
+        memcpy(lambda, t, nroots + 1);
+    }
+    int deg_lambda = 0;
+    for ( int i = 0; i <= nroots; i++ )
+    {
+        lambda[i] = gf_log[lambda[i]];
+        if ( lambda[i] != A0 )
+        {
+            deg_lambda = i;
+        }
+    }
+    // Chien search for the roots of error locator polynomial
+    memcpy(&reg[1], &lambda[1], nroots);
+    int count = 0;
+    for ( int i = 1, k = 0; i <= NN; i++, k = modnn(k + 1) )
+    {
+        uint8_t q = 1;
+        for ( int j = deg_lambda; j > 0; j-- )
+        {
+            if ( reg[j] != A0 )
+            {
+                reg[j] = (uint8_t)modnn(reg[j] + j);
+                q ^= gf_exp[reg[j]];
+            }
+        }
+        if ( q != 0 )
+        {
+            continue;
+        }
+        root[count] = (uint8_t)i;
+        loc[count] = (uint8_t)k;
+        if ( ++count == deg_lambda )
+        {
+            break;
+        }
+    }
+    if ( deg_lambda != count )
+    {
+        // Number of roots doesn't match degree of the polynomial, too many errors
+        return TINY_ERR_FAILED;
+    }
+    // Error evaluator polynomial omega(x) = s(x) * lambda(x) mod x^nroots
+    int deg_omega = deg_lambda - 1;
+    for ( int i = 0; i <= deg_omega; i++ )
+    {
+        uint8_t tmp = 0;
+        for ( int j = i; j >= 0; j-- )
+        {
+            if ( s[i - j] != A0 && lambda[j] != A0 )
+            {
+                tmp ^= gf_exp[modnn(s[i - j] + lambda[j])];
+            }
+        }
+        omega[i] = gf_log[tmp];
+    }
+    for ( int j = 0; j < count; j++ )
+    {
+        // Errors in the padding of shortened codeword mean that the codeword is not correctable
+        if ( loc[j] < pad )
+        {
+            return TINY_ERR_FAILED;
+        }
+    }
+    // Forney algorithm: error value = omega(1/X) / lambda'(1/X)
+    for ( int j = count - 1; j >= 0; j-- )
+    {
+        uint8_t num1 = 0;
+        for ( int i = deg_omega; i >= 0; i-- )
+        {
+            if ( omega[i] != A0 )
+            {
+                num1 ^= gf_exp[modnn(omega[i] + i * root[j])];
+            }
+        }
+        uint8_t num2 = gf_exp[modnn(NN - root[j])];
+        uint8_t den = 0;
+        for ( int i = (deg_lambda < nroots - 1 ? deg_lambda : nroots - 1) & ~1; i >= 0; i -= 2 )
+        {
+            if ( lambda[i + 1] != A0 )
+            {
+                den ^= gf_exp[modnn(lambda[i + 1] + i * root[j])];
+            }
+        }
+        if ( num1 != 0 && den != 0 )
+        {
+            uint8_t value = gf_exp[modnn(gf_log[num1] + gf_log[num2] + NN - gf_log[den])];
+            int pos = loc[j] - pad;
+            if ( pos < len )
+            {
+                data[pos * stride] ^= value;
+            }
+            else
+            {
+                parity[pos - len] ^= value;
+            }
+        }
+    }
+    return count;
+}
+
+#endif
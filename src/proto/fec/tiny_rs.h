@@ -0,0 +1,94 @@
+/*
+    Copyright 2022 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    GNU General Public License Usage
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Commercial License Usage
+
+    Licensees holding valid commercial Tiny Protocol licenses may use this file in
+    accordance with the commercial license agreement provided in accordance with
+    the terms contained in a written agreement between you and Alexey Dynda.
+    For further information contact via email on github account.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include "hal/tiny_types.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#ifdef CONFIG_ENABLE_FEC
+
+/** Maximum number of parity bytes in Reed-Solomon codeword, RS(255,223) */
+#define TINY_RS_MAX_ROOTS 32
+
+/** Size of Reed-Solomon codeword in bytes, including parity bytes */
+#define TINY_RS_BLOCK_SIZE 255
+
+    /**
+     * Reed-Solomon codec over GF(256) with primitive polynomial 0x11D. The codeword can be shortened,
+     * that is contain less than 255 - nroots data bytes. The codec corrects up to nroots / 2 byte errors.
+     */
+    typedef struct
+    {
+        uint8_t nroots;                           ///< number of parity bytes
+        uint8_t genpoly[TINY_RS_MAX_ROOTS + 1];   ///< generator polynomial in index form
+    } tiny_rs_t;
+
+    /**
+     * Initializes codec for the specified number of parity bytes
+     *
+     * @param rs pointer to codec structure
+     * @param nroots number of parity bytes, from 2 to TINY_RS_MAX_ROOTS
+     * @return TINY_SUCCESS or TINY_ERR_INVALID_DATA
+     */
+    int tiny_rs_init(tiny_rs_t *rs, int nroots);
+
+    /**
+     * Adds next data byte of the codeword to parity bytes. Parity bytes must be zeroed before
+     * the first byte of the codeword. This allows to calculate parity for the codeword, which
+     * data bytes are not located in continuous memory block.
+     *
+     * @param rs pointer to initialized codec structure
+     * @param parity pointer to nroots parity bytes
+     * @param data next data byte
+     */
+    void tiny_rs_encode_byte(const tiny_rs_t *rs, uint8_t *parity, uint8_t data);
+
+    /**
+     * Corrects errors in the codeword.
+     *
+     * @param rs pointer to initialized codec structure
+     * @param data pointer to the first data byte of the codeword
+     * @param len number of data bytes, up to 255 - nroots
+     * @param stride distance between data bytes of the codeword in memory, 1 for continuous block.
+     *        Interleaved codewords have stride equal to the number of codewords.
+     * @param parity pointer to nroots parity bytes of the codeword
+     * @return number of corrected bytes or TINY_ERR_FAILED if there are too many errors
+     */
+    int tiny_rs_decode(const tiny_rs_t *rs, uint8_t *data, int len, int stride, uint8_t *parity);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -130,11 +130,12 @@ int hdlc_run_tx(hdlc_handle_t handle)
     int result = 0;
     for ( ;; )
     {
-        uint8_t buf[1];
+        uint8_t buf[HDLC_TX_BLOCK_SIZE];
         int temp_result = hdlc_ll_run_tx(handle->handle, buf, sizeof(buf));
+        uint8_t *ptr = buf;
         while ( temp_result > 0 )
         {
-            int temp = handle->send_tx(handle->user_data, buf, temp_result);
+            int temp = handle->send_tx(handle->user_data, ptr, temp_result);
             if ( temp < 0 )
             {
                 temp_result = temp;
@@ -142,6 +143,7 @@ int hdlc_run_tx(hdlc_handle_t handle)
             }
             temp_result -= temp;
             result += temp;
+            ptr += temp;
         }
         if ( temp_result <= 0 )
         {
@@ -173,17 +175,19 @@ static int hdlc_run_tx_until_sent(hdlc_handle_t handle, uint32_t timeout)
     int result = 0;
     for ( ;; )
     {
-        uint8_t buf[1];
+        uint8_t buf[HDLC_TX_BLOCK_SIZE];
         result = hdlc_ll_run_tx(handle->handle, buf, sizeof(buf));
+        uint8_t *ptr = buf;
         while ( result > 0 )
         {
-            int temp = handle->send_tx(handle->user_data, buf, result);
+            int temp = handle->send_tx(handle->user_data, ptr, result);
             if ( temp < 0 )
             {
                 result = temp;
                 break;
             }
             result -= temp;
+            ptr += temp;
         }
 
         if ( result < 0 )
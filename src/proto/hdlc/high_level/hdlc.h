@@ -33,6 +33,18 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#ifndef HDLC_TX_BLOCK_SIZE
+#if defined(ARDUINO) || defined(__AVR__) || defined(__XTENSA__)
+#define HDLC_TX_BLOCK_SIZE 4
+#else
+/**
+ * Size of stack buffer, used by hdlc_run_tx() and hdlc_send() to pass data to send_tx() callback.
+ * Can be redefined in compilation flags.
+ */
+#define HDLC_TX_BLOCK_SIZE 256
+#endif
+#endif
+
 #ifdef __cplusplus
 extern "C"
 {
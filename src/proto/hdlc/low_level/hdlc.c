@@ -29,9 +29,11 @@
 #include "hdlc.h"
 #include "hdlc_int.h"
 #include "proto/crc/tiny_crc.h"
+#include "proto/fec/tiny_rs.h"
 #include "hal/tiny_debug.h"
 
 #include <stddef.h>
+#include <string.h>
 
 #ifndef TINY_HDLC_DEBUG
 #define TINY_HDLC_DEBUG 0
@@ -48,6 +50,16 @@
 #define TINY_ESCAPE_CHAR 0x7D
 #define TINY_ESCAPE_BIT 0x20
 
+// HDLC_LL_DATA_SIZE is defined in the public header without access to hdlc_ll_data_t, so check it here
+typedef char hdlc_ll_data_size_check_t[(HDLC_LL_DATA_SIZE >= sizeof(hdlc_ll_data_t)) ? 1 : -1];
+
+/*
+ * RX side keeps crc register for the payload and crc field together. Since crc field is sent
+ * as is, the register for correct frames always ends with the same residue value.
+ * Checksum field is complement of the payload sum, so the low byte of the sum is all ones.
+ */
+#define RX_RESIDUE_CHECKSUM 0xFF
+
 enum
 {
     TX_ACCEPT_BIT = 0x01,
@@ -58,11 +70,15 @@ enum
 
 static int hdlc_ll_read_start(hdlc_ll_handle_t handle, const uint8_t *data, int len);
 static int hdlc_ll_read_data(hdlc_ll_handle_t handle, const uint8_t *data, int len);
-static int hdlc_ll_read_end(hdlc_ll_handle_t handle, const uint8_t *data, int len);
+static int hdlc_ll_rx_frame_end(hdlc_ll_handle_t handle);
+static void hdlc_ll_rx_crc_update(hdlc_ll_handle_t handle, const uint8_t *data, int len);
+#ifdef CONFIG_ENABLE_FEC
+static int hdlc_ll_rx_fec_decode(hdlc_ll_handle_t handle, int len);
+static void hdlc_ll_tx_fec_encode(hdlc_ll_handle_t handle);
+#endif
 
 static int hdlc_ll_send_start(hdlc_ll_handle_t handle);
 static int hdlc_ll_send_data(hdlc_ll_handle_t handle);
-static int hdlc_ll_send_tx_internal(hdlc_ll_handle_t handle, const void *data, int len);
 static int hdlc_ll_send_crc(hdlc_ll_handle_t handle);
 static int hdlc_ll_send_end(hdlc_ll_handle_t handle);
 
@@ -80,15 +96,41 @@ int hdlc_ll_init(hdlc_ll_handle_t *handle, hdlc_ll_init_t *init)
             (int)(sizeof(hdlc_ll_data_t) + TINY_ALIGN_STRUCT_VALUE - 1));
         return TINY_ERR_OUT_OF_MEMORY;
     }
+    const int crc_size = init->crc_type == HDLC_CRC_OFF ? 0 : HDLC_CRC_FIELD_SIZE(init->crc_type);
+    // Parity of the frame being sent takes the space before rx buffer, and must fit the frame of mtu size
+    const int parity_size = HDLC_LL_FEC_PARITY_SIZE(init->mtu + crc_size, init->fec);
+    if ( init->fec )
+    {
+#ifdef CONFIG_ENABLE_FEC
+        if ( !init->mtu || init->fec > HDLC_LL_FEC_MAX )
+        {
+            LOG(TINY_LOG_ERR, "[HDLC] FEC requires mtu, fec=%i (max %i)\n", init->fec, HDLC_LL_FEC_MAX);
+            return TINY_ERR_INVALID_DATA;
+        }
+        if ( buf_size < (int)sizeof(hdlc_ll_data_t) + parity_size )
+        {
+            LOG(TINY_LOG_ERR, "[HDLC] failed to init hdlc. No space for FEC parity, size=%i\n", init->buf_size);
+            return TINY_ERR_OUT_OF_MEMORY;
+        }
+#else
+        LOG(TINY_LOG_ERR, "[HDLC] FEC is not enabled in the library configuration%s", "\n");
+        return TINY_ERR_INVALID_DATA;
+#endif
+    }
     *handle = (hdlc_ll_handle_t)buf;
-    (*handle)->rx_buf = (uint8_t *)buf + sizeof(hdlc_ll_data_t);
-    (*handle)->rx_buf_size = buf_size - sizeof(hdlc_ll_data_t);
+    (*handle)->rx_buf = (uint8_t *)buf + sizeof(hdlc_ll_data_t) + parity_size;
+    (*handle)->rx_buf_size = buf_size - sizeof(hdlc_ll_data_t) - parity_size;
     (*handle)->crc_type = init->crc_type == HDLC_CRC_OFF ? 0 : init->crc_type;
     (*handle)->on_frame_read = init->on_frame_read;
     (*handle)->on_frame_send = init->on_frame_send;
     (*handle)->user_data = init->user_data;
-    (*handle)->phys_mtu = init->mtu ? (init->mtu + get_crc_field_size((*handle)->crc_type)): ((*handle)->rx_buf_size);
+    (*handle)->on_frame_filter = init->on_frame_filter;
+    (*handle)->framing = init->framing;
+    (*handle)->fec = init->fec;
+    (*handle)->phys_mtu = init->mtu ? (init->mtu + get_crc_field_size((*handle)->crc_type) + parity_size)
+                                    : ((*handle)->rx_buf_size);
     (*handle)->rx.frame_buf = (*handle)->rx_buf;
+    (*handle)->rx.compact = init->rx_compact;
 
     // Must be last
     hdlc_ll_reset(*handle, HDLC_LL_RESET_BOTH);
@@ -116,14 +158,45 @@ void hdlc_ll_reset(hdlc_ll_handle_t handle, uint8_t flags)
 {
     if ( flags != HDLC_LL_RESET_TX_ONLY )
     {
-        handle->rx.state = hdlc_ll_read_start;
+        hdlc_ll_rx_restart(handle);
     }
     if ( flags != HDLC_LL_RESET_RX_ONLY )
     {
         handle->tx.data = NULL;
         handle->tx.origin_data = NULL;
         handle->tx.escape = 0;
-        handle->tx.state = hdlc_ll_send_start;
+        hdlc_ll_tx_restart(handle);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void hdlc_ll_rx_restart(hdlc_ll_handle_t handle)
+{
+    switch ( handle->framing )
+    {
+        // COBS has no opening flag, every byte after the delimiter belongs to the next frame
+        case HDLC_FRAMING_COBS:
+            hdlc_ll_rx_frame_init(handle);
+            handle->rx.state = hdlc_cobs_read_data;
+            break;
+        case HDLC_FRAMING_RAW:
+            hdlc_ll_rx_frame_init(handle);
+            handle->rx.state = hdlc_raw_read_length;
+            break;
+        default: handle->rx.state = hdlc_ll_read_start; break;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void hdlc_ll_tx_restart(hdlc_ll_handle_t handle)
+{
+    switch ( handle->framing )
+    {
+        case HDLC_FRAMING_COBS: handle->tx.state = hdlc_cobs_send_start; break;
+        case HDLC_FRAMING_RAW: handle->tx.state = hdlc_raw_send_start; break;
+        default: handle->tx.state = hdlc_ll_send_start; break;
     }
 }
 
@@ -138,19 +211,7 @@ static int hdlc_ll_send_start(hdlc_ll_handle_t handle)
         return 0;
     }
     LOG(TINY_LOG_INFO, "[HDLC:%p] Starting send op for HDLC frame\n", handle);
-    switch ( handle->crc_type )
-    {
-#ifdef CONFIG_ENABLE_FCS16
-        case HDLC_CRC_16: handle->tx.crc = tiny_crc16(PPPINITFCS16, handle->tx.data, handle->tx.len); break;
-#endif
-#ifdef CONFIG_ENABLE_FCS32
-        case HDLC_CRC_32: handle->tx.crc = tiny_crc32(PPPINITFCS32, handle->tx.data, handle->tx.len); break;
-#endif
-#ifdef CONFIG_ENABLE_CHECKSUM
-        case HDLC_CRC_8: handle->tx.crc = tiny_chksum(INITCHECKSUM, handle->tx.data, handle->tx.len); break;
-#endif
-        default: break;
-    }
+    hdlc_ll_tx_crc_init(handle);
 
     uint8_t buf[1] = {FLAG_SEQUENCE};
     int result = hdlc_ll_send_tx_internal(handle, buf, sizeof(buf));
@@ -212,6 +273,7 @@ static int hdlc_ll_send_data(hdlc_ll_handle_t handle)
     if ( handle->tx.len == 0 )
     {
         LOG(TINY_LOG_DEB, "[HDLC:%p] hdlc_ll_send_crc\n", handle);
+        handle->tx.pos = 0;
         handle->tx.state = hdlc_ll_send_crc;
     }
     return result;
@@ -222,20 +284,21 @@ static int hdlc_ll_send_data(hdlc_ll_handle_t handle)
 static int hdlc_ll_send_crc(hdlc_ll_handle_t handle)
 {
     int result = 1;
-    if ( handle->tx.len == (uint8_t)handle->crc_type )
+    // crc field and parity field are sent after the payload, and are escaped the same way
+    if ( handle->tx.pos == HDLC_LL_TRAILER_SIZE(handle, (int)(handle->tx.data - handle->tx.origin_data)) )
     {
         handle->tx.state = hdlc_ll_send_end;
     }
     else
     {
-        uint8_t byte = handle->tx.crc >> handle->tx.len;
+        uint8_t byte = hdlc_ll_tx_trailer_byte(handle, handle->tx.pos);
         if ( byte != TINY_ESCAPE_CHAR && byte != FLAG_SEQUENCE )
         {
             result = hdlc_ll_send_tx_internal(handle, &byte, sizeof(byte));
             if ( result == 1 )
             {
                 LOG(TINY_LOG_DEB, "[HDLC:%p] TX: %02X\n", handle, byte);
-                handle->tx.len += 8;
+                handle->tx.pos++;
             }
         }
         else
@@ -248,7 +311,7 @@ static int hdlc_ll_send_crc(hdlc_ll_handle_t handle)
                 handle->tx.escape = !handle->tx.escape;
                 if ( !handle->tx.escape )
                 {
-                    handle->tx.len += 8;
+                    handle->tx.pos++;
                 }
             }
         }
@@ -267,33 +330,88 @@ static int hdlc_ll_send_end(hdlc_ll_handle_t handle)
     {
         LOG(TINY_LOG_DEB, "[HDLC:%p] TX: %02X\n", handle, buf[0]);
         LOG(TINY_LOG_INFO, "[HDLC:%p] hdlc_ll_send_end HDLC send op successful\n", handle);
-        handle->tx.state = hdlc_ll_send_start;
-        handle->tx.escape = 0;
-        int len = (int)(handle->tx.data - handle->tx.origin_data);
-        const void *ptr = handle->tx.origin_data;
-        handle->tx.origin_data = NULL;
-        handle->tx.data = NULL;
-        if ( handle->on_frame_send )
+        hdlc_ll_tx_frame_sent(handle, (int)(handle->tx.data - handle->tx.origin_data));
+    }
+    return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void hdlc_ll_tx_crc_init(hdlc_ll_handle_t handle)
+{
+    switch ( handle->crc_type )
+    {
+#ifdef CONFIG_ENABLE_FCS16
+        case HDLC_CRC_16: handle->tx.crc = tiny_crc16(PPPINITFCS16, handle->tx.data, handle->tx.len); break;
+#endif
+#ifdef CONFIG_ENABLE_FCS32
+        case HDLC_CRC_32: handle->tx.crc = tiny_crc32(PPPINITFCS32, handle->tx.data, handle->tx.len); break;
+        case HDLC_CRC_32C: handle->tx.crc = tiny_crc32c(INITCRC32C, handle->tx.data, handle->tx.len); break;
+#endif
+#ifdef CONFIG_ENABLE_CHECKSUM
+        case HDLC_CRC_8: handle->tx.crc = tiny_chksum(INITCHECKSUM, handle->tx.data, handle->tx.len); break;
+#endif
+        default: break;
+    }
+#ifdef CONFIG_ENABLE_FEC
+    // Parity protects crc field too, so it is calculated after crc
+    if ( handle->fec )
+    {
+        hdlc_ll_tx_fec_encode(handle);
+    }
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifdef CONFIG_ENABLE_FEC
+static void hdlc_ll_tx_fec_encode(hdlc_ll_handle_t handle)
+{
+    const int crc_size = HDLC_LL_CRC_SIZE(handle);
+    const int size = handle->tx.len + crc_size;
+    // Byte i of the frame belongs to block i % blocks, so the burst of errors is spread over all blocks
+    const int blocks = HDLC_LL_FEC_BLOCKS(size, handle->fec);
+    uint8_t *parity = HDLC_LL_TX_PARITY(handle);
+    tiny_rs_t rs;
+    tiny_rs_init(&rs, 2 * handle->fec);
+    memset(parity, 0, blocks * rs.nroots);
+    for ( int i = 0, block = 0; i < size; i++ )
+    {
+        uint8_t byte = i < handle->tx.len ? handle->tx.data[i] : hdlc_ll_tx_trailer_byte(handle, i - handle->tx.len);
+        tiny_rs_encode_byte(&rs, &parity[block * rs.nroots], byte);
+        if ( ++block == blocks )
         {
-            handle->on_frame_send(handle->user_data, ptr, len);
+            block = 0;
         }
     }
-    return result;
 }
+#endif
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
-static int hdlc_ll_send_tx_internal(hdlc_ll_handle_t handle, const void *data, int len)
+void hdlc_ll_tx_frame_sent(hdlc_ll_handle_t handle, int len)
 {
-    const uint8_t *ptr = (const uint8_t *)data;
-    int sent = 0;
-    while ( len-- && handle->tx.out_buffer_len )
+    hdlc_ll_tx_restart(handle);
+    handle->tx.escape = 0;
+    const void *ptr = handle->tx.origin_data;
+    handle->tx.origin_data = NULL;
+    handle->tx.data = NULL;
+    if ( handle->on_frame_send )
     {
-        handle->tx.out_buffer[0] = ptr[0];
-        handle->tx.out_buffer_len--;
-        handle->tx.out_buffer++;
-        ptr++;
-        sent++;
+        handle->on_frame_send(handle->user_data, ptr, len);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+int hdlc_ll_send_tx_internal(hdlc_ll_handle_t handle, const void *data, int len)
+{
+    int sent = len < handle->tx.out_buffer_len ? len : handle->tx.out_buffer_len;
+    if ( sent > 0 )
+    {
+        memcpy(handle->tx.out_buffer, data, sent);
+        handle->tx.out_buffer += sent;
+        handle->tx.out_buffer_len -= sent;
     }
     return sent;
 }
@@ -360,6 +478,12 @@ int hdlc_ll_put(hdlc_ll_handle_t handle, const void *data, int len)
     {
         return TINY_SUCCESS;
     }
+    // Parity of the frame is stored in the space, reserved for the frame of mtu size
+    if ( handle->fec && len + HDLC_LL_TRAILER_SIZE(handle, len) > handle->phys_mtu )
+    {
+        LOG(TINY_LOG_ERR, "[HDLC:%p] hdlc_ll_put too large frame for FEC: %i bytes\n", handle, len);
+        return TINY_ERR_DATA_TOO_LARGE;
+    }
     LOG(TINY_LOG_DEB, "[HDLC:%p] hdlc_ll_put SUCCESS\n", handle);
     handle->tx.origin_data = data;
     handle->tx.data = data;
@@ -384,59 +508,226 @@ static int hdlc_ll_read_start(hdlc_ll_handle_t handle, const uint8_t *data, int
         return 1;
     }
     LOG(TINY_LOG_DEB, "[HDLC:%p] RX: %02X\n", handle, data[0]);
-    handle->rx.escape = 0;
-    handle->rx.data = handle->rx.frame_buf;
+    hdlc_ll_rx_frame_init(handle);
     handle->rx.state = hdlc_ll_read_data;
     return 1;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
+void hdlc_ll_rx_frame_init(hdlc_ll_handle_t handle)
+{
+    handle->rx.escape = 0;
+    handle->rx.code = 0;
+    handle->rx.left = 0;
+    handle->rx.remaining = 0;
+    handle->rx.data = handle->rx.frame_buf;
+    switch ( handle->crc_type )
+    {
+#ifdef CONFIG_ENABLE_FCS16
+        case HDLC_CRC_16: handle->rx.crc = PPPINITFCS16; break;
+#endif
+#ifdef CONFIG_ENABLE_FCS32
+        case HDLC_CRC_32: handle->rx.crc = PPPINITFCS32; break;
+        case HDLC_CRC_32C: handle->rx.crc = INITCRC32C; break;
+#endif
+#ifdef CONFIG_ENABLE_CHECKSUM
+        case HDLC_CRC_8: handle->rx.crc = INITCHECKSUM; break;
+#endif
+        default: break;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Moves received part of the frame to the beginning of rx buffer, when the frame doesn't fit
+ * the end of the buffer in compact mode. Returns false if there is no room for the frame.
+ */
+static bool hdlc_ll_rx_wrap(hdlc_ll_handle_t handle)
+{
+    if ( !handle->rx.compact || handle->rx.frame_buf == handle->rx_buf )
+    {
+        return false;
+    }
+    int len = (int)(handle->rx.data - handle->rx.frame_buf);
+    memmove(handle->rx_buf, handle->rx.frame_buf, len);
+    handle->rx.frame_buf = handle->rx_buf;
+    handle->rx.data = handle->rx_buf + len;
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+static void hdlc_ll_rx_crc_update(hdlc_ll_handle_t handle, const uint8_t *data, int len)
+{
+    switch ( handle->crc_type )
+    {
+#ifdef CONFIG_ENABLE_FCS16
+        // tiny_crc16() and tiny_crc32() return complemented register, so complement it back
+        case HDLC_CRC_16: handle->rx.crc = (uint16_t)~tiny_crc16((uint16_t)handle->rx.crc, data, len); break;
+#endif
+#ifdef CONFIG_ENABLE_FCS32
+        case HDLC_CRC_32: handle->rx.crc = ~tiny_crc32(handle->rx.crc, data, len); break;
+        case HDLC_CRC_32C: handle->rx.crc = ~tiny_crc32c(handle->rx.crc, data, len); break;
+#endif
+#ifdef CONFIG_ENABLE_CHECKSUM
+        // tiny_chksum() returns complement of the sum, so convert it back to keep the running sum
+        case HDLC_CRC_8: handle->rx.crc = (uint16_t)(0xFFFF - tiny_chksum((uint16_t)handle->rx.crc, data, len)); break;
+#endif
+        default: break;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+static bool hdlc_ll_rx_crc_is_valid(hdlc_ll_handle_t handle)
+{
+    switch ( handle->crc_type )
+    {
+#ifdef CONFIG_ENABLE_FCS16
+        case HDLC_CRC_16: return (uint16_t)handle->rx.crc == PPPGOODFCS16;
+#endif
+#ifdef CONFIG_ENABLE_FCS32
+        case HDLC_CRC_32: return (uint32_t)handle->rx.crc == PPPGOODFCS32;
+        case HDLC_CRC_32C: return (uint32_t)handle->rx.crc == GOODCRC32C;
+#endif
+#ifdef CONFIG_ENABLE_CHECKSUM
+        case HDLC_CRC_8: return (handle->rx.crc & 0xFF) == RX_RESIDUE_CHECKSUM;
+#endif
+        default: break;
+    }
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+int hdlc_ll_rx_store(hdlc_ll_handle_t handle, const uint8_t *data, int len)
+{
+    int room = handle->phys_mtu - (int)(handle->rx.data - handle->rx.frame_buf);
+    int size = len < room ? len : room;
+    if ( handle->rx.data + size > handle->rx_buf + handle->rx_buf_size )
+    {
+        hdlc_ll_rx_wrap(handle);
+    }
+    int tail = (int)(handle->rx_buf + handle->rx_buf_size - handle->rx.data);
+    size = size < tail ? size : tail;
+    if ( size > 0 )
+    {
+#if TINY_HDLC_DEBUG
+        for ( int i = 0; i < size; i++ )
+            LOG(TINY_LOG_DEB, "[HDLC:%p] RX: %02X\n", handle, data[i]);
+#endif
+        memcpy(handle->rx.data, data, size);
+        if ( handle->rx.escape )
+        {
+            handle->rx.data[0] ^= TINY_ESCAPE_BIT;
+            handle->rx.escape = 0;
+        }
+        // With FEC the received bytes can be corrupted, so crc is calculated after correction
+        if ( !handle->fec )
+        {
+            hdlc_ll_rx_crc_update(handle, handle->rx.data, size);
+        }
+        handle->rx.data += size;
+    }
+    if ( size < len )
+    {
+        LOG(TINY_LOG_WRN, "[HDLC:%p] No space for incoming bytes: len=%i (mtu = %i)\n",
+                          handle, (int)(handle->rx.data - handle->rx.frame_buf), handle->phys_mtu);
+    }
+    return size;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
 static int hdlc_ll_read_data(hdlc_ll_handle_t handle, const uint8_t *data, int len)
 {
     int result = 0;
     while ( len > 0 )
     {
         uint8_t byte = data[0];
-        LOG(TINY_LOG_DEB, "[HDLC:%p] RX: %02X\n", handle, byte);
         if ( byte == FLAG_SEQUENCE )
         {
+            LOG(TINY_LOG_DEB, "[HDLC:%p] RX: %02X\n", handle, byte);
             handle->rx.state = hdlc_ll_read_end;
             result++;
             break;
         }
         if ( byte == TINY_ESCAPE_CHAR )
         {
+            LOG(TINY_LOG_DEB, "[HDLC:%p] RX: %02X\n", handle, byte);
             handle->rx.escape = 1;
+            result++;
+            data++;
+            len--;
+            continue;
         }
-        else if ( handle->rx.data - handle->rx.frame_buf < handle->phys_mtu )
+        if ( !hdlc_ll_rx_accept(handle, handle->rx.escape ? (byte ^ TINY_ESCAPE_BIT) : byte) )
         {
-            if ( handle->rx.escape )
-            {
-                *handle->rx.data = byte ^ TINY_ESCAPE_BIT;
-                handle->rx.escape = 0;
-            }
-            else
-            {
-                *handle->rx.data = byte;
-            }
-            handle->rx.data++;
+            result++;
+            break;
         }
-        else
+        // Bytes up to the next special char are copied as a block, crc is updated for the whole block
+        int block = 1;
+        while ( block < len && data[block] != FLAG_SEQUENCE && data[block] != TINY_ESCAPE_CHAR )
         {
-            LOG(TINY_LOG_WRN, "[HDLC:%p] No space for incoming byte: len=%i (mtu = %i)\n",
-                              handle, (int)(handle->rx.data - handle->rx.frame_buf), handle->phys_mtu);
+            block++;
         }
-        result++;
-        data++;
-        len--;
+        hdlc_ll_rx_store(handle, data, block);
+        result += block;
+        data += block;
+        len -= block;
     }
     return result;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
-static int hdlc_ll_read_end(hdlc_ll_handle_t handle, const uint8_t *data, int len_bytes)
+bool hdlc_ll_rx_accept(hdlc_ll_handle_t handle, uint8_t byte)
+{
+    // The first byte is enough to decide, whether the frame is needed. With FEC the byte
+    // can be corrupted, so such frames are filtered after correction.
+    if ( handle->on_frame_filter && !handle->fec && handle->rx.data == handle->rx.frame_buf &&
+         !handle->on_frame_filter(handle->user_data, byte) )
+    {
+        LOG(TINY_LOG_DEB, "[HDLC:%p] RX: skipping frame for address %02X\n", handle, byte);
+        handle->rx.escape = 0;
+        handle->rx.state = hdlc_ll_read_skip;
+        return false;
+    }
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+int hdlc_ll_read_skip(hdlc_ll_handle_t handle, const uint8_t *data, int len)
+{
+    if ( handle->framing == HDLC_FRAMING_RAW )
+    {
+        // Length of the frame is known, so just drop the rest of the frame
+        int size = handle->rx.remaining < len ? handle->rx.remaining : len;
+        handle->rx.remaining -= size;
+        if ( handle->rx.remaining == 0 )
+        {
+            hdlc_ll_rx_restart(handle);
+        }
+        return size;
+    }
+    // Stuffed bytes never produce frame delimiter on the line, so just look for the closing one
+    const uint8_t delimiter = handle->framing == HDLC_FRAMING_COBS ? 0x00 : FLAG_SEQUENCE;
+    const uint8_t *end = (const uint8_t *)memchr(data, delimiter, len);
+    if ( end == NULL )
+    {
+        return len;
+    }
+    hdlc_ll_rx_restart(handle);
+    return (int)(end - data) + 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+int hdlc_ll_read_end(hdlc_ll_handle_t handle, const uint8_t *data, int len_bytes)
 {
     if ( handle->rx.data == handle->rx.frame_buf )
     {
@@ -446,7 +737,15 @@ static int hdlc_ll_read_end(hdlc_ll_handle_t handle, const uint8_t *data, int le
         handle->rx.state = hdlc_ll_read_data;
         return 0; // That's OK, we actually didn't process anything from user bytes
     }
-    handle->rx.state = hdlc_ll_read_start;
+    int result = hdlc_ll_rx_frame_end(handle);
+    hdlc_ll_rx_restart(handle);
+    return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+static int hdlc_ll_rx_frame_end(hdlc_ll_handle_t handle)
+{
     int len = (int)(handle->rx.data - handle->rx.frame_buf);
     if ( len > handle->phys_mtu )
     {
@@ -454,42 +753,30 @@ static int hdlc_ll_read_end(hdlc_ll_handle_t handle, const uint8_t *data, int le
         LOG(TINY_LOG_ERR, "[HDLC:%p] RX: tool long frame\n", handle);
         return TINY_ERR_DATA_TOO_LARGE;
     }
-    if ( len < (uint8_t)handle->crc_type / 8 )
+#ifdef CONFIG_ENABLE_FEC
+    if ( handle->fec )
+    {
+        len = hdlc_ll_rx_fec_decode(handle, len);
+        if ( len < 0 )
+        {
+            LOG(TINY_LOG_ERR, "[HDLC:%p] RX: too many errors to correct\n", handle);
+            return TINY_ERR_WRONG_CRC;
+        }
+        hdlc_ll_rx_crc_update(handle, handle->rx.frame_buf, len);
+    }
+#endif
+    if ( len < HDLC_LL_CRC_SIZE(handle) )
     {
         // CRC size issue
         LOG(TINY_LOG_ERR, "[HDLC:%p] RX: crc field is too short\n", handle);
         return TINY_ERR_WRONG_CRC;
     }
-    crc_t calc_crc = 0;
-    crc_t read_crc = 0;
-    switch ( handle->crc_type )
-    {
-#ifdef CONFIG_ENABLE_CHECKSUM
-        case HDLC_CRC_8:
-            calc_crc = tiny_chksum(INITCHECKSUM, handle->rx.frame_buf, len - 1) & 0x00FF;
-            read_crc = handle->rx.data[-1];
-            break;
-#endif
-#ifdef CONFIG_ENABLE_FCS16
-        case HDLC_CRC_16:
-            calc_crc = tiny_crc16(PPPINITFCS16, handle->rx.frame_buf, len - 2);
-            read_crc = handle->rx.data[-2] | ((uint16_t)handle->rx.data[-1] << 8);
-            break;
-#endif
-#ifdef CONFIG_ENABLE_FCS32
-        case HDLC_CRC_32:
-            calc_crc = tiny_crc32(PPPINITFCS32, handle->rx.frame_buf, len - 4);
-            read_crc = handle->rx.data[-4] | ((uint32_t)handle->rx.data[-3] << 8) |
-                       ((uint32_t)handle->rx.data[-2] << 16) | ((uint32_t)handle->rx.data[-1] << 24);
-            break;
-#endif
-        default: break;
-    }
-    if ( calc_crc != read_crc )
+    // crc is calculated while bytes are received, so only the residue is checked here
+    if ( !hdlc_ll_rx_crc_is_valid(handle) )
     {
 // CRC calculate issue
 #if TINY_HDLC_DEBUG
-        LOG(TINY_LOG_ERR, "[HDLC:%p] RX: WRONG CRC (calc:%08X != %08X)\n", handle, calc_crc, read_crc);
+        LOG(TINY_LOG_ERR, "[HDLC:%p] RX: WRONG CRC (residue:%08X)\n", handle, (uint32_t)handle->rx.crc);
         if ( TINY_LOG_DEB < g_tiny_log_level )
             for ( int i = 0; i < len; i++ )
                 fprintf(stderr, " %c ", (char)(handle->rx.frame_buf)[i]);
@@ -502,22 +789,72 @@ static int hdlc_ll_read_end(hdlc_ll_handle_t handle, const uint8_t *data, int le
         return TINY_ERR_WRONG_CRC;
     }
     // Shift back data pointer, pointing to the last byte after payload
-    len -= (uint8_t)handle->crc_type / 8;
+    len -= HDLC_LL_CRC_SIZE(handle);
     LOG(TINY_LOG_INFO, "[HDLC:%p] RX: Frame success: %d bytes\n", handle, len);
+    if ( handle->fec && handle->on_frame_filter && !handle->on_frame_filter(handle->user_data, handle->rx.frame_buf[0]) )
+    {
+        // The frame is not needed, and its slot is reused for the next frame
+        return TINY_SUCCESS;
+    }
     if ( handle->on_frame_read )
     {
         handle->on_frame_read(handle->user_data, handle->rx.frame_buf, len);
     }
-    handle->rx.frame_buf += handle->phys_mtu;
-    if ( handle->rx.frame_buf - handle->rx_buf + handle->phys_mtu > handle->rx_buf_size )
+    if ( handle->rx.compact )
     {
-        handle->rx.frame_buf = handle->rx_buf;
+        // Next frame starts right after crc field of this one, it is moved to the beginning only if it doesn't fit
+        handle->rx.frame_buf = handle->rx.data;
+    }
+    else
+    {
+        handle->rx.frame_buf += handle->phys_mtu;
+        if ( handle->rx.frame_buf - handle->rx_buf + handle->phys_mtu > handle->rx_buf_size )
+        {
+            handle->rx.frame_buf = handle->rx_buf;
+        }
     }
     return TINY_SUCCESS;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
+#ifdef CONFIG_ENABLE_FEC
+static int hdlc_ll_rx_fec_decode(hdlc_ll_handle_t handle, int len)
+{
+    tiny_rs_t rs;
+    tiny_rs_init(&rs, 2 * handle->fec);
+    // Frame of size bytes has ceil(size / block data size) parity blocks, only one size matches the received length
+    int blocks = 1;
+    int size = len - rs.nroots;
+    while ( size > 0 && HDLC_LL_FEC_BLOCKS(size, handle->fec) != blocks )
+    {
+        blocks++;
+        size -= rs.nroots;
+    }
+    if ( size <= 0 )
+    {
+        return TINY_ERR_FAILED;
+    }
+    uint8_t *parity = handle->rx.frame_buf + size;
+    for ( int block = 0; block < blocks; block++ )
+    {
+        int block_len = (size - block + blocks - 1) / blocks;
+        int result = tiny_rs_decode(&rs, &handle->rx.frame_buf[block], block_len, blocks, &parity[block * rs.nroots]);
+        if ( result < 0 )
+        {
+            return TINY_ERR_FAILED;
+        }
+        if ( result > 0 )
+        {
+            LOG(TINY_LOG_INFO, "[HDLC:%p] RX: %i bytes corrected in block %i\n", handle, result, block);
+        }
+    }
+    return size;
+}
+#endif
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
 int hdlc_ll_run_rx(hdlc_ll_handle_t handle, const void *data, int len, int *error)
 {
     int result = 0;
@@ -547,16 +884,14 @@ int hdlc_ll_run_rx(hdlc_ll_handle_t handle, const void *data, int len, int *erro
 
 int hdlc_ll_get_buf_size(int mtu)
 {
-    // TINY_ALIGN_STRUCT_VALUE is added to satisfy alignment requirements
-    return get_crc_field_size(HDLC_CRC_32) + sizeof(hdlc_ll_data_t) + mtu + TINY_ALIGN_STRUCT_VALUE - 1;
+    return HDLC_LL_BUF_SIZE_EX(mtu, HDLC_CRC_32, 1);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
 int hdlc_ll_get_buf_size_ex(int mtu, hdlc_crc_t crc_type, int rx_window)
 {
-    // TINY_ALIGN_STRUCT_VALUE is added to satisfy alignment requirements
-    return (get_crc_field_size(crc_type) + mtu) * rx_window + sizeof(hdlc_ll_data_t) + TINY_ALIGN_STRUCT_VALUE - 1;
+    return HDLC_LL_BUF_SIZE_EX(mtu, crc_type, rx_window);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////
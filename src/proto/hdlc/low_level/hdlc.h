@@ -40,6 +40,40 @@ extern "C"
 /** Byte to fill gap between frames */
 #define TINY_HDLC_FILL_BYTE 0xFF
 
+/**
+ * Size of hdlc low level control data at the beginning of the buffer. This is upper bound
+ * for the size of the internal structure, which is checked at compile time.
+ * Control data contain 12 pointers and the fields up to 32 bits, including the padding of rx and tx states.
+ */
+#define HDLC_LL_DATA_SIZE (TINY_SCALAR_SIZE * 12 + sizeof(uint32_t) * 16)
+
+/**
+ * Size of hdlc low level data, located at aligned address, with rx window of frames of mtu bytes.
+ */
+#define HDLC_LL_LAYOUT_SIZE(mtu, crc, window) (HDLC_LL_DATA_SIZE + (HDLC_CRC_FIELD_SIZE(crc) + (mtu)) * (window))
+
+/**
+ * Buffer size required to receive frames of mtu bytes to the rx window of frames.
+ * The same as hdlc_ll_get_buf_size_ex() returns.
+ */
+#define HDLC_LL_BUF_SIZE_EX(mtu, crc, window) (HDLC_LL_LAYOUT_SIZE(mtu, crc, window) + TINY_ALIGN_STRUCT_VALUE - 1)
+
+/** Maximum number of byte errors, corrected in each block of the frame, see hdlc_ll_init_t::fec */
+#define HDLC_LL_FEC_MAX 16
+
+/** Number of Reed-Solomon blocks for the frame of len bytes, including crc field */
+#define HDLC_LL_FEC_BLOCKS(len, fec) (((len) + 254 - 2 * (fec)) / (255 - 2 * (fec)))
+
+/** Size of parity field for the frame of len bytes, including crc field. The field is empty, if fec is 0 */
+#define HDLC_LL_FEC_PARITY_SIZE(len, fec) ((fec) ? HDLC_LL_FEC_BLOCKS(len, fec) * 2 * (fec) : 0)
+
+/**
+ * Extra buffer space, required when hdlc_ll_init_t::fec is set: parity of the frame being sent and
+ * parity field of each frame in the rx window. Add it to the size, returned by hdlc_ll_get_buf_size_ex().
+ */
+#define HDLC_LL_FEC_BUF_SIZE(mtu, crc, fec, window)                                                                    \
+    (HDLC_LL_FEC_PARITY_SIZE(HDLC_CRC_FIELD_SIZE(crc) + (mtu), fec) * ((window) + 1))
+
     /**
      * @defgroup HDLC_LOW_LEVEL_API HDLC low level protocol API
      * @{
@@ -62,11 +96,30 @@ extern "C"
         HDLC_LL_RESET_RX_ONLY = 0x02,
     } hdlc_ll_reset_flags_t;
 
+    /**
+     * Framing methods, supported by hdlc low level
+     */
+    typedef enum
+    {
+        HDLC_FRAMING_HDLC = 0, ///< RFC 1662 byte stuffing: 0x7E flags, 0x7D escape char
+        HDLC_FRAMING_COBS = 1, ///< Consistent Overhead Byte Stuffing: frames are delimited by 0x00
+        HDLC_FRAMING_RAW = 2,  ///< Length prefix without escaping, for the transports keeping the byte stream intact
+    } hdlc_framing_t;
+
     struct hdlc_ll_data_t;
 
     /** Handle for HDLC low level protocol */
     typedef struct hdlc_ll_data_t *hdlc_ll_handle_t;
 
+    /**
+     * Callback to check the first byte of incoming frame, which is address field for HDLC frames.
+     * It is called before the rest of the frame is received.
+     * @param user_data user-defined data
+     * @param address first byte of the frame
+     * @return true if the frame must be received, false to skip the frame without crc check
+     */
+    typedef bool (*hdlc_ll_frame_filter_cb_t)(void *user_data, uint8_t address);
+
     /**
      * Structure describes configuration of lowest HDLC level
      * Initialize this structure by 0 before passing to hdlc_ll_init()
@@ -118,6 +171,44 @@ extern "C"
 
         /** mtu size, can be 0 */
         int mtu;
+
+        /**
+         * RX storage mode. If zero, the buffer is split to the slots of mtu size, and each received
+         * frame takes the whole slot. If non-zero, received frames are packed back to back in the
+         * buffer, so the frame takes only its actual size, and the buffer holds more recent frames
+         * for the mixed traffic. A frame is never split: if it doesn't fit the end of the buffer, the
+         * received part is moved to the beginning. In both modes the frame stays valid until the
+         * buffer wraps over it.
+         */
+        uint8_t rx_compact;
+
+        /**
+         * Optional callback to filter incoming frames by the first byte. Rejected frames are skipped
+         * up to the closing flag: they are not copied to rx buffer and crc is not calculated.
+         * This saves CPU for the stations on the shared bus. Can be NULL.
+         */
+        hdlc_ll_frame_filter_cb_t on_frame_filter;
+
+        /**
+         * Framing method, HDLC_FRAMING_HDLC by default. Both sides must use the same method.
+         * HDLC_FRAMING_COBS adds only 1 byte per 254 bytes of frame, and the overhead doesn't
+         * depend on the data, while HDLC can double the size of the frame in the worst case.
+         * HDLC_FRAMING_RAW prefixes the frame with its length (7 bits per byte, up to 4 bytes) and
+         * sends the data as is. It can't resynchronize after lost or corrupted bytes, so it is intended
+         * for TCP, Unix sockets, USB bulk endpoints, etc. crc_type can be HDLC_CRC_OFF in this mode.
+         */
+        hdlc_framing_t framing;
+
+        /**
+         * Number of byte errors, which the receiver corrects in each block of the frame, 0 disables
+         * forward error correction. Payload and crc field are split to interleaved Reed-Solomon blocks
+         * of up to 255 bytes, and 2 * fec parity bytes of each block are sent after crc field, so the
+         * burst of errors is spread over the blocks. Corrupted bytes must not change the length of the
+         * frame, so lost or corrupted framing bytes still drop the frame. Valid values are from 1 to
+         * HDLC_LL_FEC_MAX, mtu must be set, and the buffer must have HDLC_LL_FEC_BUF_SIZE() bytes more.
+         * Both sides must use the same value. Requires CONFIG_ENABLE_FEC.
+         */
+        uint8_t fec;
     } hdlc_ll_init_t;
 
     //------------------------ GENERIC FUNCIONS ------------------------------
@@ -207,6 +298,7 @@ extern "C"
      * @param len size of data to send in bytes
      * @return TINY_ERR_BUSY if TX queue is busy with another frame.
      *         TINY_ERR_INVALID_DATA if len is zero.
+     *         TINY_ERR_DATA_TOO_LARGE if FEC is enabled, and len exceeds mtu.
      *         TINY_SUCCESS if data is successfully sent
      * @warning buffer with data must be available all the time until
      *          data are actually sent to tx hw channel. That is if you use
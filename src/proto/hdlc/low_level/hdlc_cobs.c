@@ -0,0 +1,259 @@
+/*
+    Copyright 2022 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    GNU General Public License Usage
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Commercial License Usage
+
+    Licensees holding valid commercial Tiny Protocol licenses may use this file in
+    accordance with the commercial license agreement provided in accordance with
+    the terms contained in a written agreement between you and Alexey Dynda.
+    For further information contact via email on github account.
+*/
+
+/*
+ * Consistent Overhead Byte Stuffing framing for hdlc low level.
+ * Frame on the line: 0x00 | COBS(payload + crc field + parity field) | 0x00
+ * Every group starts with code byte N, followed by N-1 non-zero bytes. If N < 0xFF, the group
+ * is followed by zero byte in decoded data, except for the last group of the frame.
+ */
+
+#include "hdlc.h"
+#include "hdlc_int.h"
+#include "hal/tiny_debug.h"
+
+#include <string.h>
+
+#ifndef TINY_HDLC_DEBUG
+#define TINY_HDLC_DEBUG 0
+#endif
+
+#if TINY_HDLC_DEBUG
+#define LOG(lvl, fmt, ...) TINY_LOG(lvl, fmt, __VA_ARGS__)
+#else
+#define LOG(...)
+#endif
+
+#define COBS_DELIMITER 0x00
+#define COBS_MAX_RUN 254
+
+static int hdlc_cobs_send_code(hdlc_ll_handle_t handle);
+static int hdlc_cobs_send_run(hdlc_ll_handle_t handle);
+static int hdlc_cobs_send_end(hdlc_ll_handle_t handle);
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+static inline int __cobs_frame_size(hdlc_ll_handle_t handle)
+{
+    return handle->tx.len + HDLC_LL_TRAILER_SIZE(handle, handle->tx.len);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+static inline uint8_t __cobs_tx_byte(hdlc_ll_handle_t handle, int pos)
+{
+    // crc and parity fields follow the payload
+    return pos < handle->tx.len ? handle->tx.data[pos] : hdlc_ll_tx_trailer_byte(handle, pos - handle->tx.len);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+static void __cobs_end_group(hdlc_ll_handle_t handle)
+{
+    if ( handle->tx.pos < __cobs_frame_size(handle) )
+    {
+        // Zero byte after the group is encoded by the code byte itself
+        if ( handle->tx.code != 0xFF )
+        {
+            handle->tx.pos++;
+        }
+        handle->tx.state = hdlc_cobs_send_code;
+    }
+    else
+    {
+        handle->tx.state = hdlc_cobs_send_end;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+int hdlc_cobs_send_start(hdlc_ll_handle_t handle)
+{
+    if ( !handle->tx.origin_data )
+    {
+        return 0;
+    }
+    LOG(TINY_LOG_INFO, "[HDLC:%p] Starting send op for COBS frame\n", handle);
+    hdlc_ll_tx_crc_init(handle);
+    // Leading delimiter terminates any garbage, received by remote side before the frame
+    uint8_t byte = COBS_DELIMITER;
+    int result = hdlc_ll_send_tx_internal(handle, &byte, sizeof(byte));
+    if ( result == 1 )
+    {
+        handle->tx.pos = 0;
+        handle->tx.state = hdlc_cobs_send_code;
+    }
+    return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+static int hdlc_cobs_send_code(hdlc_ll_handle_t handle)
+{
+    int size = __cobs_frame_size(handle);
+    int limit = size - handle->tx.pos < COBS_MAX_RUN ? size - handle->tx.pos : COBS_MAX_RUN;
+    int run = 0;
+    if ( handle->tx.pos < handle->tx.len )
+    {
+        // Payload is scanned with memchr(), which is vectorized by the most of C libraries
+        int chunk = handle->tx.len - handle->tx.pos < limit ? handle->tx.len - handle->tx.pos : limit;
+        const uint8_t *zero = (const uint8_t *)memchr(&handle->tx.data[handle->tx.pos], 0, chunk);
+        run = zero ? (int)(zero - &handle->tx.data[handle->tx.pos]) : chunk;
+    }
+    while ( run < limit && handle->tx.pos + run >= handle->tx.len && __cobs_tx_byte(handle, handle->tx.pos + run) != 0 )
+    {
+        run++;
+    }
+    uint8_t code = (uint8_t)(run + 1);
+    int result = hdlc_ll_send_tx_internal(handle, &code, sizeof(code));
+    if ( result == 1 )
+    {
+        handle->tx.code = code;
+        handle->tx.run = (uint8_t)run;
+        handle->tx.state = hdlc_cobs_send_run;
+        if ( run == 0 )
+        {
+            // Runs of zeros produce only code bytes
+            __cobs_end_group(handle);
+        }
+    }
+    return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+static int hdlc_cobs_send_run(hdlc_ll_handle_t handle)
+{
+    int result = 0;
+    if ( handle->tx.run )
+    {
+        if ( handle->tx.pos < handle->tx.len )
+        {
+            int chunk = handle->tx.len - handle->tx.pos < handle->tx.run ? handle->tx.len - handle->tx.pos : handle->tx.run;
+            result = hdlc_ll_send_tx_internal(handle, &handle->tx.data[handle->tx.pos], chunk);
+        }
+        else
+        {
+            uint8_t byte = __cobs_tx_byte(handle, handle->tx.pos);
+            result = hdlc_ll_send_tx_internal(handle, &byte, sizeof(byte));
+        }
+        handle->tx.pos += result;
+        handle->tx.run -= (uint8_t)result;
+    }
+    if ( handle->tx.run == 0 )
+    {
+        __cobs_end_group(handle);
+    }
+    return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+static int hdlc_cobs_send_end(hdlc_ll_handle_t handle)
+{
+    uint8_t byte = COBS_DELIMITER;
+    int result = hdlc_ll_send_tx_internal(handle, &byte, sizeof(byte));
+    if ( result == 1 )
+    {
+        LOG(TINY_LOG_INFO, "[HDLC:%p] COBS send op successful\n", handle);
+        hdlc_ll_tx_frame_sent(handle, handle->tx.len);
+    }
+    return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+static bool __cobs_store(hdlc_ll_handle_t handle, const uint8_t *data, int len)
+{
+    if ( !hdlc_ll_rx_accept(handle, data[0]) )
+    {
+        return false;
+    }
+    hdlc_ll_rx_store(handle, data, len);
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+int hdlc_cobs_read_data(hdlc_ll_handle_t handle, const uint8_t *data, int len)
+{
+    int result = 0;
+    while ( len > 0 )
+    {
+        if ( data[0] == COBS_DELIMITER )
+        {
+            result++;
+            if ( handle->rx.data == handle->rx.frame_buf )
+            {
+                // Nothing is decoded between delimiters, just start the frame again
+                hdlc_ll_rx_frame_init(handle);
+                data++;
+                len--;
+                continue;
+            }
+            handle->rx.state = hdlc_ll_read_end;
+            break;
+        }
+        if ( handle->rx.left == 0 )
+        {
+            uint8_t code = data[0];
+            result++;
+            data++;
+            len--;
+            // The group with code less than 0xFF is followed by zero byte, if there is next group
+            if ( handle->rx.code != 0 && handle->rx.code != 0xFF )
+            {
+                const uint8_t zero = 0;
+                if ( !__cobs_store(handle, &zero, 1) )
+                {
+                    break;
+                }
+            }
+            handle->rx.code = code;
+            handle->rx.left = code - 1;
+            continue;
+        }
+        // Bytes of the group are copied as a block, crc is updated for the whole block
+        int block = handle->rx.left < len ? handle->rx.left : len;
+        const uint8_t *zero = (const uint8_t *)memchr(data, COBS_DELIMITER, block);
+        if ( zero != NULL )
+        {
+            // Broken group, the frame is terminated by the delimiter, and will fail crc check
+            block = (int)(zero - data);
+        }
+        result += block;
+        if ( !__cobs_store(handle, data, block) )
+        {
+            break;
+        }
+        handle->rx.left -= (uint8_t)block;
+        data += block;
+        len -= block;
+    }
+    return result;
+}
@@ -29,6 +29,7 @@
 
 #include "hal/tiny_types.h"
 #include "proto/crc/tiny_crc.h"
+#include "proto/hdlc/low_level/hdlc.h"
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -50,12 +51,12 @@ extern "C"
 /**
  * Macro calculating minimum buffer size required for specific packet size in bytes
  */
-#define HDLC_MIN_BUF_SIZE(mtu, crc) (sizeof(hdlc_ll_data_t) + (int)(crc) / 8 + (mtu) + TINY_ALIGN_STRUCT_VALUE - 1)
+#define HDLC_MIN_BUF_SIZE(mtu, crc) HDLC_LL_BUF_SIZE_EX(mtu, crc, 1)
 
 /**
  * Macro calculating buffer size required for specific packet size in bytes, and window
  */
-#define HDLC_BUF_SIZE_EX(mtu, crc, window) (sizeof(hdlc_ll_data_t) + ((int)(crc) / 8 + (mtu)) * (window) + TINY_ALIGN_STRUCT_VALUE - 1)
+#define HDLC_BUF_SIZE_EX(mtu, crc, window) HDLC_LL_BUF_SIZE_EX(mtu, crc, window)
 
     /**
      * Structure describes configuration of lowest HDLC level
@@ -104,6 +105,15 @@ extern "C"
         /** User data, which will be passed to user-defined callback as first argument */
         void *user_data;
 
+        /** Optional callback to filter incoming frames by the first byte */
+        hdlc_ll_frame_filter_cb_t on_frame_filter;
+
+        /** Framing method */
+        hdlc_framing_t framing;
+
+        /** Number of correctable byte errors per FEC block, 0 if FEC is disabled */
+        uint8_t fec;
+
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
         /** Parameters in DOXYGEN_SHOULD_SKIP_THIS section should not be modified by a user */
         int phys_mtu;
@@ -111,23 +121,70 @@ extern "C"
         {
             int (*state)(hdlc_ll_handle_t handle, const uint8_t *data, int len);
             uint8_t *data;
-            uint8_t escape;
             uint8_t *frame_buf;
+            crc_t crc;
+            int remaining; // RAW: number of bytes left in the current frame
+            uint8_t escape;
+            uint8_t compact;
+            uint8_t code;  // COBS: code byte of the current group; RAW: bit shift of the length prefix
+            uint8_t left;  // COBS: number of bytes left in the current group
         } rx;
         struct
         {
             int (*state)(hdlc_ll_handle_t handle);
             uint8_t *out_buffer;
-            int out_buffer_len;
             const uint8_t *origin_data;
             const uint8_t *data;
+            int out_buffer_len;
             int len;
             crc_t crc;
+            int pos;      // HDLC: trailer byte index; COBS: position in the frame including trailer; RAW: length prefix, trailer byte index
             uint8_t escape;
+            uint8_t code; // COBS: code byte of the current group
+            uint8_t run;  // COBS: number of bytes left to send in the current group
         } tx;
 #endif
     } hdlc_ll_data_t;
 
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+    /* Size of crc field in bytes for the handle, HDLC_CRC_OFF is stored as 0 in crc_type */
+#define HDLC_LL_CRC_SIZE(handle) ((handle)->crc_type ? HDLC_CRC_FIELD_SIZE((handle)->crc_type) : 0)
+
+    /* Size of the fields, following the payload of len bytes: crc field and FEC parity field */
+#define HDLC_LL_TRAILER_SIZE(handle, len)                                                                              \
+    (HDLC_LL_CRC_SIZE(handle) + HDLC_LL_FEC_PARITY_SIZE(HDLC_LL_CRC_SIZE(handle) + (len), (handle)->fec))
+
+    /* Parity of the frame being sent is kept right after the control data, rx buffer follows it */
+#define HDLC_LL_TX_PARITY(handle) ((uint8_t *)((handle) + 1))
+
+    /* Returns byte of the trailer at pos: crc field is sent LSB first, then parity bytes */
+    static inline uint8_t hdlc_ll_tx_trailer_byte(hdlc_ll_handle_t handle, int pos)
+    {
+        return pos < HDLC_LL_CRC_SIZE(handle) ? (uint8_t)(handle->tx.crc >> (pos * 8))
+                                              : HDLC_LL_TX_PARITY(handle)[pos - HDLC_LL_CRC_SIZE(handle)];
+    }
+
+    /* Functions shared by the framing methods */
+    void hdlc_ll_rx_restart(hdlc_ll_handle_t handle);
+    void hdlc_ll_rx_frame_init(hdlc_ll_handle_t handle);
+    int hdlc_ll_rx_store(hdlc_ll_handle_t handle, const uint8_t *data, int len);
+    bool hdlc_ll_rx_accept(hdlc_ll_handle_t handle, uint8_t byte);
+    int hdlc_ll_read_end(hdlc_ll_handle_t handle, const uint8_t *data, int len);
+    int hdlc_ll_read_skip(hdlc_ll_handle_t handle, const uint8_t *data, int len);
+    void hdlc_ll_tx_restart(hdlc_ll_handle_t handle);
+    void hdlc_ll_tx_crc_init(hdlc_ll_handle_t handle);
+    int hdlc_ll_send_tx_internal(hdlc_ll_handle_t handle, const void *data, int len);
+    void hdlc_ll_tx_frame_sent(hdlc_ll_handle_t handle, int len);
+
+    /* COBS framing, hdlc_cobs.c */
+    int hdlc_cobs_read_data(hdlc_ll_handle_t handle, const uint8_t *data, int len);
+    int hdlc_cobs_send_start(hdlc_ll_handle_t handle);
+
+    /* Length prefixed framing, hdlc_raw.c */
+    int hdlc_raw_read_length(hdlc_ll_handle_t handle, const uint8_t *data, int len);
+    int hdlc_raw_send_start(hdlc_ll_handle_t handle);
+#endif
+
     /**
      * @}
      */
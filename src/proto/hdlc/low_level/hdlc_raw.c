@@ -0,0 +1,185 @@
+/*
+    Copyright 2022 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    GNU General Public License Usage
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Commercial License Usage
+
+    Licensees holding valid commercial Tiny Protocol licenses may use this file in
+    accordance with the commercial license agreement provided in accordance with
+    the terms contained in a written agreement between you and Alexey Dynda.
+    For further information contact via email on github account.
+*/
+
+/*
+ * Length prefixed framing for hdlc low level.
+ * Frame on the line: length | payload | crc field | parity field
+ * Length counts payload, crc and parity fields, and is sent 7 bits per byte, LSB first. Bit 7 is set in
+ * all bytes of the length except the last one. There is no escaping, so the data is copied as is.
+ */
+
+#include "hdlc.h"
+#include "hdlc_int.h"
+#include "hal/tiny_debug.h"
+
+#include <string.h>
+
+#ifndef TINY_HDLC_DEBUG
+#define TINY_HDLC_DEBUG 0
+#endif
+
+#if TINY_HDLC_DEBUG
+#define LOG(lvl, fmt, ...) TINY_LOG(lvl, fmt, __VA_ARGS__)
+#else
+#define LOG(...)
+#endif
+
+#define RAW_LENGTH_MORE 0x80
+#define RAW_LENGTH_MAX_SHIFT 28
+
+static int hdlc_raw_send_length(hdlc_ll_handle_t handle);
+static int hdlc_raw_send_data(hdlc_ll_handle_t handle);
+static int hdlc_raw_send_crc(hdlc_ll_handle_t handle);
+static int hdlc_raw_read_data(hdlc_ll_handle_t handle, const uint8_t *data, int len);
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+int hdlc_raw_send_start(hdlc_ll_handle_t handle)
+{
+    if ( !handle->tx.origin_data )
+    {
+        return 0;
+    }
+    LOG(TINY_LOG_INFO, "[HDLC:%p] Starting send op for RAW frame\n", handle);
+    hdlc_ll_tx_crc_init(handle);
+    handle->tx.pos = handle->tx.len + HDLC_LL_TRAILER_SIZE(handle, handle->tx.len);
+    handle->tx.state = hdlc_raw_send_length;
+    return hdlc_raw_send_length(handle);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+static int hdlc_raw_send_length(hdlc_ll_handle_t handle)
+{
+    uint8_t byte = (uint8_t)(handle->tx.pos & 0x7F);
+    if ( handle->tx.pos > 0x7F )
+    {
+        byte |= RAW_LENGTH_MORE;
+    }
+    int result = hdlc_ll_send_tx_internal(handle, &byte, sizeof(byte));
+    if ( result == 1 )
+    {
+        handle->tx.pos >>= 7;
+        if ( !(byte & RAW_LENGTH_MORE) )
+        {
+            handle->tx.state = hdlc_raw_send_data;
+        }
+    }
+    return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+static int hdlc_raw_send_data(hdlc_ll_handle_t handle)
+{
+    int result = hdlc_ll_send_tx_internal(handle, handle->tx.data, handle->tx.len);
+    handle->tx.data += result;
+    handle->tx.len -= result;
+    if ( handle->tx.len == 0 )
+    {
+        handle->tx.pos = 0;
+        handle->tx.state = hdlc_raw_send_crc;
+    }
+    return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+static int hdlc_raw_send_crc(hdlc_ll_handle_t handle)
+{
+    int result = 0;
+    const int len = (int)(handle->tx.data - handle->tx.origin_data);
+    if ( handle->tx.pos < HDLC_LL_TRAILER_SIZE(handle, len) )
+    {
+        // crc field is sent LSB first, as in other framing methods, and followed by parity field
+        uint8_t byte = hdlc_ll_tx_trailer_byte(handle, handle->tx.pos);
+        result = hdlc_ll_send_tx_internal(handle, &byte, sizeof(byte));
+        handle->tx.pos += result;
+    }
+    if ( handle->tx.pos >= HDLC_LL_TRAILER_SIZE(handle, len) )
+    {
+        LOG(TINY_LOG_INFO, "[HDLC:%p] RAW send op successful\n", handle);
+        hdlc_ll_tx_frame_sent(handle, len);
+    }
+    return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+int hdlc_raw_read_length(hdlc_ll_handle_t handle, const uint8_t *data, int len)
+{
+    int result = 0;
+    while ( result < len )
+    {
+        uint8_t byte = data[result++];
+        if ( handle->rx.code < RAW_LENGTH_MAX_SHIFT )
+        {
+            handle->rx.remaining |= (int)(byte & 0x7F) << handle->rx.code;
+        }
+        handle->rx.code += 7;
+        if ( byte & RAW_LENGTH_MORE )
+        {
+            continue;
+        }
+        if ( handle->rx.remaining == 0 )
+        {
+            // Empty frame, nothing to receive
+            hdlc_ll_rx_frame_init(handle);
+            continue;
+        }
+        if ( handle->rx.remaining > handle->phys_mtu || handle->rx.code > RAW_LENGTH_MAX_SHIFT )
+        {
+            LOG(TINY_LOG_ERR, "[HDLC:%p] RX: too long frame: %i bytes (mtu = %i)\n", handle, handle->rx.remaining,
+                handle->phys_mtu);
+            handle->rx.state = hdlc_ll_read_skip;
+            break;
+        }
+        handle->rx.state = hdlc_raw_read_data;
+        break;
+    }
+    return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+static int hdlc_raw_read_data(hdlc_ll_handle_t handle, const uint8_t *data, int len)
+{
+    if ( !hdlc_ll_rx_accept(handle, data[0]) )
+    {
+        // The frame is not needed, the rest of it is dropped by skip state
+        return hdlc_ll_read_skip(handle, data, len);
+    }
+    int size = handle->rx.remaining < len ? handle->rx.remaining : len;
+    hdlc_ll_rx_store(handle, data, size);
+    handle->rx.remaining -= size;
+    if ( handle->rx.remaining == 0 )
+    {
+        handle->rx.state = hdlc_ll_read_end;
+    }
+    return size;
+}
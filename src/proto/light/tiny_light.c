@@ -52,6 +52,9 @@
 #define TINY_ESCAPE_CHAR 0x7D
 #define TINY_ESCAPE_BIT 0x20
 
+// LIGHT_BUF_SIZE is defined in the public header without access to hdlc_ll_data_t, so check it here
+typedef char light_buf_size_check_t[(LIGHT_BUF_SIZE >= sizeof(hdlc_ll_data_t)) ? 1 : -1];
+
 //////////////////////////////////////////////////////////////////////////////
 
 /**************************************************************
@@ -76,10 +79,13 @@ int tiny_light_init(STinyLightData *handle, write_block_cb_t write_func, read_bl
     init.buf = &handle->buffer[0];
     init.buf_size = LIGHT_BUF_SIZE;
     init.crc_type = ((STinyLightData *)handle)->crc_type;
+    init.framing = handle->framing;
 
     handle->user_data = pdata;
     handle->read_func = read_func;
     handle->write_func = write_func;
+    handle->rx_block_pos = 0;
+    handle->rx_block_len = 0;
 
     return hdlc_ll_init(&handle->_hdlc, &init);
 }
@@ -117,22 +123,24 @@ int tiny_light_send(STinyLightData *handle, const uint8_t *pbuf, int len)
     hdlc_ll_put(handle->_hdlc, pbuf, len);
     while ( handle->_hdlc->tx.origin_data )
     {
-        uint8_t stream[1];
-        int stream_len = hdlc_ll_run_tx(handle->_hdlc, stream, sizeof(stream));
-        do
+        // Encode as much as possible to the staging buffer to pass it to the channel at once
+        int stream_len = hdlc_ll_run_tx(handle->_hdlc, handle->tx_block, sizeof(handle->tx_block));
+        int sent = 0;
+        while ( sent < stream_len )
         {
-            result = handle->write_func(handle->user_data, stream, stream_len);
+            result = handle->write_func(handle->user_data, handle->tx_block + sent, stream_len - sent);
             if ( result < 0 )
             {
                 return result;
             }
-            if ( (uint32_t)(tiny_millis() - ts) >= 1000 )
+            sent += result;
+            if ( sent < stream_len && (uint32_t)(tiny_millis() - ts) >= 1000 )
             {
                 hdlc_ll_reset(handle->_hdlc, HDLC_LL_RESET_TX_ONLY);
                 result = TINY_ERR_TIMEOUT;
                 break;
             }
-        } while ( result < stream_len );
+        }
     }
     return result >= 0 ? len : result;
 }
@@ -166,17 +174,23 @@ int tiny_light_read(STinyLightData *handle, uint8_t *pbuf, int len)
     handle->rx_len = 0;
     do
     {
-        uint8_t stream[1];
-        int stream_len = handle->read_func(handle->user_data, stream, sizeof(stream));
-        if ( stream_len < 0 )
+        if ( handle->rx_block_pos == handle->rx_block_len )
         {
-            result = stream_len;
-            break;
+            int stream_len = handle->read_func(handle->user_data, handle->rx_block, sizeof(handle->rx_block));
+            if ( stream_len < 0 )
+            {
+                result = stream_len;
+                break;
+            }
+            handle->rx_block_pos = 0;
+            handle->rx_block_len = stream_len;
         }
-        hdlc_ll_run_rx(handle->_hdlc, stream, stream_len, &result);
-        if ( result == TINY_SUCCESS )
+        // hdlc_ll_run_rx() stops after the end of the frame, so the rest bytes are left for the next call
+        handle->rx_block_pos += hdlc_ll_run_rx(handle->_hdlc, handle->rx_block + handle->rx_block_pos,
+                                               handle->rx_block_len - handle->rx_block_pos, &result);
+        if ( result == TINY_SUCCESS && handle->rx_len == 0 )
         {
-            hdlc_ll_run_rx(handle->_hdlc, stream, 0, &result);
+            hdlc_ll_run_rx(handle->_hdlc, handle->rx_block, 0, &result);
         }
         if ( result != TINY_SUCCESS )
         {
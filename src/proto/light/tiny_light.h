@@ -55,9 +55,36 @@ extern "C"
  *************************************************************/
 
 /**
- * This macro defines buffer size required for tiny light protocol
+ * This macro defines buffer size required for tiny light protocol.
+ * Light receives frames directly to the user buffer, so it needs only hdlc control data.
  */
-#define LIGHT_BUF_SIZE (sizeof(uintptr_t) * 18)
+#define LIGHT_BUF_SIZE HDLC_LL_DATA_SIZE
+
+#ifndef LIGHT_TX_BLOCK_SIZE
+#if defined(ARDUINO)
+#define LIGHT_TX_BLOCK_SIZE 8
+#else
+/**
+ * Size of staging buffer for outgoing data. Encoded frame is passed to write_func()
+ * in blocks of this size. Can be redefined in compilation flags.
+ */
+#define LIGHT_TX_BLOCK_SIZE 64
+#endif
+#endif
+
+#ifndef LIGHT_RX_BLOCK_SIZE
+#if defined(ARDUINO)
+// Arduino Stream::readBytes() waits until all requested bytes are received, so read byte by byte
+#define LIGHT_RX_BLOCK_SIZE 1
+#else
+/**
+ * Size of buffer for incoming data. read_func() is requested to read up to this number of bytes,
+ * and bytes left after the end of received frame are kept for the next tiny_light_read() call.
+ * Can be redefined in compilation flags.
+ */
+#define LIGHT_RX_BLOCK_SIZE 64
+#endif
+#endif
 
     /**
      * This structure contains information about communication channel and its state.
@@ -73,11 +100,17 @@ extern "C"
         hdlc_ll_handle_t _hdlc;
         int rx_len;
         TINY_ALIGNED_STRUCT uint8_t buffer[LIGHT_BUF_SIZE];
+        uint8_t tx_block[LIGHT_TX_BLOCK_SIZE];
+        uint8_t rx_block[LIGHT_RX_BLOCK_SIZE];
+        int rx_block_pos;
+        int rx_block_len;
 #endif
         /// user-specific data
         void *user_data;
         /// CRC type to use
         hdlc_crc_t crc_type;
+        /// Framing to use on the line
+        hdlc_framing_t framing;
     } STinyLightData;
 
     /**
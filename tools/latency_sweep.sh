@@ -0,0 +1,50 @@
+#!/bin/sh
+#
+# Runs tiny_loopback latency test for different payload sizes and crc types.
+#
+#   latency_sweep.sh [<port> <remote port>]
+#
+# tiny_loopback on <remote port> echoes the frames back, and tiny_loopback on <port> measures
+# round-trip time. Both ports can be the ends of real serial link, connected to the same host.
+# If ports are not specified, pty pair is created with socat, like tools/create_vsock.sh does.
+#
+# Environment:
+#   TINY_LOOPBACK  path to tiny_loopback (bld/tiny_loopback by default)
+#   SIZES          payload sizes to sweep ("32 64 128 256 512 1024" by default)
+#   CRCS           crc types to sweep ("8 16 32 32c" by default)
+#   COUNT          number of pings per run (1000 by default)
+
+set -e
+
+TINY_LOOPBACK=${TINY_LOOPBACK:-bld/tiny_loopback}
+SIZES=${SIZES:-"32 64 128 256 512 1024"}
+CRCS=${CRCS:-"8 16 32 32c"}
+COUNT=${COUNT:-1000}
+
+if [ $# -ge 2 ]; then
+    PORT=$1
+    REMOTE=$2
+else
+    PORT=/tmp/tiny_latency_a
+    REMOTE=/tmp/tiny_latency_b
+    socat pty,raw,echo=0,link=$PORT pty,raw,echo=0,link=$REMOTE &
+    SOCAT_PID=$!
+    trap 'kill $SOCAT_PID' EXIT
+    sleep 1
+fi
+
+printf "%6s %4s %6s %5s %8s %8s %8s %8s %8s\n" size crc count lost p50,us p90,us p99,us p99.9,us max,us
+for crc in $CRCS; do
+    for size in $SIZES; do
+        $TINY_LOOPBACK -p $REMOTE -c $crc -s $size -r >/dev/null 2>&1 &
+        LOOPBACK_PID=$!
+        sleep 0.5
+        $TINY_LOOPBACK -p $PORT -c $crc -s $size -l -n $COUNT 2>/dev/null | \
+            sed -n 's/^latency: size=\(.*\) crc=\(.*\) count=\(.*\) lost=\(.*\) p50=\(.*\) p90=\(.*\) p99=\(.*\) p99.9=\(.*\) max=\(.*\)$/\1 \2 \3 \4 \5 \6 \7 \8 \9/p' | \
+            while read s c n l p50 p90 p99 p999 max; do
+                printf "%6s %4s %6s %5s %8s %8s %8s %8s %8s\n" $s $c $n $l $p50 $p90 $p99 $p999 $max
+            done
+        kill $LOOPBACK_PID 2>/dev/null || true
+        wait $LOOPBACK_PID 2>/dev/null || true
+    done
+done
@@ -0,0 +1,213 @@
+/*
+    Copyright 2022 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    GNU General Public License Usage
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Commercial License Usage
+
+    Licensees holding valid commercial Tiny Protocol licenses may use this file in
+    accordance with the commercial license agreement provided in accordance with
+    the terms contained in a written agreement between you and Alexey Dynda.
+    For further information contact via email on github account.
+*/
+
+#include "sim_channel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#ifdef __linux__
+#include <sys/prctl.h>
+#endif
+
+uint64_t SimClock::s_now = 0;
+static unsigned long s_timerSlack = 0;
+
+SimClock::SimClock()
+{
+    // Start not from zero to catch the code, which treats zero timestamp specially
+    s_now = 1000000000ULL;
+    tiny_set_clock(micros);
+#ifdef __linux__
+    // Virtual time makes protocol poll with zero timeouts, and each zero-timeout wait on
+    // events costs default 50us of timer slack on Linux. Make the polling cheap.
+    s_timerSlack = static_cast<unsigned long>(prctl(PR_GET_TIMERSLACK, 0, 0, 0, 0));
+    prctl(PR_SET_TIMERSLACK, 1UL, 0, 0, 0);
+#endif
+}
+
+SimClock::~SimClock()
+{
+    tiny_set_clock(nullptr);
+#ifdef __linux__
+    prctl(PR_SET_TIMERSLACK, s_timerSlack, 0, 0, 0);
+#endif
+}
+
+uint64_t SimClock::now()
+{
+    return s_now;
+}
+
+void SimClock::advanceTo(uint64_t ns)
+{
+    if ( ns > s_now )
+    {
+        s_now = ns;
+    }
+}
+
+uint64_t SimClock::micros()
+{
+    return s_now / 1000;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////
+
+SimChannel::SimChannel(const SimChannelConfig &config)
+    : m_config(config)
+    , m_byteNs(1000000000ULL * config.bitsPerByte / config.baudrate)
+    , m_random(config.seed ? config.seed : 1)
+{
+    m_bitsToError = nextDistance(m_config.bitErrorRate);
+    m_bytesToBurst = nextDistance(m_config.burstRate);
+}
+
+uint32_t SimChannel::random()
+{
+    // xorshift32 is enough for the error generator and gives the same sequence on all platforms
+    m_random ^= m_random << 13;
+    m_random ^= m_random >> 17;
+    m_random ^= m_random << 5;
+    return m_random;
+}
+
+double SimChannel::nextDistance(double rate)
+{
+    if ( rate <= 0 )
+    {
+        return std::numeric_limits<double>::infinity();
+    }
+    // Distance between independent events is geometrically distributed
+    double u = (random() + 1.0) / 4294967297.0;
+    return std::floor(std::log(u) / std::log1p(-rate));
+}
+
+uint8_t SimChannel::corrupt(uint8_t byte)
+{
+    uint8_t original = byte;
+    m_bitsToError -= 8;
+    while ( m_bitsToError < 0 )
+    {
+        byte ^= static_cast<uint8_t>(1 << (static_cast<int>(m_bitsToError + 8) & 7));
+        m_bitsToError += nextDistance(m_config.bitErrorRate) + 1;
+    }
+    if ( m_burstLeft == 0 && --m_bytesToBurst < 0 )
+    {
+        m_burstLeft = m_config.burstLength;
+        m_bytesToBurst = nextDistance(m_config.burstRate);
+    }
+    if ( m_burstLeft > 0 )
+    {
+        byte ^= static_cast<uint8_t>(random() | 1);
+        m_burstLeft--;
+    }
+    if ( byte != original )
+    {
+        m_corruptedBytes++;
+    }
+    return byte;
+}
+
+int SimChannel::writable() const
+{
+    uint64_t now = SimClock::now();
+    int pending = m_lineFree > now ? static_cast<int>((m_lineFree - now + m_byteNs - 1) / m_byteNs) : 0;
+    return pending < m_config.txBuffer ? m_config.txBuffer - pending : 0;
+}
+
+int SimChannel::write(const void *data, int len)
+{
+    const uint8_t *ptr = static_cast<const uint8_t *>(data);
+    int size = writable();
+    size = len < size ? len : size;
+    if ( size <= 0 )
+    {
+        return 0;
+    }
+    uint64_t now = SimClock::now();
+    if ( m_lineFree > now && !m_runs.empty() )
+    {
+        m_runs.back().count += size;
+    }
+    else
+    {
+        m_lineFree = now;
+        m_runs.push_back(Run{now + m_byteNs + m_config.delayUs * 1000ULL, size});
+    }
+    m_lineFree += size * m_byteNs;
+    if ( m_config.bitErrorRate > 0 || m_config.burstRate > 0 )
+    {
+        for ( int i = 0; i < size; i++ )
+        {
+            m_line.push_back(corrupt(ptr[i]));
+        }
+    }
+    else
+    {
+        m_line.insert(m_line.end(), ptr, ptr + size);
+    }
+    m_sentBytes += size;
+    return size;
+}
+
+void SimChannel::deliver()
+{
+    uint64_t now = SimClock::now();
+    while ( !m_runs.empty() && m_runs.front().arrival <= now )
+    {
+        Run &run = m_runs.front();
+        uint64_t arrived = (now - run.arrival) / m_byteNs + 1;
+        int count = arrived < static_cast<uint64_t>(run.count) ? static_cast<int>(arrived) : run.count;
+        int room = m_config.rxBuffer - static_cast<int>(m_rx.size());
+        int accepted = count < room ? count : room;
+        m_rx.insert(m_rx.end(), m_line.begin(), m_line.begin() + accepted);
+        m_lostBytes += count - accepted;
+        m_line.erase(m_line.begin(), m_line.begin() + count);
+        run.arrival += count * m_byteNs;
+        run.count -= count;
+        if ( run.count == 0 )
+        {
+            m_runs.pop_front();
+        }
+    }
+}
+
+int SimChannel::read(void *data, int len)
+{
+    deliver();
+    int size = len < static_cast<int>(m_rx.size()) ? len : static_cast<int>(m_rx.size());
+    std::copy(m_rx.begin(), m_rx.begin() + size, static_cast<uint8_t *>(data));
+    m_rx.erase(m_rx.begin(), m_rx.begin() + size);
+    return size;
+}
+
+uint64_t SimChannel::nextArrival() const
+{
+    return m_runs.empty() ? std::numeric_limits<uint64_t>::max() : m_runs.front().arrival;
+}
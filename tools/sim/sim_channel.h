@@ -0,0 +1,147 @@
+/*
+    Copyright 2022 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    GNU General Public License Usage
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Commercial License Usage
+
+    Licensees holding valid commercial Tiny Protocol licenses may use this file in
+    accordance with the commercial license agreement provided in accordance with
+    the terms contained in a written agreement between you and Alexey Dynda.
+    For further information contact via email on github account.
+*/
+
+#pragma once
+
+#include "hal/tiny_types.h"
+
+#include <cstdint>
+#include <deque>
+
+/**
+ * Virtual clock for the protocol. While installed, tiny_millis() and tiny_micros()
+ * return virtual time, which moves only when the simulation advances it.
+ */
+class SimClock
+{
+public:
+    SimClock();
+
+    ~SimClock();
+
+    /** Returns current virtual time in nanoseconds */
+    static uint64_t now();
+
+    /** Moves virtual time forward to specified moment in nanoseconds */
+    static void advanceTo(uint64_t ns);
+
+private:
+    static uint64_t s_now;
+
+    static uint64_t micros();
+};
+
+/** Parameters of simulated serial line */
+struct SimChannelConfig
+{
+    uint32_t baudrate = 115200;
+    /** Bits on the line per byte: start bit, 8 data bits and stop bit */
+    int bitsPerByte = 10;
+    /** Propagation delay in microseconds */
+    uint32_t delayUs = 0;
+    /** Probability of single bit error */
+    double bitErrorRate = 0;
+    /** Probability of error burst start per byte */
+    double burstRate = 0;
+    /** Number of bytes corrupted by single burst */
+    int burstLength = 0;
+    /** Size of transmitter buffer: write() accepts only the bytes, which fit it */
+    int txBuffer = 1024;
+    /** Size of receiver buffer: the bytes, which don't fit it, are lost */
+    int rxBuffer = 1024;
+    /** Seed for error generator, the same seed gives the same errors */
+    uint32_t seed = 1;
+};
+
+/**
+ * Single direction serial line, running in virtual time of SimClock.
+ * The bytes are transmitted one by one at configured baudrate, and are available for
+ * read() after propagation delay. No threads are involved, so the results are reproducible.
+ */
+class SimChannel
+{
+public:
+    explicit SimChannel(const SimChannelConfig &config);
+
+    /** Returns number of bytes, which can be written without blocking */
+    int writable() const;
+
+    /** Puts bytes to transmitter buffer, returns number of accepted bytes */
+    int write(const void *data, int len);
+
+    /** Reads the bytes, received by current virtual time */
+    int read(void *data, int len);
+
+    /** Returns virtual time in nanoseconds, when the next byte arrives to receiver, or UINT64_MAX */
+    uint64_t nextArrival() const;
+
+    uint64_t sentBytes() const
+    {
+        return m_sentBytes;
+    }
+
+    uint64_t lostBytes() const
+    {
+        return m_lostBytes;
+    }
+
+    uint64_t corruptedBytes() const
+    {
+        return m_corruptedBytes;
+    }
+
+private:
+    /** Bytes, transmitted back to back, arrive one by one starting from the specified time */
+    struct Run
+    {
+        uint64_t arrival;
+        int count;
+    };
+
+    SimChannelConfig m_config;
+    uint64_t m_byteNs;
+    uint64_t m_lineFree = 0;
+    std::deque<Run> m_runs{};
+    std::deque<uint8_t> m_line{};
+    std::deque<uint8_t> m_rx{};
+    uint32_t m_random;
+    double m_bitsToError = 0;
+    double m_bytesToBurst = 0;
+    int m_burstLeft = 0;
+    uint64_t m_sentBytes = 0;
+    uint64_t m_lostBytes = 0;
+    uint64_t m_corruptedBytes = 0;
+
+    uint32_t random();
+
+    double nextDistance(double rate);
+
+    uint8_t corrupt(uint8_t byte);
+
+    void deliver();
+};
@@ -0,0 +1,149 @@
+/*
+    Copyright 2022 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    GNU General Public License Usage
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Commercial License Usage
+
+    Licensees holding valid commercial Tiny Protocol licenses may use this file in
+    accordance with the commercial license agreement provided in accordance with
+    the terms contained in a written agreement between you and Alexey Dynda.
+    For further information contact via email on github account.
+*/
+
+#include "sim_probe.h"
+
+#include <algorithm>
+#include <string.h>
+#include <vector>
+
+namespace
+{
+struct ProbePeer
+{
+    tiny_fd_handle_t handle = nullptr;
+    SimChannel *tx = nullptr;
+    SimChannel *rx = nullptr;
+    uint64_t received = 0;
+    std::vector<uint32_t> latencies;
+    std::vector<uint8_t> buffer;
+};
+} // namespace
+
+static void onProbeRead(void *udata, uint8_t addr, uint8_t *buf, int len)
+{
+    ProbePeer *peer = static_cast<ProbePeer *>(udata);
+    uint64_t sentAt;
+    memcpy(&sentAt, buf, sizeof(sentAt));
+    peer->received += len;
+    peer->latencies.push_back(static_cast<uint32_t>((SimClock::now() - sentAt) / 1000));
+}
+
+bool simProbe(void *arg, const tinyproto::LinkTunerParams &params, tinyproto::LinkTunerResult &result)
+{
+    const SimProbeConfig &config = *static_cast<SimProbeConfig *>(arg);
+    SimClock clock;
+    SimChannel ab(config.channel);
+    SimChannel ba(config.channel);
+    ProbePeer peers[2];
+    peers[0].tx = &ab;
+    peers[0].rx = &ba;
+    peers[1].tx = &ba;
+    peers[1].rx = &ab;
+    bool ok = true;
+    for ( auto &peer : peers )
+    {
+        tiny_fd_init_t init{};
+        init.pdata = &peer;
+        init.on_read_cb = onProbeRead;
+        init.window_frames = params.window;
+        init.mtu = params.mtu;
+        init.crc_type = params.crc;
+        init.send_timeout = 0;
+        init.retry_timeout = params.retryTimeout ? params.retryTimeout : 100;
+        init.retries = 3;
+        peer.buffer.resize(tiny_fd_buffer_size_by_mtu_ex(1, params.mtu, params.window, params.crc, 1));
+        init.buffer = peer.buffer.data();
+        init.buffer_size = static_cast<int>(peer.buffer.size());
+        ok = ok && tiny_fd_init(&peer.handle, &init) == TINY_SUCCESS;
+    }
+    // Each message carries virtual time, when it is queued, to measure delivery time
+    int size = config.messageSize && config.messageSize < params.mtu ? config.messageSize : params.mtu;
+    size = size < static_cast<int>(sizeof(uint64_t)) ? static_cast<int>(sizeof(uint64_t)) : size;
+    std::vector<uint8_t> payload(size);
+    for ( int i = 0; i < size; i++ )
+    {
+        payload[i] = static_cast<uint8_t>(i);
+    }
+    const uint64_t start = SimClock::now();
+    const uint64_t end = start + config.durationMs * 1000000ULL;
+    uint64_t sent = 0;
+    while ( ok && SimClock::now() < end )
+    {
+        for ( ;; )
+        {
+            if ( config.rate && sent >= config.rate * (SimClock::now() - start) / 1000000000ULL )
+            {
+                break;
+            }
+            uint64_t now = SimClock::now();
+            memcpy(payload.data(), &now, sizeof(now));
+            if ( tiny_fd_send_packet(peers[0].handle, payload.data(), size, 0) != TINY_SUCCESS )
+            {
+                break;
+            }
+            sent += size;
+        }
+        for ( auto &peer : peers )
+        {
+            uint8_t buf[256];
+            int len;
+            while ( (len = peer.tx->writable()) > 0 &&
+                    (len = tiny_fd_get_tx_data(peer.handle, buf, len < (int)sizeof(buf) ? len : (int)sizeof(buf), 0)) > 0 )
+            {
+                peer.tx->write(buf, len);
+            }
+            while ( (len = peer.rx->read(buf, sizeof(buf))) > 0 )
+            {
+                tiny_fd_on_rx_data(peer.handle, buf, len);
+            }
+        }
+        // Process the line in 50us slices, and skip idle time up to the next byte arrival
+        uint64_t next = ab.nextArrival() < ba.nextArrival() ? ab.nextArrival() : ba.nextArrival();
+        uint64_t slice = SimClock::now() + 50000;
+        uint64_t idle = SimClock::now() + 1000000;
+        SimClock::advanceTo(next < slice ? slice : (next < idle ? next : idle));
+    }
+    std::vector<uint32_t> &latencies = peers[1].latencies;
+    ok = ok && !latencies.empty();
+    if ( ok )
+    {
+        result.goodput = static_cast<uint32_t>(peers[1].received * 1000 / config.durationMs);
+        auto p99 = latencies.begin() + latencies.size() * 99 / 100;
+        std::nth_element(latencies.begin(), p99, latencies.end());
+        result.latencyP99 = *p99;
+    }
+    for ( auto &peer : peers )
+    {
+        if ( peer.handle )
+        {
+            tiny_fd_close(peer.handle);
+        }
+    }
+    return ok;
+}
@@ -0,0 +1,50 @@
+/*
+    Copyright 2022 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    GNU General Public License Usage
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Commercial License Usage
+
+    Licensees holding valid commercial Tiny Protocol licenses may use this file in
+    accordance with the commercial license agreement provided in accordance with
+    the terms contained in a written agreement between you and Alexey Dynda.
+    For further information contact via email on github account.
+*/
+
+#pragma once
+
+#include "sim_channel.h"
+#include "TinyLinkTuner.h"
+
+/** Traffic, which is run over simulated link by simProbe() */
+struct SimProbeConfig
+{
+    SimChannelConfig channel;
+    /** Virtual time of single probe in milliseconds */
+    uint32_t durationMs = 1000;
+    /** Message size in bytes, 0 means mtu. Messages larger than mtu are cut to mtu */
+    int messageSize = 0;
+    /** Offered load in bytes per second, 0 means unpaced sender */
+    uint32_t rate = 0;
+};
+
+/**
+ * LinkTuner probe, which runs one-way traffic between two tiny_fd stations over a pair of
+ * SimChannel lines in virtual time. arg must point to SimProbeConfig.
+ */
+bool simProbe(void *arg, const tinyproto::LinkTunerParams &params, tinyproto::LinkTunerResult &result);
@@ -0,0 +1,121 @@
+/*
+    Copyright 2022 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    GNU General Public License Usage
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Commercial License Usage
+
+    Licensees holding valid commercial Tiny Protocol licenses may use this file in
+    accordance with the commercial license agreement provided in accordance with
+    the terms contained in a written agreement between you and Alexey Dynda.
+    For further information contact via email on github account.
+*/
+
+#include <CppUTest/TestHarness.h>
+#include <thread>
+#include <chrono>
+#include "helpers/fake_connection.h"
+#include "TinyFdEngine.h"
+
+struct FakeTransport
+{
+    FakeEndpoint *endpoint = nullptr;
+    int rx_count = 0;
+    bool connected = false;
+
+    int read(void *buf, int len)
+    {
+        return endpoint->read_available(static_cast<uint8_t *>(buf), len);
+    }
+
+    int write(const void *buf, int len)
+    {
+        return endpoint->write(static_cast<const uint8_t *>(buf), len);
+    }
+
+    void onReceive(uint8_t addr, uint8_t *data, int len)
+    {
+        rx_count++;
+    }
+
+    void onConnectEvent(uint8_t addr, bool connected)
+    {
+        this->connected = connected;
+    }
+};
+
+using TestEngine = tinyproto::FdEngine<64, 4, HDLC_CRC_16, FakeTransport>;
+
+TEST_GROUP(FD_ENGINE){void setup(){} void teardown(){}};
+
+TEST(FD_ENGINE, buffer_size)
+{
+    // Engine buffer is aligned, so it doesn't need padding
+    tiny_fd_init_t init{};
+    tiny_fd_layout_t layout{};
+    init.mtu = 64;
+    init.window_frames = 4;
+    init.crc_type = HDLC_CRC_16;
+    CHECK_EQUAL(tiny_fd_get_layout(&init, &layout) - layout.padding, +TestEngine::BUFFER_SIZE);
+    CHECK_EQUAL(layout.rx_ring, +TestEngine::RX_RING_SIZE);
+    CHECK_EQUAL(layout.i_queue, +TestEngine::I_QUEUE_SIZE);
+    init.mtu = 256;
+    init.window_frames = 7;
+    init.crc_type = HDLC_CRC_32;
+    CHECK_EQUAL(tiny_fd_buffer_size_by_mtu_ex(1, 256, 7, HDLC_CRC_32, 1),
+                (tinyproto::FdEngine<256, 7, HDLC_CRC_32, FakeTransport>::BUFFER_SIZE) + layout.padding);
+    CHECK_EQUAL(tiny_fd_get_layout(&init, nullptr),
+                (tinyproto::FdEngine<256, 7, HDLC_CRC_32, FakeTransport>::BUFFER_SIZE) + layout.padding);
+}
+
+TEST(FD_ENGINE, send_receive)
+{
+    FakeSetup conn;
+    TestEngine engine1;
+    TestEngine engine2;
+    engine1.transport().endpoint = &conn.endpoint1();
+    engine2.transport().endpoint = &conn.endpoint2();
+    engine1.setSendTimeout(0);
+    engine2.setSendTimeout(0);
+    CHECK_EQUAL(TINY_SUCCESS, engine1.begin());
+    CHECK_EQUAL(TINY_SUCCESS, engine2.begin());
+    auto step = [&]() {
+        engine1.run_tx();
+        engine2.run_tx();
+        engine1.run_rx();
+        engine2.run_rx();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    };
+    for ( int i = 0; i < 1000 && !(engine1.transport().connected && engine2.transport().connected); i++ )
+    {
+        step();
+    }
+    CHECK(engine1.transport().connected);
+    CHECK(engine2.transport().connected);
+    uint8_t payload[64]{};
+    int sent = 0;
+    for ( int i = 0; i < 2000 && engine2.transport().rx_count < 20; i++ )
+    {
+        if ( sent < 20 && engine1.write(payload, sizeof(payload)) == TINY_SUCCESS )
+        {
+            sent++;
+        }
+        step();
+    }
+    CHECK_EQUAL(20, engine2.transport().rx_count);
+}
@@ -32,6 +32,9 @@
 #include <stdio.h>
 #include <string.h>
 #include <thread>
+#include <atomic>
+#include <mutex>
+#include <vector>
 #include "helpers/tiny_fd_helper.h"
 #include "helpers/fake_connection.h"
 
@@ -201,6 +204,63 @@ TEST(FD, error_on_rej)
     CHECK_EQUAL(2, helper1.rx_count());
 }
 
+TEST(FD, stats_counters)
+{
+    FakeSetup conn;
+    TinyHelperFd helper1(&conn.endpoint1(), 4096, nullptr, 7, 1000);
+    TinyHelperFd helper2(&conn.endpoint2(), 4096, nullptr, 7, 1000);
+    conn.line2().generate_single_error(6 + 6 + 3); // Put error on I-frame
+    helper1.run(true);
+    helper2.run(true);
+    for ( int nsent = 0; nsent < 2; nsent++ )
+    {
+        uint8_t txbuf[4] = {0xAA, 0xFF, 0xCC, 0x66};
+        CHECK_EQUAL(TINY_SUCCESS, helper2.send(txbuf, sizeof(txbuf)));
+    }
+    helper1.wait_until_rx_count(2, 500);
+    helper1.stop();
+    helper2.stop();
+    tiny_fd_stats_t rx = helper1.stats();
+    tiny_fd_stats_t tx = helper2.stats();
+    CHECK_EQUAL(2, rx.rx_i_frames);
+    CHECK_EQUAL(8, rx.rx_bytes);
+    CHECK_EQUAL(1, rx.crc_errors);
+    CHECK(tx.retransmissions >= 1);
+    CHECK_EQUAL(tx.tx_i_frames, 2 + tx.retransmissions);
+    CHECK_EQUAL(tx.tx_bytes, 4 * tx.tx_i_frames);
+    helper1.reset_stats();
+    CHECK_EQUAL(0, helper1.stats().rx_i_frames);
+}
+
+TEST(FD, adaptive_mtu_and_window_on_lossy_line)
+{
+    FakeSetup conn;
+    const int mtu = 128;
+    const int size = tiny_fd_buffer_size_by_mtu_ex(1, mtu, 7, HDLC_CRC_16, 1);
+    TinyHelperFd helper1(&conn.endpoint1(), size, TINY_FD_MODE_ABM, nullptr);
+    TinyHelperFd helper2(&conn.endpoint2(), size, TINY_FD_MODE_ABM, nullptr);
+    helper1.setTimeout(1000);
+    helper2.setTimeout(1000);
+    helper2.setAdaptive(true);
+    CHECK_EQUAL(TINY_SUCCESS, helper1.init());
+    CHECK_EQUAL(TINY_SUCCESS, helper2.init());
+    // Error every 300 bytes corrupts about every second full-size I-frame
+    conn.line2().generate_error(300, 300);
+    helper1.run(true);
+    helper2.run(true);
+
+    uint8_t txbuf[mtu * 4]{};
+    int adaptive_mtu = helper2.mtu();
+    int adaptive_window = 7;
+    for ( int i = 0; i < 50 && adaptive_mtu == helper2.mtu(); i++ )
+    {
+        helper2.send_data(txbuf, sizeof(txbuf));
+        helper2.adaptive_params(&adaptive_mtu, &adaptive_window);
+    }
+    CHECK(adaptive_mtu < helper2.mtu());
+    CHECK(adaptive_window < 7);
+}
+
 TEST(FD, no_ka_switch_to_disconnected)
 {
     FakeSetup conn(32, 32);
@@ -287,6 +347,51 @@ TEST(FD, connecting_in_different_time)
     CHECK_EQUAL(1, helper2.rx_count());
 }
 
+TEST(FD, restarted_remote_side_reconnects)
+{
+    FakeSetup conn;
+    std::mutex events_lock;
+    std::vector<bool> events;
+    TinyHelperFd helper1(&conn.endpoint1(), 4096, nullptr, 7, 250);
+    helper1.set_connect_cb( [&events, &events_lock](uint8_t addr, bool result) -> void {
+        std::lock_guard<std::mutex> guard(events_lock);
+        events.push_back(result);
+    } );
+    uint8_t txbuf[4] = {0xAA, 0xFF, 0xCC, 0x66};
+    helper1.run(true);
+    {
+        TinyHelperFd helper2(&conn.endpoint2(), 4096, nullptr, 7, 250);
+        helper2.run(true);
+        for ( int i = 0; i < 3; i++ )
+        {
+            CHECK_EQUAL(TINY_SUCCESS, helper2.send(txbuf, sizeof(txbuf)));
+        }
+        helper1.wait_until_rx_count(3, 250);
+        CHECK_EQUAL(3, helper1.rx_count());
+        helper2.stop();
+    }
+    size_t restart_event = 0;
+    {
+        std::lock_guard<std::mutex> guard(events_lock);
+        restart_event = events.size();
+    }
+    // The frame is not confirmed by stopped remote side, so it stays in the queue
+    CHECK_EQUAL(TINY_SUCCESS, helper1.send(txbuf, sizeof(txbuf)));
+    // New remote instance starts from zero sequence numbers, while local side is still connected
+    TinyHelperFd helper2(&conn.endpoint2(), 4096, nullptr, 7, 250);
+    helper2.run(true);
+    CHECK_EQUAL(TINY_SUCCESS, helper2.send(txbuf, sizeof(txbuf)));
+    helper1.wait_until_rx_count(4, 250);
+    CHECK_EQUAL(4, helper1.rx_count());
+    helper2.wait_until_rx_count(1, 250);
+    CHECK_EQUAL(1, helper2.rx_count());
+    // Restart is reported as disconnect followed by connect
+    std::lock_guard<std::mutex> guard(events_lock);
+    CHECK(events.size() >= restart_event + 2);
+    CHECK_EQUAL(false, events[restart_event]);
+    CHECK_EQUAL(true, events.back());
+}
+
 TEST(FD, on_connect_callback)
 {
     FakeSetup conn;
@@ -315,3 +420,537 @@ TEST(FD, on_connect_callback)
     }
     CHECK_EQUAL(false, connected);
 }
+
+TEST(FD, send_data_larger_than_mtu)
+{
+    FakeSetup conn;
+    uint8_t rxbuf[1000]{};
+    std::atomic<int> rxlen{0};
+    TinyHelperFd helper1(&conn.endpoint1(), 1024,
+                         [&rxbuf, &rxlen](uint8_t addr, uint8_t *buf, int len) -> void {
+                             if ( rxlen + len <= (int)sizeof(rxbuf) )
+                                 memcpy(rxbuf + rxlen, buf, len);
+                             rxlen += len;
+                         },
+                         4, 250);
+    TinyHelperFd helper2(&conn.endpoint2(), 1024, nullptr, 4, 250);
+    helper1.run(true);
+    helper2.run(true);
+
+    uint8_t txbuf[1000];
+    for ( int i = 0; i < (int)sizeof(txbuf); i++ )
+    {
+        txbuf[i] = (uint8_t)i;
+    }
+    // The data are split to several frames of mtu size
+    CHECK_EQUAL((int)sizeof(txbuf), helper2.send_data(txbuf, sizeof(txbuf)));
+    for ( int i = 0; i < 500 && rxlen < (int)sizeof(txbuf); i++ )
+    {
+        tiny_sleep(1);
+    }
+    CHECK_EQUAL((int)sizeof(txbuf), rxlen.load());
+    CHECK(helper1.rx_count() > 1);
+    MEMCMP_EQUAL(txbuf, rxbuf, sizeof(txbuf));
+}
+
+TEST(FD, aggregation_of_small_messages)
+{
+    FakeSetup conn;
+    int errors = 0;
+    TinyHelperFd helper1(&conn.endpoint1(), 4096, TINY_FD_MODE_ABM,
+                         [&errors](uint8_t addr, uint8_t *buf, int len) -> void {
+                             if ( len != 4 || buf[0] != 0xAA || buf[3] != 0x66 )
+                                 errors++;
+                         });
+    TinyHelperFd helper2(&conn.endpoint2(), 4096, TINY_FD_MODE_ABM, nullptr);
+    helper1.setTimeout(250);
+    helper2.setTimeout(250);
+    helper1.enableAggregation(5);
+    helper2.enableAggregation(5);
+    CHECK_EQUAL(TINY_SUCCESS, helper1.init());
+    CHECK_EQUAL(TINY_SUCCESS, helper2.init());
+    helper1.run(true);
+    helper2.run(true);
+
+    // sent 200 small packets, several messages are packed to the same I-frame
+    for ( int nsent = 0; nsent < 200; nsent++ )
+    {
+        uint8_t txbuf[4] = {0xAA, 0xFF, 0xCC, 0x66};
+        int result = helper2.send(txbuf, sizeof(txbuf));
+        CHECK_EQUAL(TINY_SUCCESS, result);
+    }
+    // wait until last message arrives
+    helper1.wait_until_rx_count(200, 500);
+    CHECK_EQUAL(200, helper1.rx_count());
+    CHECK_EQUAL(0, errors);
+    // Every frame starts with a flag, so less flags than messages means that messages were packed
+    CHECK(conn.line2().flags() < 200);
+}
+
+TEST(FD, negotiation_selects_common_mtu_and_window)
+{
+    FakeSetup conn;
+    int errors = 0;
+    int size = 0;
+    const int small = tiny_fd_buffer_size_by_mtu_ex(1, 32, 3, HDLC_CRC_16, 1);
+    const int large = tiny_fd_buffer_size_by_mtu_ex(1, 128, 7, HDLC_CRC_16, 1);
+    TinyHelperFd helper1(&conn.endpoint1(), small,
+                         [&errors, &size](uint8_t addr, uint8_t *buf, int len) -> void {
+                             if ( len != size )
+                                 errors++;
+                         },
+                         3, 250);
+    TinyHelperFd helper2(&conn.endpoint2(), large, nullptr, 7, 250);
+    helper1.enableNegotiation();
+    helper2.enableNegotiation();
+    CHECK_EQUAL(TINY_SUCCESS, helper1.init());
+    CHECK_EQUAL(TINY_SUCCESS, helper2.init());
+    // mtu, calculated by the buffer size, can be slightly larger due to alignment
+    size = helper1.mtu();
+    CHECK(size >= 32 && size < 128);
+    CHECK(helper2.mtu() >= 128);
+    helper1.run(true);
+    helper2.run(true);
+
+    uint8_t txbuf[128]{};
+    // Wait until connection is established
+    CHECK_EQUAL(TINY_SUCCESS, helper2.send(txbuf, size));
+    int mtu = 0;
+    int window = 0;
+    CHECK_EQUAL(TINY_SUCCESS, helper2.negotiated_params(&mtu, &window, nullptr));
+    CHECK_EQUAL(size, mtu);
+    CHECK_EQUAL(3, window);
+    // Remote side cannot receive the frame, so it is rejected instead of being silently dropped
+    CHECK_EQUAL(TINY_ERR_DATA_TOO_LARGE, helper2.send(txbuf, size + 1));
+    for ( int nsent = 1; nsent < 20; nsent++ )
+    {
+        CHECK_EQUAL(TINY_SUCCESS, helper2.send(txbuf, size));
+    }
+    helper1.wait_until_rx_count(20, 500);
+    CHECK_EQUAL(20, helper1.rx_count());
+    CHECK_EQUAL(0, errors);
+}
+
+TEST(FD, negotiation_with_station_without_xid_support)
+{
+    FakeSetup conn;
+    TinyHelperFd helper1(&conn.endpoint1(), 4096, TINY_FD_MODE_ABM, nullptr);
+    TinyHelperFd helper2(&conn.endpoint2(), 4096, TINY_FD_MODE_ABM, nullptr);
+    helper1.setTimeout(250);
+    helper2.setTimeout(250);
+    // Remote side doesn't send XID, so configured values, including aggregation, are kept
+    helper1.enableAggregation(5);
+    helper2.enableAggregation(5);
+    helper2.enableNegotiation();
+    CHECK_EQUAL(TINY_SUCCESS, helper1.init());
+    CHECK_EQUAL(TINY_SUCCESS, helper2.init());
+    helper1.run(true);
+    helper2.run(true);
+
+    uint8_t txbuf[4] = {0xAA, 0xFF, 0xCC, 0x66};
+    // Wait until connection is established
+    CHECK_EQUAL(TINY_SUCCESS, helper2.send(txbuf, sizeof(txbuf)));
+    helper1.wait_until_rx_count(1, 500);
+    CHECK_EQUAL(1, helper1.rx_count());
+    int mtu = 0;
+    bool aggregation = false;
+    CHECK_EQUAL(TINY_SUCCESS, helper2.negotiated_params(&mtu, nullptr, &aggregation));
+    CHECK_EQUAL(helper2.mtu(), mtu);
+    CHECK_TRUE(aggregation);
+}
+
+TEST(FD, negotiation_disables_aggregation_unsupported_by_remote)
+{
+    FakeSetup conn;
+    int errors = 0;
+    TinyHelperFd helper1(&conn.endpoint1(), 4096, TINY_FD_MODE_ABM,
+                         [&errors](uint8_t addr, uint8_t *buf, int len) -> void {
+                             if ( len != 4 || buf[0] != 0xAA || buf[3] != 0x66 )
+                                 errors++;
+                         });
+    TinyHelperFd helper2(&conn.endpoint2(), 4096, TINY_FD_MODE_ABM, nullptr);
+    helper1.setTimeout(250);
+    helper2.setTimeout(250);
+    helper2.enableAggregation(5);
+    helper1.enableNegotiation();
+    helper2.enableNegotiation();
+    CHECK_EQUAL(TINY_SUCCESS, helper1.init());
+    CHECK_EQUAL(TINY_SUCCESS, helper2.init());
+    helper1.run(true);
+    helper2.run(true);
+
+    for ( int nsent = 0; nsent < 50; nsent++ )
+    {
+        uint8_t txbuf[4] = {0xAA, 0xFF, 0xCC, 0x66};
+        CHECK_EQUAL(TINY_SUCCESS, helper2.send(txbuf, sizeof(txbuf)));
+    }
+    helper1.wait_until_rx_count(50, 500);
+    CHECK_EQUAL(50, helper1.rx_count());
+    CHECK_EQUAL(0, errors);
+    bool aggregation = true;
+    CHECK_EQUAL(TINY_SUCCESS, helper2.negotiated_params(nullptr, nullptr, &aggregation));
+    CHECK_FALSE(aggregation);
+}
+
+TEST(FD, negotiation_limits_mtu_to_xid_field)
+{
+    FakeSetup conn;
+    // mtu above 64 KiB doesn't fit XID field, so the stations agree on the largest value, which fits
+    const int size = tiny_fd_buffer_size_by_mtu_ex(1, 70000, 2, HDLC_CRC_16, 1);
+    TinyHelperFd helper1(&conn.endpoint1(), size, nullptr, 2, 250);
+    TinyHelperFd helper2(&conn.endpoint2(), size, nullptr, 2, 250);
+    helper1.enableNegotiation();
+    helper2.enableNegotiation();
+    CHECK_EQUAL(TINY_SUCCESS, helper1.init());
+    CHECK_EQUAL(TINY_SUCCESS, helper2.init());
+    helper1.run(true);
+    helper2.run(true);
+
+    uint8_t txbuf[4] = {0xAA, 0xFF, 0xCC, 0x66};
+    // Wait until connection is established
+    CHECK_EQUAL(TINY_SUCCESS, helper2.send(txbuf, sizeof(txbuf)));
+    int mtu = 0;
+    CHECK_EQUAL(TINY_SUCCESS, helper2.negotiated_params(&mtu, nullptr, nullptr));
+    CHECK_EQUAL(0xFFFF, mtu);
+}
+
+TEST(FD, next_deadline_and_tx_ready_notification)
+{
+    uint8_t buffer1[1024], buffer2[1024];
+    tiny_fd_handle_t handle1 = nullptr, handle2 = nullptr;
+    int notifications = 0;
+    tiny_fd_init_t init{};
+    init.on_read_cb = [](void *, uint8_t, uint8_t *, int) -> void {};
+    init.window_frames = 3;
+    init.send_timeout = 1000;
+    init.retry_timeout = 100;
+    init.retries = 2;
+    init.crc_type = HDLC_CRC_16;
+    init.buffer = buffer1;
+    init.buffer_size = sizeof(buffer1);
+    CHECK_EQUAL(TINY_SUCCESS, tiny_fd_init(&handle1, &init));
+    init.buffer = buffer2;
+    init.buffer_size = sizeof(buffer2);
+    CHECK_EQUAL(TINY_SUCCESS, tiny_fd_init(&handle2, &init));
+    tiny_fd_set_tx_ready_cb(handle2, [](void *arg) -> void { (*static_cast<int *>(arg))++; }, &notifications);
+
+    // Connection request must be sent immediately
+    CHECK_EQUAL(0, tiny_fd_get_next_deadline(handle1));
+    uint8_t data[32];
+    int len = tiny_fd_get_tx_data(handle1, data, sizeof(data), 0);
+    CHECK(len > 0);
+    // Next connection attempt will be made after retry timeout
+    uint32_t deadline = tiny_fd_get_next_deadline(handle1);
+    CHECK(deadline > 0 && deadline <= 100);
+    // Remote side must notify about UA frame to send
+    tiny_fd_on_rx_data(handle2, data, len);
+    CHECK(notifications > 0);
+    CHECK_EQUAL(0, tiny_fd_get_next_deadline(handle2));
+    len = tiny_fd_get_tx_data(handle2, data, sizeof(data), 0);
+    CHECK(len > 0);
+    tiny_fd_on_rx_data(handle1, data, len);
+    CHECK_EQUAL(TINY_SUCCESS, tiny_fd_get_status(handle1));
+    // Nothing to send, only keep alive timer is active for connected idle station
+    CHECK_EQUAL(0, tiny_fd_get_tx_data(handle1, data, sizeof(data), 0));
+    deadline = tiny_fd_get_next_deadline(handle1);
+    CHECK(deadline > 100 && deadline <= 5001);
+    tiny_fd_close(handle1);
+    tiny_fd_close(handle2);
+}
+
+TEST(FD, timer_wheel_drives_retries)
+{
+    uint8_t buffer1[1024], buffer2[1024];
+    tiny_fd_handle_t handle1 = nullptr, handle2 = nullptr;
+    int notifications = 0;
+    int received = 0;
+    // The wheel runs on virtual time, so the protocol must not read the clock
+    const uint32_t start = 1000;
+    tiny_timer_wheel_t wheel;
+    tiny_timer_wheel_init(&wheel, start);
+    tiny_fd_init_t init{};
+    init.on_read_cb = [](void *udata, uint8_t, uint8_t *, int) -> void { (*static_cast<int *>(udata))++; };
+    init.pdata = &received;
+    init.window_frames = 3;
+    init.send_timeout = 1000;
+    init.retry_timeout = 100;
+    init.retries = 2;
+    init.crc_type = HDLC_CRC_16;
+    init.timer_wheel = &wheel;
+    init.buffer = buffer1;
+    init.buffer_size = sizeof(buffer1);
+    CHECK_EQUAL(TINY_SUCCESS, tiny_fd_init(&handle1, &init));
+    init.buffer = buffer2;
+    init.buffer_size = sizeof(buffer2);
+    CHECK_EQUAL(TINY_SUCCESS, tiny_fd_init(&handle2, &init));
+    tiny_fd_set_tx_ready_cb(handle1, [](void *arg) -> void { (*static_cast<int *>(arg))++; }, &notifications);
+    uint8_t data[32];
+    auto transfer = [&](tiny_fd_handle_t from, tiny_fd_handle_t to) -> int {
+        int len = tiny_fd_get_tx_data(from, data, sizeof(data), 0);
+        if ( len > 0 )
+        {
+            tiny_fd_on_rx_data(to, data, len);
+        }
+        return len;
+    };
+
+    // Connection request and response
+    CHECK(transfer(handle1, handle2) > 0);
+    CHECK(transfer(handle2, handle1) > 0);
+    CHECK_EQUAL(TINY_SUCCESS, tiny_fd_get_status(handle1));
+    // Keep alive timer of the connected peer is registered in the wheel
+    CHECK(tiny_timer_wheel_next_expiry(&wheel) != 0xFFFFFFFF);
+
+    // I-frame is lost on the line
+    CHECK_EQUAL(TINY_SUCCESS, tiny_fd_send_packet(handle1, "hello", 5, 0));
+    CHECK(tiny_fd_get_tx_data(handle1, data, sizeof(data), 0) > 0);
+    CHECK_EQUAL(0, tiny_fd_get_tx_data(handle1, data, sizeof(data), 0));
+    // Retry timer doesn't expire before retry timeout of the wheel time
+    notifications = 0;
+    tiny_timer_wheel_advance(&wheel, start + 99);
+    CHECK_EQUAL(0, notifications);
+    CHECK_EQUAL(0, tiny_fd_get_tx_data(handle1, data, sizeof(data), 0));
+    // Expired timer wakes up tx path, which resends the frame
+    tiny_timer_wheel_advance(&wheel, start + 100);
+    CHECK(notifications > 0);
+    CHECK(transfer(handle1, handle2) > 0);
+    CHECK_EQUAL(1, received);
+
+    tiny_fd_close(handle1);
+    tiny_fd_close(handle2);
+    CHECK_EQUAL(0xFFFFFFFF, tiny_timer_wheel_next_expiry(&wheel));
+}
+
+TEST(FD, exact_buffer_layout)
+{
+    tiny_fd_init_t init{};
+    init.on_read_cb = [](void *, uint8_t, uint8_t *, int) -> void {};
+    init.window_frames = 3;
+    // mtu is not multiple of the word size, frame slots are aligned by the protocol
+    init.mtu = 61;
+    init.send_timeout = 1000;
+    init.crc_type = HDLC_CRC_16;
+    tiny_fd_layout_t layout{};
+    int size = tiny_fd_get_layout(&init, &layout);
+    CHECK_EQUAL(size, tiny_fd_buffer_size_by_mtu_ex(1, 61, 3, HDLC_CRC_16, 1));
+    CHECK_EQUAL(size, (int)TINY_FD_BUF_SIZE_EX(1, 61, 3, HDLC_CRC_16, 1));
+    CHECK_EQUAL(size, layout.fd_data + layout.i_queue + layout.s_queue + layout.peers + layout.rx_ring + layout.padding);
+
+    TINY_ALIGNED_STRUCT uint8_t buffer[2048];
+    tiny_fd_handle_t handle = nullptr;
+    // Aligned buffer doesn't need padding
+    init.buffer = buffer;
+    init.buffer_size = size - layout.padding;
+    CHECK_EQUAL(TINY_SUCCESS, tiny_fd_init(&handle, &init));
+    tiny_fd_close(handle);
+    init.buffer_size = size - layout.padding - 1;
+    CHECK_EQUAL(TINY_ERR_OUT_OF_MEMORY, tiny_fd_init(&handle, &init));
+    // Unaligned buffer of calculated size is always enough
+    init.buffer = buffer + 1;
+    init.buffer_size = size;
+    CHECK_EQUAL(TINY_SUCCESS, tiny_fd_init(&handle, &init));
+    tiny_fd_close(handle);
+    // Automatically calculated mtu is the largest, which fits the buffer
+    init.buffer = buffer;
+    init.buffer_size = size - layout.padding;
+    init.mtu = 0;
+    CHECK_EQUAL(TINY_SUCCESS, tiny_fd_init(&handle, &init));
+    init.mtu = tiny_fd_get_mtu(handle) + 1;
+    CHECK(tiny_fd_get_layout(&init, nullptr) - layout.padding > size - layout.padding);
+    tiny_fd_close(handle);
+}
+
+TEST(FD, tx_ring_layout)
+{
+    tiny_fd_init_t init{};
+    init.on_read_cb = [](void *, uint8_t, uint8_t *, int) -> void {};
+    init.window_frames = 7;
+    init.mtu = 256;
+    init.send_timeout = 1000;
+    init.crc_type = HDLC_CRC_16;
+    tiny_fd_layout_t slots{};
+    tiny_fd_layout_t ring{};
+    tiny_fd_get_layout(&init, &slots);
+    init.tx_ring_size = 512;
+    int size = tiny_fd_get_layout(&init, &ring);
+    CHECK_EQUAL(size, ring.fd_data + ring.i_queue + ring.s_queue + ring.peers + ring.rx_ring + ring.padding);
+    CHECK(ring.i_queue < slots.i_queue / 3);
+    CHECK_EQUAL(slots.rx_ring, ring.rx_ring);
+
+    TINY_ALIGNED_STRUCT uint8_t buffer[2048];
+    tiny_fd_handle_t handle = nullptr;
+    init.buffer = buffer;
+    init.buffer_size = size - ring.padding;
+    CHECK_EQUAL(TINY_SUCCESS, tiny_fd_init(&handle, &init));
+    tiny_fd_close(handle);
+    init.buffer_size = size - ring.padding - 1;
+    CHECK_EQUAL(TINY_ERR_OUT_OF_MEMORY, tiny_fd_init(&handle, &init));
+    // The ring must fit at least one frame of mtu size
+    init.buffer_size = sizeof(buffer);
+    init.tx_ring_size = 128;
+    CHECK(tiny_fd_init(&handle, &init) < 0);
+    // Automatically calculated mtu is limited by the ring
+    init.mtu = 0;
+    CHECK_EQUAL(TINY_SUCCESS, tiny_fd_init(&handle, &init));
+    CHECK(tiny_fd_get_mtu(handle) > 100 && tiny_fd_get_mtu(handle) <= 128);
+    tiny_fd_close(handle);
+}
+
+TEST(FD, tx_ring_frames_of_different_size)
+{
+    FakeSetup conn;
+    int errors = 0;
+    int bytes = 0;
+    TinyHelperFd helper1(&conn.endpoint1(), 2048, TINY_FD_MODE_ABM,
+                         [&errors, &bytes](uint8_t addr, uint8_t *buf, int len) -> void {
+                             if ( buf[0] != (uint8_t)len || buf[len - 1] != (uint8_t)len )
+                                 errors++;
+                             bytes += len;
+                         });
+    TinyHelperFd helper2(&conn.endpoint2(), 2048, TINY_FD_MODE_ABM, nullptr);
+    // The ring can hold only couple of large frames, but all 7 frames of small size
+    helper1.setTxRingSize(256);
+    helper2.setTxRingSize(256);
+    helper1.setTimeout(250);
+    helper2.setTimeout(250);
+    CHECK_EQUAL(TINY_SUCCESS, helper1.init());
+    CHECK_EQUAL(TINY_SUCCESS, helper2.init());
+    helper1.run(true);
+    helper2.run(true);
+
+    const int mtu = helper2.mtu();
+    CHECK(mtu > 100 && mtu <= 256);
+    int expected = 0;
+    for ( int nsent = 0; nsent < 200; nsent++ )
+    {
+        uint8_t txbuf[256];
+        int len = (nsent % 10 == 9) ? mtu : (nsent % 7) + 1;
+        memset(txbuf, len, len);
+        int result = helper2.send(txbuf, len);
+        CHECK_EQUAL(TINY_SUCCESS, result);
+        expected += len;
+    }
+    helper1.wait_until_rx_count(200, 1000);
+    CHECK_EQUAL(200, helper1.rx_count());
+    CHECK_EQUAL(expected, bytes);
+    CHECK_EQUAL(0, errors);
+}
+
+TEST(FD, rx_compact_packs_received_frames)
+{
+    FakeSetup conn;
+    std::vector<uint8_t *> frames;
+    TinyHelperFd helper1(&conn.endpoint1(), 2048, TINY_FD_MODE_ABM,
+                         [&frames](uint8_t addr, uint8_t *buf, int len) -> void { frames.push_back(buf); });
+    TinyHelperFd helper2(&conn.endpoint2(), 2048, TINY_FD_MODE_ABM, nullptr);
+    // Small tx ring limits automatically calculated mtu, so the rest of the buffer goes to the rx ring
+    helper1.setTxRingSize(64);
+    helper1.setRxCompact(true);
+    CHECK_EQUAL(TINY_SUCCESS, helper1.init());
+    CHECK_EQUAL(TINY_SUCCESS, helper2.init());
+    helper1.run(true);
+    helper2.run(true);
+
+    const int mtu = helper1.mtu();
+    CHECK(mtu > 16 && mtu <= 64);
+    for ( int nsent = 0; nsent < 50; nsent++ )
+    {
+        uint8_t txbuf[4] = {0xAA, 0xFF, 0xCC, 0x66};
+        CHECK_EQUAL(TINY_SUCCESS, helper2.send(txbuf, sizeof(txbuf)));
+    }
+    helper1.wait_until_rx_count(50, 1000);
+    CHECK_EQUAL(50, helper1.rx_count());
+    // Each small frame takes only its size in the rx ring: 2 bytes of header, 4 bytes of payload and crc.
+    // S- and U-frames can be received between I-frames, but they are small too.
+    int packed = 0;
+    for ( size_t i = 1; i < frames.size(); i++ )
+    {
+        if ( frames[i] > frames[i - 1] )
+        {
+            CHECK(frames[i] - frames[i - 1] < mtu);
+            packed++;
+        }
+    }
+    CHECK(packed > 40);
+}
+
+static void checkFraming(hdlc_framing_t framing, hdlc_crc_t crc)
+{
+    FakeSetup conn;
+    int errors = 0;
+    TinyHelperFd helper1(&conn.endpoint1(), 4096, TINY_FD_MODE_ABM,
+                         [&errors](uint8_t addr, uint8_t *buf, int len) -> void {
+                             for ( int i = 0; i < len; i++ )
+                                 if ( buf[i] != (uint8_t)(i % 3 ? len : 0) )
+                                     errors++;
+                         });
+    TinyHelperFd helper2(&conn.endpoint2(), 4096, TINY_FD_MODE_ABM, nullptr);
+    helper1.setFraming(framing);
+    helper2.setFraming(framing);
+    helper1.setCrc(crc);
+    helper2.setCrc(crc);
+    CHECK_EQUAL(TINY_SUCCESS, helper1.init());
+    CHECK_EQUAL(TINY_SUCCESS, helper2.init());
+    helper1.run(true);
+    helper2.run(true);
+
+    // Payloads contain zero bytes, used as COBS delimiters
+    for ( int nsent = 0; nsent < 50; nsent++ )
+    {
+        uint8_t txbuf[64];
+        int len = (nsent % 32) + 1;
+        for ( int i = 0; i < len; i++ )
+            txbuf[i] = (uint8_t)(i % 3 ? len : 0);
+        CHECK_EQUAL(TINY_SUCCESS, helper2.send(txbuf, len));
+    }
+    helper1.wait_until_rx_count(50, 1000);
+    CHECK_EQUAL(50, helper1.rx_count());
+    CHECK_EQUAL(0, errors);
+}
+
+TEST(FD, cobs_framing)
+{
+    checkFraming(HDLC_FRAMING_COBS, HDLC_CRC_16);
+}
+
+TEST(FD, raw_framing)
+{
+    // Fake connection doesn't lose bytes, so crc is not needed
+    checkFraming(HDLC_FRAMING_RAW, HDLC_CRC_OFF);
+}
+
+#if CONFIG_TINY_LARGE_BUFFERS
+TEST(FD, large_mtu_frames)
+{
+    // Large hw buffers prevent byte losses, when reading thread is not fast enough
+    FakeSetup conn(65536, 65536);
+    conn.setSpeed(4000000);
+    const int mtu = 32768;
+    const int size = tiny_fd_buffer_size_by_mtu_ex(1, mtu, 7, HDLC_CRC_16, 1);
+    CHECK(size > 0xFFFF);
+    int errors = 0;
+    TinyHelperFd helper1(&conn.endpoint1(), size, TINY_FD_MODE_ABM,
+                         [&errors, mtu](uint8_t addr, uint8_t *buf, int len) -> void {
+                             if ( len != mtu || buf[0] != 0x55 || buf[len - 1] != 0xAA )
+                                 errors++;
+                         });
+    TinyHelperFd helper2(&conn.endpoint2(), size, TINY_FD_MODE_ABM, nullptr);
+    helper1.setTimeout(2000);
+    helper2.setTimeout(2000);
+    CHECK_EQUAL(TINY_SUCCESS, helper1.init());
+    CHECK_EQUAL(TINY_SUCCESS, helper2.init());
+    helper1.run(true);
+    helper2.run(true);
+
+    std::vector<uint8_t> txbuf(mtu, 0x00);
+    txbuf[0] = 0x55;
+    txbuf[mtu - 1] = 0xAA;
+    for ( int nsent = 0; nsent < 8; nsent++ )
+    {
+        CHECK_EQUAL(TINY_SUCCESS, helper2.send(txbuf.data(), mtu));
+    }
+    helper1.wait_until_rx_count(8, 5000);
+    CHECK_EQUAL(8, helper1.rx_count());
+    CHECK_EQUAL(0, errors);
+}
+#endif
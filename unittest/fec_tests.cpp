@@ -0,0 +1,237 @@
+/*
+    Copyright 2022 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    GNU General Public License Usage
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Commercial License Usage
+
+    Licensees holding valid commercial Tiny Protocol licenses may use this file in
+    accordance with the commercial license agreement provided in accordance with
+    the terms contained in a written agreement between you and Alexey Dynda.
+    For further information contact via email on github account.
+*/
+
+#include <vector>
+#include <CppUTest/TestHarness.h>
+#include <stdlib.h>
+#include <string.h>
+#include "helpers/tiny_fd_helper.h"
+#include "helpers/fake_connection.h"
+#include "proto/fec/tiny_rs.h"
+#include "proto/hdlc/low_level/hdlc.h"
+
+TEST_GROUP(FEC){void setup(){} void teardown(){}};
+
+TEST(FEC, rs_corrects_up_to_half_of_parity_bytes)
+{
+    for ( int nroots: {2, 8, TINY_RS_MAX_ROOTS} )
+    {
+        tiny_rs_t rs;
+        CHECK_EQUAL(TINY_SUCCESS, tiny_rs_init(&rs, nroots));
+        // Full codeword and shortened one
+        for ( int len: {TINY_RS_BLOCK_SIZE - nroots, 20} )
+        {
+            std::vector<uint8_t> data(len);
+            for ( auto &b: data )
+            {
+                b = (uint8_t)rand();
+            }
+            uint8_t parity[TINY_RS_MAX_ROOTS]{};
+            for ( auto b: data )
+            {
+                tiny_rs_encode_byte(&rs, parity, b);
+            }
+            uint8_t check[TINY_RS_MAX_ROOTS];
+            memcpy(check, parity, nroots);
+            CHECK_EQUAL(0, tiny_rs_decode(&rs, data.data(), len, 1, parity));
+
+            std::vector<uint8_t> received = data;
+            for ( int i = 0; i < nroots / 2 - 1; i++ )
+            {
+                received[(i * 7) % len] ^= (uint8_t)(i + 1);
+            }
+            // Errors in parity bytes are corrected too
+            parity[nroots - 1] ^= 0xA5;
+            CHECK_EQUAL(nroots / 2, tiny_rs_decode(&rs, received.data(), len, 1, parity));
+            CHECK(data == received);
+            MEMCMP_EQUAL(check, parity, nroots);
+        }
+    }
+    tiny_rs_t rs;
+    CHECK_EQUAL(TINY_ERR_INVALID_DATA, tiny_rs_init(&rs, TINY_RS_MAX_ROOTS + 2));
+}
+
+TEST(FEC, rs_reports_uncorrectable_block)
+{
+    tiny_rs_t rs;
+    tiny_rs_init(&rs, 4);
+    uint8_t data[32];
+    uint8_t parity[4]{};
+    for ( int i = 0; i < (int)sizeof(data); i++ )
+    {
+        data[i] = (uint8_t)(i * 13);
+        tiny_rs_encode_byte(&rs, parity, data[i]);
+    }
+    data[3] ^= 0x01;
+    data[10] ^= 0x02;
+    data[20] ^= 0x04;
+    CHECK_EQUAL(TINY_ERR_FAILED, tiny_rs_decode(&rs, data, sizeof(data), 1, parity));
+}
+
+/** Sends the frame through hdlc low level, and corrupts count bytes of the line starting at first byte */
+static int sendCorrupted(hdlc_ll_handle_t tx, hdlc_ll_handle_t rx, const std::vector<uint8_t> &payload, int first,
+                         int count)
+{
+    std::vector<uint8_t> wire(payload.size() * 2 + 64);
+    CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_put(tx, payload.data(), payload.size()));
+    int len = hdlc_ll_run_tx(tx, wire.data(), wire.size());
+    for ( int i = first; i < first + count; i++ )
+    {
+        // Payload bytes never turn into framing bytes, so the length of the frame is not changed
+        wire[i] ^= 0x34;
+    }
+    int error = TINY_SUCCESS;
+    CHECK_EQUAL(len, hdlc_ll_run_rx(rx, wire.data(), len, &error));
+    return error;
+}
+
+TEST(FEC, hdlc_ll_corrects_error_bursts)
+{
+    const int mtu = 600;
+    const uint8_t fec = 4;
+    const int size = hdlc_ll_get_buf_size_ex(mtu, HDLC_CRC_16, 1) + HDLC_LL_FEC_BUF_SIZE(mtu, HDLC_CRC_16, fec, 1);
+    std::vector<uint8_t> tx_buf(size);
+    std::vector<uint8_t> rx_buf(size);
+    std::vector<std::vector<uint8_t>> frames;
+    for ( hdlc_framing_t framing: {HDLC_FRAMING_HDLC, HDLC_FRAMING_COBS, HDLC_FRAMING_RAW} )
+    {
+        hdlc_ll_handle_t tx = nullptr, rx = nullptr;
+        hdlc_ll_init_t init{};
+        init.crc_type = HDLC_CRC_16;
+        init.framing = framing;
+        init.mtu = mtu;
+        init.fec = fec;
+        init.buf = tx_buf.data();
+        init.buf_size = tx_buf.size();
+        CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_init(&tx, &init));
+        init.buf = rx_buf.data();
+        init.buf_size = rx_buf.size();
+        init.user_data = &frames;
+        init.on_frame_read = [](void *udata, uint8_t *data, int len) -> void {
+            static_cast<std::vector<std::vector<uint8_t>> *>(udata)->emplace_back(data, data + len);
+        };
+        CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_init(&rx, &init));
+        frames.clear();
+
+        // Bytes 0x50-0x6F need no escaping, and are not zeros
+        std::vector<uint8_t> payload(mtu);
+        for ( int i = 0; i < mtu; i++ )
+        {
+            payload[i] = (uint8_t)(0x50 + (i & 0x1F));
+        }
+        // 602 bytes of payload and crc are split to 3 interleaved blocks, so the burst of 12 bytes
+        // gives 4 errors in each block
+        CHECK_EQUAL(TINY_SUCCESS, sendCorrupted(tx, rx, payload, 10, 12));
+        CHECK_EQUAL(1, (int)frames.size());
+        CHECK(frames.back() == payload);
+        // Short frame has single block
+        std::vector<uint8_t> small(payload.begin(), payload.begin() + 40);
+        CHECK_EQUAL(TINY_SUCCESS, sendCorrupted(tx, rx, small, 5, 4));
+        CHECK_EQUAL(2, (int)frames.size());
+        CHECK(frames.back() == small);
+        // Too many errors are detected, and the frame is dropped
+        CHECK_EQUAL(TINY_ERR_WRONG_CRC, sendCorrupted(tx, rx, small, 5, 8));
+        CHECK_EQUAL(2, (int)frames.size());
+        // Clean frame after the broken one
+        CHECK_EQUAL(TINY_SUCCESS, sendCorrupted(tx, rx, small, 0, 0));
+        CHECK_EQUAL(3, (int)frames.size());
+        CHECK(frames.back() == small);
+        // Parity buffer has fixed size, so frames larger than mtu can't be sent
+        std::vector<uint8_t> large(mtu + 1);
+        CHECK_EQUAL(TINY_ERR_DATA_TOO_LARGE, hdlc_ll_put(tx, large.data(), large.size()));
+        hdlc_ll_close(tx);
+        hdlc_ll_close(rx);
+    }
+}
+
+TEST(FEC, hdlc_ll_parity_size)
+{
+    // 2 * fec parity bytes are added for each block of up to 255 - 2 * fec bytes
+    CHECK_EQUAL(0, HDLC_LL_FEC_PARITY_SIZE(100, 0));
+    CHECK_EQUAL(8, HDLC_LL_FEC_PARITY_SIZE(247, 4));
+    CHECK_EQUAL(16, HDLC_LL_FEC_PARITY_SIZE(248, 4));
+    // Parity of the frame being sent, and parity field of each rx frame
+    CHECK_EQUAL(8 * 3, HDLC_LL_FEC_BUF_SIZE(100, HDLC_CRC_16, 4, 2));
+    CHECK_EQUAL(0, HDLC_LL_FEC_BUF_SIZE(100, HDLC_CRC_16, 0, 2));
+
+    std::vector<uint8_t> buf(hdlc_ll_get_buf_size_ex(32, HDLC_CRC_16, 1) +
+                             HDLC_LL_FEC_BUF_SIZE(32, HDLC_CRC_16, HDLC_LL_FEC_MAX, 1));
+    hdlc_ll_handle_t handle = nullptr;
+    hdlc_ll_init_t init{};
+    init.crc_type = HDLC_CRC_16;
+    init.buf = buf.data();
+    init.buf_size = buf.size();
+    init.fec = 4;
+    // FEC requires mtu to reserve parity buffer
+    CHECK_EQUAL(TINY_ERR_INVALID_DATA, hdlc_ll_init(&handle, &init));
+    init.mtu = 32;
+    init.fec = HDLC_LL_FEC_MAX + 1;
+    CHECK_EQUAL(TINY_ERR_INVALID_DATA, hdlc_ll_init(&handle, &init));
+    init.fec = HDLC_LL_FEC_MAX;
+    CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_init(&handle, &init));
+}
+
+TEST(FEC, fd_recovers_noisy_frames)
+{
+    FakeSetup conn;
+    const int mtu = 64;
+    tiny_fd_init_t init{};
+    init.mtu = mtu;
+    init.window_frames = 3;
+    init.crc_type = HDLC_CRC_16;
+    init.fec = 2;
+    tiny_fd_layout_t layout{};
+    const int size = tiny_fd_get_layout(&init, &layout);
+    // Parity of tx frame and of rx frame: header, payload and crc field make single block
+    CHECK_EQUAL(size - 2 * 4, tiny_fd_buffer_size_by_mtu_ex(1, mtu, 3, HDLC_CRC_16, 1));
+    TinyHelperFd helper1(&conn.endpoint1(), size, nullptr, 3, 1000);
+    TinyHelperFd helper2(&conn.endpoint2(), size, nullptr, 3, 1000);
+    helper1.setFec(2);
+    helper2.setFec(2);
+    CHECK_EQUAL(TINY_SUCCESS, helper1.init());
+    CHECK_EQUAL(TINY_SUCCESS, helper2.init());
+    // mtu, calculated by the buffer size, can be slightly larger due to alignment
+    CHECK(helper1.mtu() >= mtu);
+    // Each frame gets 1-2 errors, so no frame would be delivered without FEC
+    conn.line2().generate_error_every_n_byte(50);
+    helper1.run(true);
+    helper2.run(true);
+
+    const int count = 100;
+    uint8_t txbuf[mtu];
+    memset(txbuf, 0x11, sizeof(txbuf));
+    for ( int nsent = 0; nsent < count; nsent++ )
+    {
+        CHECK_EQUAL(TINY_SUCCESS, helper2.send(txbuf, sizeof(txbuf)));
+    }
+    helper1.wait_until_rx_count(count, 2000);
+    CHECK_EQUAL(count, helper1.rx_count());
+    // Only the errors, which hit framing bytes, are not corrected
+    CHECK(helper1.stats().crc_errors < count / 10);
+    CHECK(helper2.stats().retransmissions < count / 4);
+}
@@ -67,6 +67,34 @@ TEST(HAL, mutex)
     }
 }
 
+TEST(HAL, events)
+{
+    tiny_events_t events;
+    tiny_events_create(&events);
+    CHECK_EQUAL(0, tiny_events_wait(&events, 0x01, EVENT_BITS_LEAVE, 0));
+    tiny_events_set(&events, 0x05);
+    CHECK_EQUAL(0x05, tiny_events_wait(&events, 0x01, EVENT_BITS_CLEAR, 0));
+    CHECK_EQUAL(0x04, tiny_events_wait(&events, 0x04, EVENT_BITS_LEAVE, 0));
+    tiny_events_clear(&events, 0x04);
+    CHECK_EQUAL(0, tiny_events_wait(&events, 0x05, EVENT_BITS_LEAVE, 0));
+    // Waiting thread must be woken up by the other thread
+    std::thread setter(
+        [&events]()
+        {
+            tiny_sleep(20);
+            tiny_events_set(&events, 0x02);
+        });
+    uint32_t start = tiny_millis();
+    CHECK_EQUAL(0x02, tiny_events_wait(&events, 0x02, EVENT_BITS_CLEAR, 1000));
+    CHECK(static_cast<uint32_t>(tiny_millis() - start) < 500);
+    setter.join();
+    // Timeout must expire if nobody sets the bits
+    start = tiny_millis();
+    CHECK_EQUAL(0, tiny_events_wait(&events, 0x02, EVENT_BITS_CLEAR, 50));
+    CHECK(static_cast<uint32_t>(tiny_millis() - start) >= 50);
+    tiny_events_destroy(&events);
+}
+
 extern "C" void tiny_list_init(void);
 
 TEST(HAL, list)
@@ -129,6 +157,16 @@ TEST(HAL, crc)
                                                                           (crc32_num >> 8) & 0xFF),
                                                                (crc32_num >> 16) & 0xFF),
                                                     (crc32_num >> 24))));
+    const char *check = "123456789";
+    CHECK_EQUAL(0xE3069283, tiny_crc32c(INITCRC32C, (const uint8_t *)check, strlen(check)));
+    // Misaligned start and the tails are processed separately from the words
+    uint32_t crc32c_num = tiny_crc32c(INITCRC32C, buf, sizeof(buf));
+    uint32_t crc32c_chained = tiny_crc32c(INITCRC32C, buf, 3);
+    crc32c_chained = tiny_crc32c(~crc32c_chained, buf + 3, 250);
+    crc32c_chained = tiny_crc32c(~crc32c_chained, buf + 253, 3);
+    CHECK_EQUAL(crc32c_num, crc32c_chained);
+    CHECK_EQUAL(0x9C44184B, crc32c_num);
+    CHECK_EQUAL(GOODCRC32C, ~tiny_crc32c(~crc32c_num, (uint8_t *)&crc32c_num, 4));
 }
 
 TEST(HAL, millis)
@@ -27,6 +27,7 @@
 */
 
 #include <functional>
+#include <vector>
 #include <CppUTest/TestHarness.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -112,6 +113,20 @@ TEST(HDLC, crc32)
     CHECK_EQUAL(1, helper2.rx_count());
 }
 
+TEST(HDLC, crc32c)
+{
+    const char *txbuf = "This is CRC32C check";
+    FakeSetup conn;
+    TinyHdlcHelper helper1(&conn.endpoint1(), nullptr, nullptr, 1024, HDLC_CRC_32C);
+    TinyHdlcHelper helper2(
+        &conn.endpoint2(), [&txbuf](uint8_t *buf, int len) -> void { STRCMP_EQUAL(txbuf, (char *)buf); }, nullptr, 1024,
+        HDLC_CRC_32C);
+    int msg_size = strlen(txbuf) + 1;
+    helper1.send((uint8_t *)txbuf, msg_size, 100);
+    helper2.wait_until_rx_count(1, 100);
+    CHECK_EQUAL(1, helper2.rx_count());
+}
+
 TEST(HDLC, send_receive)
 {
     uint32_t bytes_sent = 0;
@@ -302,9 +317,259 @@ TEST(HDLC, hdlc_incomplete_send_on_close)
 
 TEST(HDLC, check_buf_size_calculations)
 {
-    CHECK_EQUAL( sizeof(hdlc_ll_data_t) + 13 + TINY_ALIGN_STRUCT_VALUE, hdlc_ll_get_buf_size(10) );
-    CHECK_EQUAL( sizeof(hdlc_ll_data_t) +  9 + TINY_ALIGN_STRUCT_VALUE, hdlc_ll_get_buf_size_ex(10, HDLC_CRC_OFF, 1) );
-    CHECK_EQUAL( sizeof(hdlc_ll_data_t) + 10 + TINY_ALIGN_STRUCT_VALUE, hdlc_ll_get_buf_size_ex(10, HDLC_CRC_8, 1) );
-    CHECK_EQUAL( sizeof(hdlc_ll_data_t) + 11 + TINY_ALIGN_STRUCT_VALUE, hdlc_ll_get_buf_size_ex(10, HDLC_CRC_16, 1) );
-    CHECK_EQUAL( sizeof(hdlc_ll_data_t) + 13 + TINY_ALIGN_STRUCT_VALUE, hdlc_ll_get_buf_size_ex(10, HDLC_CRC_32, 1) );
+    CHECK( HDLC_LL_DATA_SIZE >= sizeof(hdlc_ll_data_t) );
+    CHECK_EQUAL( HDLC_LL_DATA_SIZE + 13 + TINY_ALIGN_STRUCT_VALUE, hdlc_ll_get_buf_size(10) );
+    CHECK_EQUAL( HDLC_LL_DATA_SIZE +  9 + TINY_ALIGN_STRUCT_VALUE, hdlc_ll_get_buf_size_ex(10, HDLC_CRC_OFF, 1) );
+    CHECK_EQUAL( HDLC_LL_DATA_SIZE + 10 + TINY_ALIGN_STRUCT_VALUE, hdlc_ll_get_buf_size_ex(10, HDLC_CRC_8, 1) );
+    CHECK_EQUAL( HDLC_LL_DATA_SIZE + 11 + TINY_ALIGN_STRUCT_VALUE, hdlc_ll_get_buf_size_ex(10, HDLC_CRC_16, 1) );
+    CHECK_EQUAL( HDLC_LL_DATA_SIZE + 13 + TINY_ALIGN_STRUCT_VALUE, hdlc_ll_get_buf_size_ex(10, HDLC_CRC_32, 1) );
+}
+
+TEST(HDLC, hdlc_ll_compact_rx)
+{
+    TINY_ALIGNED_STRUCT uint8_t tx_buf[sizeof(hdlc_ll_data_t) + 64];
+    // Rx ring of 3 frames of mtu size: 102 bytes
+    TINY_ALIGNED_STRUCT uint8_t rx_buf[sizeof(hdlc_ll_data_t) + 3 * (32 + 2)];
+    std::vector<std::pair<uint8_t *, int>> frames;
+    hdlc_ll_handle_t tx = nullptr, rx = nullptr;
+    hdlc_ll_init_t init{};
+    init.crc_type = HDLC_CRC_16;
+    init.mtu = 32;
+    init.buf = tx_buf;
+    init.buf_size = sizeof(tx_buf);
+    CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_init(&tx, &init));
+    init.buf = rx_buf;
+    init.buf_size = sizeof(rx_buf);
+    init.rx_compact = 1;
+    init.user_data = &frames;
+    init.on_frame_read = [](void *udata, uint8_t *data, int len) -> void {
+        static_cast<std::vector<std::pair<uint8_t *, int>> *>(udata)->emplace_back(data, len);
+    };
+    CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_init(&rx, &init));
+    auto transfer = [&](const uint8_t *payload, int size) {
+        uint8_t wire[80];
+        CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_put(tx, payload, size));
+        int len = hdlc_ll_run_tx(tx, wire, sizeof(wire));
+        CHECK_EQUAL(len, hdlc_ll_run_rx(rx, wire, len, nullptr));
+    };
+
+    // Small frames of 6 bytes with crc are packed back to back up to the end of the ring:
+    // mtu slots would hold only 3 frames
+    for ( uint8_t i = 1; i <= 17; i++ )
+    {
+        uint8_t payload[4] = {i, i, i, i};
+        transfer(payload, sizeof(payload));
+    }
+    CHECK_EQUAL(17, (int)frames.size());
+    uint8_t *ring = frames[0].first;
+    for ( int i = 0; i < 17; i++ )
+    {
+        CHECK(frames[i].first == ring + i * 6);
+        CHECK_EQUAL(4, frames[i].second);
+        CHECK_EQUAL(i + 1, frames[i].first[0]);
+        CHECK_EQUAL(i + 1, frames[i].first[3]);
+    }
+    // The ring is full, next frame starts from the beginning
+    for ( uint8_t i = 18; i <= 29; i++ )
+    {
+        uint8_t payload[4] = {i, i, i, i};
+        transfer(payload, sizeof(payload));
+    }
+    CHECK(frames[17].first == ring);
+    CHECK(frames[28].first == ring + 11 * 6);
+    // Frame of mtu size doesn't fit the rest of the ring, and received part is moved to the beginning
+    uint8_t payload[32];
+    for ( int i = 0; i < (int)sizeof(payload); i++ )
+    {
+        payload[i] = (uint8_t)i;
+    }
+    transfer(payload, sizeof(payload));
+    CHECK_EQUAL(30, (int)frames.size());
+    CHECK(frames[29].first == ring);
+    CHECK_EQUAL(32, frames[29].second);
+    MEMCMP_EQUAL(payload, frames[29].first, sizeof(payload));
+    hdlc_ll_close(tx);
+    hdlc_ll_close(rx);
+}
+
+TEST(HDLC, hdlc_ll_frame_filter)
+{
+    TINY_ALIGNED_STRUCT uint8_t tx_buf[sizeof(hdlc_ll_data_t) + 64];
+    TINY_ALIGNED_STRUCT uint8_t rx_buf[sizeof(hdlc_ll_data_t) + 64];
+    std::vector<uint8_t> addresses;
+    hdlc_ll_handle_t tx = nullptr, rx = nullptr;
+    hdlc_ll_init_t init{};
+    init.crc_type = HDLC_CRC_16;
+    init.mtu = 32;
+    init.buf = tx_buf;
+    init.buf_size = sizeof(tx_buf);
+    CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_init(&tx, &init));
+    init.buf = rx_buf;
+    init.buf_size = sizeof(rx_buf);
+    init.user_data = &addresses;
+    init.on_frame_read = [](void *udata, uint8_t *data, int len) -> void {
+        static_cast<std::vector<uint8_t> *>(udata)->push_back(data[0]);
+    };
+    init.on_frame_filter = [](void *, uint8_t address) -> bool { return address == 0x07; };
+    CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_init(&rx, &init));
+
+    // Frames for other station contain escaped bytes, including the address byte
+    const uint8_t frames[][4] = {{0x7E, 0x7D, 0x7E, 0x01}, {0x07, 0x7E, 0x02, 0x03}, {0x05, 0x7D, 0x7D, 0x7E},
+                                 {0x07, 0x01, 0x7D, 0x04}};
+    for ( auto &frame: frames )
+    {
+        uint8_t wire[32];
+        CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_put(tx, frame, sizeof(frame)));
+        int len = hdlc_ll_run_tx(tx, wire, sizeof(wire));
+        int error = TINY_SUCCESS;
+        CHECK_EQUAL(len, hdlc_ll_run_rx(rx, wire, len, &error));
+        CHECK_EQUAL(TINY_SUCCESS, error);
+    }
+    CHECK_EQUAL(2, (int)addresses.size());
+    CHECK_EQUAL(0x07, addresses[0]);
+    CHECK_EQUAL(0x07, addresses[1]);
+    hdlc_ll_close(tx);
+    hdlc_ll_close(rx);
+}
+
+TEST(HDLC, hdlc_ll_cobs_encode)
+{
+    TINY_ALIGNED_STRUCT uint8_t tx_buf[sizeof(hdlc_ll_data_t) + 64];
+    hdlc_ll_handle_t tx = nullptr;
+    hdlc_ll_init_t init{};
+    init.crc_type = HDLC_CRC_OFF;
+    init.framing = HDLC_FRAMING_COBS;
+    init.mtu = 32;
+    init.buf = tx_buf;
+    init.buf_size = sizeof(tx_buf);
+    CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_init(&tx, &init));
+    const uint8_t payload[] = {0x11, 0x00, 0x00, 0x22, 0x00};
+    const uint8_t frame[] = {0x00, 0x02, 0x11, 0x01, 0x02, 0x22, 0x01, 0x00};
+    uint8_t wire[32];
+    CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_put(tx, payload, sizeof(payload)));
+    CHECK_EQUAL((int)sizeof(frame), hdlc_ll_run_tx(tx, wire, sizeof(wire)));
+    MEMCMP_EQUAL(frame, wire, sizeof(frame));
+    hdlc_ll_close(tx);
+}
+
+TEST(HDLC, hdlc_ll_cobs_roundtrip)
+{
+    const int mtu = 700;
+    std::vector<uint8_t> tx_buf(hdlc_ll_get_buf_size_ex(mtu, HDLC_CRC_32, 1));
+    std::vector<uint8_t> rx_buf(hdlc_ll_get_buf_size_ex(mtu, HDLC_CRC_32, 1));
+    std::vector<std::vector<uint8_t>> frames;
+    for ( hdlc_crc_t crc: {HDLC_CRC_OFF, HDLC_CRC_8, HDLC_CRC_16, HDLC_CRC_32, HDLC_CRC_32C} )
+    {
+        hdlc_ll_handle_t tx = nullptr, rx = nullptr;
+        hdlc_ll_init_t init{};
+        init.crc_type = crc;
+        init.framing = HDLC_FRAMING_COBS;
+        init.mtu = mtu;
+        init.buf = tx_buf.data();
+        init.buf_size = tx_buf.size();
+        CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_init(&tx, &init));
+        init.buf = rx_buf.data();
+        init.buf_size = rx_buf.size();
+        init.user_data = &frames;
+        init.on_frame_read = [](void *udata, uint8_t *data, int len) -> void {
+            static_cast<std::vector<std::vector<uint8_t>> *>(udata)->emplace_back(data, data + len);
+        };
+        CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_init(&rx, &init));
+        // Runs of 253, 254 and 255 non-zero bytes, zeros at the edges, and random data with zeros
+        std::vector<std::vector<uint8_t>> payloads;
+        payloads.emplace_back(253, 0x5A);
+        payloads.emplace_back(254, 0x5A);
+        payloads.emplace_back(255, 0x5A);
+        payloads.emplace_back(mtu, 0xFF);
+        payloads.emplace_back(3, 0x00);
+        payloads.push_back({0x00, 0x01, 0x02, 0x00});
+        std::vector<uint8_t> random(mtu);
+        for ( auto &b: random )
+        {
+            b = (rand() & 3) ? (uint8_t)rand() : 0;
+        }
+        payloads.push_back(random);
+        frames.clear();
+        for ( auto &payload: payloads )
+        {
+            std::vector<uint8_t> wire(mtu * 2);
+            CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_put(tx, payload.data(), payload.size()));
+            int len = hdlc_ll_run_tx(tx, wire.data(), wire.size());
+            // The overhead doesn't depend on the data
+            CHECK((int)(payload.size() + 4 + 2 + (payload.size() + 4) / 254 + 1) >= len);
+            // Pass the frame in small chunks to check the decoder state between the calls
+            for ( int pos = 0; pos < len; pos += 3 )
+            {
+                int chunk = len - pos < 3 ? len - pos : 3;
+                CHECK_EQUAL(chunk, hdlc_ll_run_rx(rx, wire.data() + pos, chunk, nullptr));
+            }
+        }
+        CHECK_EQUAL(payloads.size(), frames.size());
+        for ( size_t i = 0; i < payloads.size() && i < frames.size(); i++ )
+        {
+            CHECK_EQUAL(payloads[i].size(), frames[i].size());
+            CHECK(payloads[i] == frames[i]);
+        }
+        hdlc_ll_close(tx);
+        hdlc_ll_close(rx);
+    }
+}
+
+TEST(HDLC, hdlc_ll_raw_roundtrip)
+{
+    const int mtu = 300;
+    std::vector<uint8_t> tx_buf(hdlc_ll_get_buf_size_ex(mtu, HDLC_CRC_16, 1));
+    std::vector<uint8_t> rx_buf(hdlc_ll_get_buf_size_ex(mtu, HDLC_CRC_16, 1));
+    std::vector<std::vector<uint8_t>> frames;
+    for ( hdlc_crc_t crc: {HDLC_CRC_OFF, HDLC_CRC_16} )
+    {
+        hdlc_ll_handle_t tx = nullptr, rx = nullptr;
+        hdlc_ll_init_t init{};
+        init.crc_type = crc;
+        init.framing = HDLC_FRAMING_RAW;
+        init.mtu = mtu;
+        init.buf = tx_buf.data();
+        init.buf_size = tx_buf.size();
+        CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_init(&tx, &init));
+        init.buf = rx_buf.data();
+        init.buf_size = rx_buf.size();
+        init.user_data = &frames;
+        init.on_frame_read = [](void *udata, uint8_t *data, int len) -> void {
+            static_cast<std::vector<std::vector<uint8_t>> *>(udata)->emplace_back(data, data + len);
+        };
+        CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_init(&rx, &init));
+        frames.clear();
+        // Frames up to 127 bytes have single byte length prefix
+        const int sizes[] = {1, 125, 126, 127, 128, mtu};
+        for ( int size: sizes )
+        {
+            std::vector<uint8_t> payload(size, 0x7E);
+            uint8_t wire[mtu + 8];
+            CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_put(tx, payload.data(), size));
+            int len = hdlc_ll_run_tx(tx, wire, sizeof(wire));
+            int frame_len = size + (crc == HDLC_CRC_16 ? 2 : 0);
+            CHECK_EQUAL(frame_len + (frame_len > 127 ? 2 : 1), len);
+            CHECK_EQUAL(frame_len & 0x7F, wire[0] & 0x7F);
+            for ( int pos = 0; pos < len; pos += 5 )
+            {
+                int chunk = len - pos < 5 ? len - pos : 5;
+                CHECK_EQUAL(chunk, hdlc_ll_run_rx(rx, wire + pos, chunk, nullptr));
+            }
+            CHECK(!frames.empty() && frames.back() == payload);
+        }
+        CHECK_EQUAL((int)(sizeof(sizes) / sizeof(sizes[0])), (int)frames.size());
+
+        // Too long frame is dropped, and the next frame is received
+        std::vector<uint8_t> wire = {0x90, 0x03};
+        wire.resize(2 + 400, 0x55);
+        uint8_t frame[mtu + 8];
+        CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_put(tx, sizes, 4));
+        int len = hdlc_ll_run_tx(tx, frame, sizeof(frame));
+        wire.insert(wire.end(), frame, frame + len);
+        CHECK_EQUAL((int)wire.size(), hdlc_ll_run_rx(rx, wire.data(), wire.size(), nullptr));
+        CHECK_EQUAL((int)(sizeof(sizes) / sizeof(sizes[0])) + 1, (int)frames.size());
+        MEMCMP_EQUAL(sizes, frames.back().data(), 4);
+        hdlc_ll_close(tx);
+        hdlc_ll_close(rx);
+    }
 }
@@ -53,6 +53,11 @@ int FakeEndpoint::read(uint8_t *data, int length)
     return m_rxBlock->Read(data, length, m_timeout);
 }
 
+int FakeEndpoint::read_available(uint8_t *data, int length)
+{
+    return m_rxBlock->Read(data, length, 0);
+}
+
 int FakeEndpoint::write(const uint8_t *data, int length)
 {
     return m_txBlock->Write(data, length, m_timeout);
@@ -45,6 +45,9 @@ public:
 
     int read(uint8_t *data, int length);
 
+    // Reads only bytes, which are already received, without waiting
+    int read_available(uint8_t *data, int length);
+
     int write(const uint8_t *data, int length);
 
     bool wait_until_rx_count(int count, int timeout);
@@ -138,6 +138,12 @@ public:
         return m_lostBytes;
     }
 
+    /** Returns number of HDLC flags (0x7E), passed through the wire */
+    int flags()
+    {
+        return m_flags;
+    }
+
 private:
     typedef struct
     {
@@ -152,6 +158,7 @@ private:
     int m_byte_counter = 0;
     bool m_enabled = true;
     std::atomic<int> m_lostBytes{0};
+    std::atomic<int> m_flags{0};
 
     void TransferData(int num_bytes);
 
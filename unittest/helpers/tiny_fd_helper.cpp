@@ -56,6 +56,47 @@ void TinyHelperFd::setTimeout(int timeout)
     m_timeout = timeout;
 }
 
+void TinyHelperFd::enableAggregation(uint16_t timeout)
+{
+    m_aggregation = 1;
+    m_aggregationTimeout = timeout;
+}
+
+void TinyHelperFd::setTxRingSize(int size)
+{
+    m_txRingSize = size;
+}
+
+void TinyHelperFd::setRxCompact(bool compact)
+{
+    m_rxCompact = compact;
+}
+
+void TinyHelperFd::setFraming(hdlc_framing_t framing)
+{
+    m_framing = framing;
+}
+
+void TinyHelperFd::setCrc(hdlc_crc_t crc)
+{
+    m_crc = crc;
+}
+
+void TinyHelperFd::setAdaptive(bool adaptive)
+{
+    m_adaptive = adaptive;
+}
+
+void TinyHelperFd::enableNegotiation()
+{
+    m_negotiation = 1;
+}
+
+void TinyHelperFd::setFec(uint8_t fec)
+{
+    m_fec = fec;
+}
+
 void TinyHelperFd::setAddress(uint8_t address)
 {
     m_addr = address;
@@ -83,7 +124,15 @@ int TinyHelperFd::init()
     init.mode = m_mode;
     init.peers_count = m_peersCount;
     init.addr = m_addr;
-    init.crc_type = HDLC_CRC_16;
+    init.crc_type = m_crc;
+    init.aggregation = m_aggregation;
+    init.aggregation_timeout = m_aggregationTimeout;
+    init.tx_ring_size = m_txRingSize;
+    init.rx_compact = m_rxCompact;
+    init.framing = m_framing;
+    init.adaptive = m_adaptive;
+    init.negotiation = m_negotiation;
+    init.fec = m_fec;
 
     return tiny_fd_init(&m_handle, &init);
 }
@@ -108,6 +157,11 @@ int TinyHelperFd::sendto(uint8_t address, uint8_t *buf, int len)
     return tiny_fd_send_packet_to(m_handle, address, buf, len, m_timeout);
 }
 
+int TinyHelperFd::send_data(uint8_t *buf, int len)
+{
+    return tiny_fd_send(m_handle, buf, len, m_timeout);
+}
+
 void TinyHelperFd::MessageSender(TinyHelperFd *helper, int count, std::string msg)
 {
     while ( count-- && !helper->m_stop_sender )
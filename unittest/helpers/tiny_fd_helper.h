@@ -52,11 +52,20 @@ public:
     void setAddress(uint8_t address);
     void setPeersCount(uint8_t count);
     void setTimeout(int timeout);
+    void enableAggregation(uint16_t timeout);
+    void setTxRingSize(int size);
+    void setRxCompact(bool compact);
+    void setFraming(hdlc_framing_t framing);
+    void setCrc(hdlc_crc_t crc);
+    void setAdaptive(bool adaptive);
+    void enableNegotiation();
+    void setFec(uint8_t fec);
     int init();
 
     int registerPeer(uint8_t address);
     int send(uint8_t *buf, int len);
     int sendto(uint8_t addr, uint8_t *buf, int len);
+    int send_data(uint8_t *buf, int len);
     int send(const std::string &message);
     int send(int count, const std::string &msg);
     int run_rx() override;
@@ -65,6 +74,28 @@ public:
     {
         tiny_fd_set_ka_timeout(m_handle, timeout);
     }
+    int mtu()
+    {
+        return tiny_fd_get_mtu(m_handle);
+    }
+    int negotiated_params(int *mtu, int *window, bool *aggregation)
+    {
+        return tiny_fd_get_negotiated_params(m_handle, TINY_FD_PRIMARY_ADDR, mtu, window, aggregation);
+    }
+    tiny_fd_stats_t stats()
+    {
+        tiny_fd_stats_t stats{};
+        tiny_fd_get_stats(m_handle, &stats);
+        return stats;
+    }
+    void reset_stats()
+    {
+        tiny_fd_reset_stats(m_handle);
+    }
+    void adaptive_params(int *mtu, int *window)
+    {
+        tiny_fd_get_adaptive_params(m_handle, TINY_FD_PRIMARY_ADDR, mtu, window);
+    }
     using IBaseHelper<TinyHelperFd>::run;
 
     void wait_until_rx_count(int count, uint32_t timeout);
@@ -94,6 +125,15 @@ private:
     int m_rxBufferSize;
     int m_window;
     int m_timeout;
+    uint8_t m_aggregation = 0;
+    uint16_t m_aggregationTimeout = 0;
+    int m_txRingSize = 0;
+    bool m_rxCompact = false;
+    hdlc_framing_t m_framing = HDLC_FRAMING_HDLC;
+    hdlc_crc_t m_crc = HDLC_CRC_16;
+    bool m_adaptive = false;
+    uint8_t m_negotiation = 0;
+    uint8_t m_fec = 0;
 
     static void onRxFrame(void *handle, uint8_t address, uint8_t *buf, int len);
     static void onTxFrame(void *handle, uint8_t address, const uint8_t *buf, int len);
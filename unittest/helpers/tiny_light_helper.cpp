@@ -52,7 +52,13 @@ int TinyLightHelper::read(uint8_t *buf, int len)
 int TinyLightHelper::read_data(void *appdata, void *data, int length)
 {
     TinyLightHelper *helper = reinterpret_cast<TinyLightHelper *>(appdata);
-    return helper->m_endpoint->read((uint8_t *)data, length);
+    // Emulate read() of serial port: wait for the first byte only, then take all already received bytes
+    int result = helper->m_endpoint->read((uint8_t *)data, 1);
+    if ( result > 0 && length > 1 )
+    {
+        result += helper->m_endpoint->read_available((uint8_t *)data + 1, length - 1);
+    }
+    return result;
 }
 
 int TinyLightHelper::write_data(void *appdata, const void *data, int length)
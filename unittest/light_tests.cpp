@@ -82,4 +82,28 @@ TEST(LIGHT, small_frames)
     CHECK_EQUAL('T', rxbuf[0]);
 }
 
+TEST(LIGHT, back_to_back_frames)
+{
+    FakeSetup conn;
+    conn.endpoint1().setTimeout(100);
+    conn.endpoint2().setTimeout(100);
+    TinyLightHelper helper1(&conn.endpoint1());
+    TinyLightHelper helper2(&conn.endpoint2());
+    uint8_t rxbuf[16]{};
+    // Several frames are received by single read_func() call, the rest must be kept for the next read
+    for ( uint8_t i = 0; i < 8; i++ )
+    {
+        uint8_t txbuf[3] = {'F', i, 0x7E};
+        CHECK_EQUAL(3, helper1.send(txbuf, sizeof(txbuf)));
+    }
+    conn.endpoint2().wait_until_rx_count(8 * 7, 500);
+    for ( uint8_t i = 0; i < 8; i++ )
+    {
+        CHECK_EQUAL(3, helper2.read(rxbuf, sizeof(rxbuf)));
+        CHECK_EQUAL('F', rxbuf[0]);
+        CHECK_EQUAL(i, rxbuf[1]);
+        CHECK_EQUAL(0x7E, rxbuf[2]);
+    }
+}
+
 #endif
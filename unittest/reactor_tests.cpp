@@ -0,0 +1,171 @@
+/*
+    Copyright 2019-2022 (,2022 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    GNU General Public License Usage
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Commercial License Usage
+
+    Licensees holding valid commercial Tiny Protocol licenses may use this file in
+    accordance with the commercial license agreement provided in accordance with
+    the terms contained in a written agreement between you and Alexey Dynda.
+    For further information contact via email on github account.
+*/
+
+#if defined(__linux__)
+
+#include <CppUTest/TestHarness.h>
+#include <atomic>
+#include <thread>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "TinyFdReactor.h"
+
+struct ReactorPeer
+{
+    tiny_fd_handle_t handle = nullptr;
+    uint8_t buffer[4096]{};
+    std::atomic<int> rx_count{0};
+    std::atomic<bool> connected{false};
+
+    int init()
+    {
+        tiny_fd_init_t init{};
+        init.pdata = this;
+        init.on_read_cb = [](void *udata, uint8_t addr, uint8_t *buf, int len) -> void {
+            static_cast<ReactorPeer *>(udata)->rx_count++;
+        };
+        init.on_connect_event_cb = [](void *udata, uint8_t addr, bool connected) -> void {
+            static_cast<ReactorPeer *>(udata)->connected = connected;
+        };
+        init.buffer = buffer;
+        init.buffer_size = sizeof(buffer);
+        init.window_frames = 7;
+        init.send_timeout = 1000;
+        init.retry_timeout = 100;
+        init.retries = 2;
+        init.crc_type = HDLC_CRC_16;
+        return tiny_fd_init(&handle, &init);
+    }
+
+    ~ReactorPeer()
+    {
+        if ( handle )
+        {
+            tiny_fd_close(handle);
+        }
+    }
+};
+
+TEST_GROUP(REACTOR){void setup(){} void teardown(){}};
+
+TEST(REACTOR, single_thread_drives_several_links)
+{
+    const int links = 4;
+    ReactorPeer peers[links][2];
+    int fds[links][2];
+    tinyproto::FdReactor reactor;
+    for ( int i = 0; i < links; i++ )
+    {
+        CHECK_EQUAL(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds[i]));
+        CHECK_EQUAL(TINY_SUCCESS, peers[i][0].init());
+        CHECK_EQUAL(TINY_SUCCESS, peers[i][1].init());
+        CHECK_TRUE(reactor.add(peers[i][0].handle, fds[i][0]));
+        CHECK_TRUE(reactor.add(peers[i][1].handle, fds[i][1]));
+    }
+    CHECK_EQUAL(links * 2, reactor.size());
+    std::thread thread(&tinyproto::FdReactor::run, &reactor);
+    uint8_t txbuf[16] = {0xAA, 0x7E, 0x7D, 0x55};
+    for ( int n = 0; n < 50; n++ )
+    {
+        for ( int i = 0; i < links; i++ )
+        {
+            CHECK_EQUAL(TINY_SUCCESS, tiny_fd_send_packet(peers[i][0].handle, txbuf, sizeof(txbuf), 1000));
+        }
+    }
+    for ( int t = 0; t < 1000; t++ )
+    {
+        bool done = true;
+        for ( int i = 0; i < links; i++ )
+        {
+            done = done && peers[i][1].rx_count == 50;
+        }
+        if ( done )
+        {
+            break;
+        }
+        tiny_sleep(1);
+    }
+    reactor.stop();
+    thread.join();
+    for ( int i = 0; i < links; i++ )
+    {
+        CHECK_EQUAL(50, peers[i][1].rx_count.load());
+        CHECK_TRUE(peers[i][0].connected.load());
+        reactor.remove(peers[i][0].handle);
+        close(fds[i][0]);
+        close(fds[i][1]);
+    }
+    CHECK_EQUAL(links, reactor.size());
+}
+
+TEST(REACTOR, closed_peer_removes_link)
+{
+    ReactorPeer peer;
+    int fds[2];
+    tinyproto::FdReactor reactor;
+    CHECK_EQUAL(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+    CHECK_EQUAL(TINY_SUCCESS, peer.init());
+    CHECK_TRUE(reactor.add(peer.handle, fds[0]));
+    // Half-closed socket stays readable forever, and read() returns 0
+    shutdown(fds[1], SHUT_WR);
+    for ( int i = 0; i < 10 && reactor.size() != 0; i++ )
+    {
+        reactor.runOnce(10);
+    }
+    CHECK_EQUAL(0, reactor.size());
+    close(fds[0]);
+    close(fds[1]);
+}
+
+TEST(REACTOR, group_shards_links)
+{
+    ReactorPeer peers[2];
+    int fds[2];
+    tinyproto::FdReactorGroup group(2);
+    CHECK_EQUAL(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+    CHECK_EQUAL(TINY_SUCCESS, peers[0].init());
+    CHECK_EQUAL(TINY_SUCCESS, peers[1].init());
+    CHECK_TRUE(group.add(peers[0].handle, fds[0]));
+    CHECK_TRUE(group.add(peers[1].handle, fds[1]));
+    group.begin();
+    uint8_t txbuf[4] = {0xAA, 0xFF, 0xCC, 0x66};
+    for ( int n = 0; n < 20; n++ )
+    {
+        CHECK_EQUAL(TINY_SUCCESS, tiny_fd_send_packet(peers[1].handle, txbuf, sizeof(txbuf), 1000));
+    }
+    for ( int t = 0; t < 1000 && peers[0].rx_count != 20; t++ )
+    {
+        tiny_sleep(1);
+    }
+    group.end();
+    CHECK_EQUAL(20, peers[0].rx_count.load());
+    close(fds[0]);
+    close(fds[1]);
+}
+
+#endif
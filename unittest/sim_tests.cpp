@@ -0,0 +1,201 @@
+/*
+    Copyright 2022 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    GNU General Public License Usage
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Commercial License Usage
+
+    Licensees holding valid commercial Tiny Protocol licenses may use this file in
+    accordance with the commercial license agreement provided in accordance with
+    the terms contained in a written agreement between you and Alexey Dynda.
+    For further information contact via email on github account.
+*/
+
+#include <CppUTest/TestHarness.h>
+#include <string.h>
+#include <vector>
+#include "sim_channel.h"
+#include "proto/fd/tiny_fd.h"
+
+struct SimPeer
+{
+    tiny_fd_handle_t handle = nullptr;
+    SimChannel *tx = nullptr;
+    SimChannel *rx = nullptr;
+    uint64_t received = 0;
+    std::vector<uint8_t> buffer;
+};
+
+struct SimResult
+{
+    uint64_t received;
+    uint64_t sent;
+    uint64_t corrupted;
+    int mtu; ///< payload size, used by the sender at the end of the test
+};
+
+/**
+ * Runs the same test as tiny_loopback -r: one side sends frames of mtu size as fast as possible.
+ * In adaptive mode the data is sent via tiny_fd_send(), which splits it into frames of adaptive size.
+ */
+static SimResult runFdTransfer(const SimChannelConfig &config, uint32_t seconds, int mtu, hdlc_crc_t crc,
+                               bool adaptive = false)
+{
+    SimClock clock;
+    SimChannel ab(config);
+    SimChannel ba(config);
+    SimPeer peers[2];
+    peers[0].tx = &ab;
+    peers[0].rx = &ba;
+    peers[1].tx = &ba;
+    peers[1].rx = &ab;
+    for ( auto &peer : peers )
+    {
+        tiny_fd_init_t init{};
+        init.pdata = &peer;
+        init.on_read_cb = [](void *udata, uint8_t addr, uint8_t *buf, int len) -> void {
+            static_cast<SimPeer *>(udata)->received += len;
+        };
+        init.window_frames = 7;
+        init.mtu = mtu;
+        init.crc_type = crc;
+        init.send_timeout = 0;
+        init.retry_timeout = 100;
+        init.retries = 3;
+        init.adaptive = adaptive;
+        peer.buffer.resize(tiny_fd_buffer_size_by_mtu_ex(1, mtu, init.window_frames, crc, 1));
+        init.buffer = peer.buffer.data();
+        init.buffer_size = static_cast<int>(peer.buffer.size());
+        CHECK_EQUAL(TINY_SUCCESS, tiny_fd_init(&peer.handle, &init));
+    }
+    std::vector<uint8_t> payload(mtu);
+    for ( int i = 0; i < mtu; i++ )
+    {
+        payload[i] = static_cast<uint8_t>(i);
+    }
+    const uint64_t end = SimClock::now() + seconds * 1000000000ULL;
+    while ( SimClock::now() < end )
+    {
+        if ( adaptive )
+        {
+            while ( tiny_fd_send(peers[0].handle, payload.data(), mtu, 0) == mtu )
+            {
+            }
+        }
+        else
+        {
+            while ( tiny_fd_send_packet(peers[0].handle, payload.data(), mtu, 0) == TINY_SUCCESS )
+            {
+            }
+        }
+        for ( auto &peer : peers )
+        {
+            uint8_t buf[256];
+            int len;
+            while ( (len = peer.tx->writable()) > 0 &&
+                    (len = tiny_fd_get_tx_data(peer.handle, buf, len < (int)sizeof(buf) ? len : (int)sizeof(buf), 0)) > 0 )
+            {
+                peer.tx->write(buf, len);
+            }
+            while ( (len = peer.rx->read(buf, sizeof(buf))) > 0 )
+            {
+                tiny_fd_on_rx_data(peer.handle, buf, len);
+            }
+        }
+        // Process the line in 50us slices, and skip idle time up to the next byte arrival
+        uint64_t next = ab.nextArrival() < ba.nextArrival() ? ab.nextArrival() : ba.nextArrival();
+        uint64_t slice = SimClock::now() + 50000;
+        uint64_t idle = SimClock::now() + 1000000;
+        SimClock::advanceTo(next < slice ? slice : (next < idle ? next : idle));
+    }
+    SimResult result{peers[1].received, ab.sentBytes(), ab.corruptedBytes() + ba.corruptedBytes(), mtu};
+    tiny_fd_get_adaptive_params(peers[0].handle, TINY_FD_PRIMARY_ADDR, &result.mtu, nullptr);
+    for ( auto &peer : peers )
+    {
+        tiny_fd_close(peer.handle);
+    }
+    return result;
+}
+
+TEST_GROUP(SIM){void setup(){} void teardown(){}};
+
+TEST(SIM, virtual_clock)
+{
+    uint32_t ms;
+    {
+        SimClock clock;
+        ms = tiny_millis();
+        SimClock::advanceTo(SimClock::now() + 15000000000ULL);
+        CHECK_EQUAL(15000u, tiny_millis() - ms);
+    }
+    // System clock is used again
+    CHECK(tiny_millis() - ms != 15000u);
+}
+
+TEST(SIM, fd_speed_test_at_12_mbaud)
+{
+    SimChannelConfig config;
+    config.baudrate = 12000000;
+    config.delayUs = 50;
+    config.txBuffer = 4096;
+    config.rxBuffer = 4096;
+    SimResult result = runFdTransfer(config, 15, 64, HDLC_CRC_16);
+    // 12 Mbaud is 1.2 MB/s on the line, and 64 bytes of payload take about 70 bytes in the frame
+    CHECK(result.received > 15 * 1200000ULL * 80 / 100);
+    CHECK(result.received < 15 * 1200000ULL * 64 / 69);
+    CHECK_EQUAL(0, result.corrupted);
+}
+
+TEST(SIM, fd_transfer_with_errors_is_reproducible)
+{
+    SimChannelConfig config;
+    config.baudrate = 1000000;
+    config.bitErrorRate = 1e-5;
+    config.burstRate = 1e-4;
+    config.burstLength = 4;
+    config.seed = 7;
+    SimResult first = runFdTransfer(config, 2, 128, HDLC_CRC_32);
+    SimResult second = runFdTransfer(config, 2, 128, HDLC_CRC_32);
+    CHECK(first.corrupted > 0);
+    CHECK(first.received > 0);
+    CHECK_EQUAL(first.corrupted, second.corrupted);
+    CHECK_EQUAL(first.received, second.received);
+}
+
+TEST(SIM, fd_adaptive_mtu_on_noisy_line)
+{
+    SimChannelConfig config;
+    config.baudrate = 1000000;
+    config.bitErrorRate = 1e-4;
+    config.seed = 11;
+    SimResult fixed = runFdTransfer(config, 5, 512, HDLC_CRC_32);
+    SimResult adaptive = runFdTransfer(config, 5, 512, HDLC_CRC_32, true);
+    CHECK_EQUAL(512, fixed.mtu);
+    CHECK(adaptive.mtu < 512);
+    CHECK(adaptive.received > fixed.received);
+}
+
+TEST(SIM, fd_adaptive_mtu_keeps_max_on_clean_line)
+{
+    SimChannelConfig config;
+    config.baudrate = 1000000;
+    SimResult fixed = runFdTransfer(config, 2, 128, HDLC_CRC_16);
+    SimResult adaptive = runFdTransfer(config, 2, 128, HDLC_CRC_16, true);
+    CHECK_EQUAL(128, adaptive.mtu);
+    CHECK(adaptive.received > fixed.received * 95 / 100);
+}
@@ -0,0 +1,144 @@
+/*
+    Copyright 2022 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    GNU General Public License Usage
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Commercial License Usage
+
+    Licensees holding valid commercial Tiny Protocol licenses may use this file in
+    accordance with the commercial license agreement provided in accordance with
+    the terms contained in a written agreement between you and Alexey Dynda.
+    For further information contact via email on github account.
+*/
+
+#include <CppUTest/TestHarness.h>
+#include <vector>
+#include "hal/tiny_timer_wheel.h"
+
+TEST_GROUP(TIMER_WHEEL)
+{
+    void setup()
+    {
+    }
+
+    void teardown()
+    {
+    }
+};
+
+static void onExpired(void *arg)
+{
+    static_cast<std::vector<uint32_t> *>(arg)->push_back(0);
+}
+
+struct TestTimer
+{
+    tiny_timer_t timer;
+    tiny_timer_wheel_t *wheel;
+    uint32_t expiredAt = 0;
+    int count = 0;
+    uint32_t period = 0;
+};
+
+static void onTestTimer(void *arg)
+{
+    TestTimer *t = static_cast<TestTimer *>(arg);
+    t->expiredAt = t->wheel->now - 1;
+    t->count++;
+    if ( t->period )
+    {
+        tiny_timer_start(t->wheel, &t->timer, t->expiredAt + t->period);
+    }
+}
+
+TEST(TIMER_WHEEL, expires_at_exact_tick)
+{
+    tiny_timer_wheel_t wheel;
+    tiny_timer_wheel_init(&wheel, 1000);
+    // Check all levels: short, medium and long timeouts
+    const uint32_t timeouts[] = {0, 1, 63, 64, 65, 4095, 4096, 5000, 300000, 70000000};
+    TestTimer timers[sizeof(timeouts) / sizeof(timeouts[0])];
+    for ( size_t i = 0; i < sizeof(timeouts) / sizeof(timeouts[0]); i++ )
+    {
+        timers[i].wheel = &wheel;
+        tiny_timer_init(&timers[i].timer, onTestTimer, &timers[i]);
+        tiny_timer_start(&wheel, &timers[i].timer, 1000 + timeouts[i]);
+        CHECK_EQUAL(1, tiny_timer_is_active(&timers[i].timer));
+    }
+    for ( uint32_t now = 1000; now <= 1000 + 300000; now += 7 )
+    {
+        tiny_timer_wheel_advance(&wheel, now);
+    }
+    tiny_timer_wheel_advance(&wheel, 1000 + 70000000);
+    for ( size_t i = 0; i < sizeof(timeouts) / sizeof(timeouts[0]); i++ )
+    {
+        CHECK_EQUAL(1, timers[i].count);
+        CHECK_EQUAL(1000 + timeouts[i], timers[i].expiredAt);
+        CHECK_EQUAL(0, tiny_timer_is_active(&timers[i].timer));
+    }
+    CHECK_EQUAL(0xFFFFFFFF, tiny_timer_wheel_next_expiry(&wheel));
+}
+
+TEST(TIMER_WHEEL, stop_and_restart)
+{
+    tiny_timer_wheel_t wheel;
+    std::vector<uint32_t> expired;
+    tiny_timer_t timer1;
+    tiny_timer_t timer2;
+    tiny_timer_wheel_init(&wheel, 0xFFFFFF00);
+    tiny_timer_init(&timer1, onExpired, &expired);
+    tiny_timer_init(&timer2, onExpired, &expired);
+    // Stopping not started timer is allowed
+    tiny_timer_stop(&wheel, &timer1);
+    tiny_timer_start(&wheel, &timer1, 0xFFFFFF00 + 100);
+    tiny_timer_start(&wheel, &timer2, 0xFFFFFF00 + 100);
+    tiny_timer_stop(&wheel, &timer1);
+    // Restart moves the timer across 32-bit clock wrap-around
+    tiny_timer_start(&wheel, &timer2, 0xFFFFFF00 + 400);
+    CHECK_EQUAL(0, tiny_timer_wheel_advance(&wheel, 0xFFFFFF00 + 399));
+    CHECK_EQUAL(0, (int)expired.size());
+    CHECK_EQUAL(1, tiny_timer_wheel_advance(&wheel, 0xFFFFFF00 + 400));
+    CHECK_EQUAL(1, (int)expired.size());
+}
+
+TEST(TIMER_WHEEL, periodic_timers_of_many_peers)
+{
+    tiny_timer_wheel_t wheel;
+    tiny_timer_wheel_init(&wheel, 0);
+    std::vector<TestTimer> timers(2000);
+    for ( size_t i = 0; i < timers.size(); i++ )
+    {
+        timers[i].wheel = &wheel;
+        timers[i].period = 100 + (uint32_t)i % 500;
+        tiny_timer_init(&timers[i].timer, onTestTimer, &timers[i]);
+        tiny_timer_start(&wheel, &timers[i].timer, timers[i].period);
+    }
+    uint32_t now = 0;
+    while ( now < 10000 )
+    {
+        // Sleep exactly until the next expiration like the reactor does
+        uint32_t next = tiny_timer_wheel_next_expiry(&wheel);
+        CHECK(next >= 1 && next <= TINY_TIMER_WHEEL_SIZE);
+        now = wheel.now - 1 + next;
+        tiny_timer_wheel_advance(&wheel, now);
+    }
+    for ( auto &t: timers )
+    {
+        CHECK_EQUAL(10000 / t.period, t.count);
+    }
+}
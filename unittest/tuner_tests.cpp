@@ -0,0 +1,146 @@
+/*
+    Copyright 2022 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    GNU General Public License Usage
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Commercial License Usage
+
+    Licensees holding valid commercial Tiny Protocol licenses may use this file in
+    accordance with the commercial license agreement provided in accordance with
+    the terms contained in a written agreement between you and Alexey Dynda.
+    For further information contact via email on github account.
+*/
+
+#include <CppUTest/TestHarness.h>
+#include "sim_probe.h"
+#include "TinyLinkTuner.h"
+
+using namespace tinyproto;
+
+/** Fake link: goodput grows with mtu and window, latency grows with mtu */
+static bool fakeProbe(void *arg, const LinkTunerParams &params, LinkTunerResult &result)
+{
+    int *probes = static_cast<int *>(arg);
+    (*probes)++;
+    result.goodput = params.mtu * params.window;
+    result.latencyP99 = params.mtu * 10 + 1000 / params.window;
+    return true;
+}
+
+static bool flatProbe(void *arg, const LinkTunerParams &params, LinkTunerResult &result)
+{
+    result.goodput = 10000;
+    result.latencyP99 = 1000;
+    return true;
+}
+
+TEST_GROUP(TUNER){void setup(){} void teardown(){}};
+
+TEST(TUNER, best_goodput_is_selected)
+{
+    static const int mtus[] = {32, 64};
+    static const uint8_t windows[] = {2, 4};
+    static const hdlc_crc_t crcs[] = {HDLC_CRC_16};
+    int probes = 0;
+    LinkTuner tuner(fakeProbe, &probes);
+    tuner.setMtus(mtus, 2);
+    tuner.setWindows(windows, 2);
+    tuner.setCrcs(crcs, 1);
+    CHECK_EQUAL(4, tuner.run());
+    CHECK_EQUAL(4, probes);
+    CHECK(tuner.getBest().valid);
+    CHECK_EQUAL(64, tuner.getBest().params.mtu);
+    CHECK_EQUAL(4, tuner.getBest().params.window);
+    CHECK_EQUAL(tiny_fd_buffer_size_by_mtu_ex(1, 64, 4, HDLC_CRC_16, 1), tuner.getBest().memory);
+    tiny_fd_init_t init{};
+    init.retry_timeout = 50;
+    tuner.apply(init);
+    CHECK_EQUAL(64, init.mtu);
+    CHECK_EQUAL(4, init.window_frames);
+    CHECK_EQUAL(HDLC_CRC_16, init.crc_type);
+    CHECK_EQUAL(50, init.retry_timeout);
+}
+
+TEST(TUNER, best_latency_is_selected)
+{
+    static const uint16_t timeouts[] = {100, 200};
+    int probes = 0;
+    LinkTuner tuner(fakeProbe, &probes);
+    tuner.setRetryTimeouts(timeouts, 2);
+    tuner.setGoal(LinkTunerGoal::LATENCY);
+    CHECK_EQUAL(5 * 6 * 3 * 2, tuner.run());
+    CHECK_EQUAL(32, tuner.getBest().params.mtu);
+    CHECK_EQUAL(7, tuner.getBest().params.window);
+    tiny_fd_init_t init{};
+    tuner.apply(init);
+    CHECK(init.retry_timeout == 100 || init.retry_timeout == 200);
+}
+
+TEST(TUNER, equal_results_prefer_smaller_buffer)
+{
+    LinkTuner tuner(flatProbe, nullptr);
+    CHECK(tuner.run() > 0);
+    LinkTunerParams smallest{32, 2, HDLC_CRC_8, 0};
+    CHECK_EQUAL(tuner.getMemorySize(smallest), tuner.getBest().memory);
+    CHECK_EQUAL(32, tuner.getBest().params.mtu);
+    CHECK_EQUAL(2, tuner.getBest().params.window);
+}
+
+TEST(TUNER, memory_limit_skips_candidates)
+{
+    static int skipped;
+    static int limit;
+    int probes = 0;
+    LinkTuner tuner(fakeProbe, &probes);
+    LinkTunerParams params{128, 4, HDLC_CRC_16, 0};
+    limit = tuner.getMemorySize(params);
+    skipped = 0;
+    tuner.setMemoryLimit(limit);
+    tuner.setResultCallback([](void *arg, const LinkTunerResult &result) {
+        if ( !result.valid )
+        {
+            CHECK(result.memory > limit);
+            skipped++;
+        }
+    });
+    int valid = tuner.run();
+    CHECK(skipped > 0);
+    CHECK_EQUAL(5 * 6 * 3, valid + skipped);
+    CHECK_EQUAL(valid, probes);
+    CHECK(tuner.getBest().memory <= limit);
+}
+
+TEST(TUNER, simulated_link_prefers_large_frames)
+{
+    static const int mtus[] = {16, 128};
+    static const uint8_t windows[] = {2, 7};
+    static const hdlc_crc_t crcs[] = {HDLC_CRC_16};
+    SimProbeConfig config;
+    config.channel.baudrate = 115200;
+    config.durationMs = 1000;
+    LinkTuner tuner(simProbe, &config);
+    tuner.setMtus(mtus, 2);
+    tuner.setWindows(windows, 2);
+    tuner.setCrcs(crcs, 1);
+    CHECK_EQUAL(4, tuner.run());
+    CHECK_EQUAL(128, tuner.getBest().params.mtu);
+    // 115200 baud is 11520 bytes per second on the line
+    CHECK(tuner.getBest().goodput > 11520 * 80 / 100);
+    CHECK(tuner.getBest().goodput < 11520);
+    CHECK(tuner.getBest().latencyP99 > 0);
+}